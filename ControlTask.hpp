@@ -0,0 +1,80 @@
+#pragma once
+#ifndef CONTROL_TASK_HPP
+#define CONTROL_TASK_HPP
+
+#include <cmath>
+#include <cstdint>
+
+// Scheduling and change detection for the firmware's control loop,
+// kept free of libDaisy so the host can test them.
+//
+// The main loop polls a RateTimer per task against a free-running
+// counter (the DWT cycle counter on the module) rather than spinning
+// through every task on every pass. Readings go through a KnobFilter,
+// which smooths them and holds the result until it moves by more than
+// a threshold, so a resting knob reports no change and nothing
+// downstream is recomputed or published.
+
+// Fires at a fixed rate off a wrapping 32-bit counter
+class RateTimer {
+public:
+    // rate ticks per second from a counter running at clockRate; the
+    // first tick is due at once
+    void Init(float rate, uint32_t clockRate, uint32_t now) {
+        float period = static_cast<float>(clockRate) / rate;
+        period_ = (period >= 1.0f) ? static_cast<uint32_t>(period) : 1;
+        next_ = now;
+    }
+
+    // Whether a tick is due at now. Ticks keep to the schedule when the
+    // loop is a little late; one missed by a whole period or more is
+    // dropped, so a stall does not make the ticks after it bunch up.
+    bool Due(uint32_t now) {
+        int32_t late = static_cast<int32_t>(now - next_);
+        if (late < 0) {
+            return false;
+        }
+        next_ = (static_cast<uint32_t>(late) >= period_) ? now + period_ : next_ + period_;
+        return true;
+    }
+
+    uint32_t GetPeriod() const { return period_; }
+
+private:
+    uint32_t period_ = 1;
+    uint32_t next_ = 0;
+};
+
+// One-pole smoothing of a reading followed by hysteresis
+class KnobFilter {
+public:
+    // smoothing is the share of each new reading (0.0 to 1.0, 1.0 for
+    // none); the held value follows once the smoothed one is more than
+    // threshold away from it
+    void Init(float smoothing, float threshold, float value = 0.0f) {
+        smoothing_ = smoothing;
+        threshold_ = threshold;
+        smoothed_ = value;
+        held_ = value;
+    }
+
+    // Take a reading; returns true when the held value moved
+    bool Process(float reading) {
+        smoothed_ += (reading - smoothed_) * smoothing_;
+        if (fabsf(smoothed_ - held_) <= threshold_) {
+            return false;
+        }
+        held_ = smoothed_;
+        return true;
+    }
+
+    float Value() const { return held_; }
+
+private:
+    float smoothing_ = 1.0f;
+    float threshold_ = 0.0f;
+    float smoothed_ = 0.0f;
+    float held_ = 0.0f;
+};
+
+#endif // CONTROL_TASK_HPP
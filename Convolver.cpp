@@ -0,0 +1,349 @@
+#include "Convolver.hpp"
+#include "PulsarSimd.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// index with its low bits bits reversed; branch-free, as it runs once
+// per sample
+inline size_t Reverse(size_t index, int bits) {
+    uint32_t v = static_cast<uint32_t>(index);
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    v = (v >> 16) | (v << 16);
+    return v >> (32 - bits);
+}
+
+// In-place radix-2 complex FFT of n points held as split real and
+// imaginary arrays, taking its input in bit-reversed order (callers
+// scatter into it rather than swap afterwards) and giving its output in
+// natural order; sign -1.0 for the forward transform, +1.0 for the
+// (unscaled) inverse. The tables hold each stage's twiddles in order,
+// cos and sin of pi k / half at [half + k], so that stages of
+// simd::WIDTH or more butterflies per group run a vector at a time.
+void ComplexFft(float* re, float* im, size_t n, const float* cosTable,
+                const float* sinTable, float sign) {
+    // The first two stages need no multiplies: their twiddles are 1 and
+    // -i (forward) or +i (inverse)
+    for (size_t start = 0; start < n; start += 4) {
+        float* r = re + start;
+        float* i = im + start;
+        const float r0 = r[0] + r[1];
+        const float i0 = i[0] + i[1];
+        const float r1 = r[0] - r[1];
+        const float i1 = i[0] - i[1];
+        const float r2 = r[2] + r[3];
+        const float i2 = i[2] + i[3];
+        const float r3 = r[2] - r[3];
+        const float i3 = i[2] - i[3];
+        // (r3, i3) times -i sign
+        const float tr = -sign * i3;
+        const float ti = sign * r3;
+        r[0] = r0 + r2;
+        i[0] = i0 + i2;
+        r[2] = r0 - r2;
+        i[2] = i0 - i2;
+        r[1] = r1 + tr;
+        i[1] = i1 + ti;
+        r[3] = r1 - tr;
+        i[3] = i1 - ti;
+    }
+    const simd::Float signs = simd::Set1(sign);
+    for (size_t half = 4; half < n; half <<= 1) {
+        const float* cosines = cosTable + half;
+        const float* sines = sinTable + half;
+        for (size_t start = 0; start < n; start += 2 * half) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+            if (half >= simd::WIDTH) {
+                for (size_t k = 0; k < half; k += simd::WIDTH) {
+                    const simd::Float wr = simd::Load(cosines + k);
+                    const simd::Float wi = signs * simd::Load(sines + k);
+                    const simd::Float xr = simd::Load(br + k);
+                    const simd::Float xi = simd::Load(bi + k);
+                    const simd::Float tr = xr * wr - xi * wi;
+                    const simd::Float ti = xr * wi + xi * wr;
+                    const simd::Float yr = simd::Load(ar + k);
+                    const simd::Float yi = simd::Load(ai + k);
+                    simd::Store(br + k, yr - tr);
+                    simd::Store(bi + k, yi - ti);
+                    simd::Store(ar + k, yr + tr);
+                    simd::Store(ai + k, yi + ti);
+                }
+                continue;
+            }
+            for (size_t k = 0; k < half; ++k) {
+                const float wr = cosines[k];
+                const float wi = sign * sines[k];
+                const float tr = br[k] * wr - bi[k] * wi;
+                const float ti = br[k] * wi + bi[k] * wr;
+                br[k] = ar[k] - tr;
+                bi[k] = ai[k] - ti;
+                ar[k] += tr;
+                ai[k] += ti;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+float Convolver::NormalizingGain(const float* ir, size_t length) {
+    double energy = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        energy += static_cast<double>(ir[i]) * ir[i];
+    }
+    return energy > 0.0 ? static_cast<float>(1.0 / std::sqrt(energy)) : 1.0f;
+}
+
+bool Convolver::Init(size_t partitionSize, size_t maxPartitions, float* memory,
+                     size_t memorySize) {
+    partitionSize_ = 0;
+    maxPartitions_ = 0;
+    const bool powerOfTwo = (partitionSize & (partitionSize - 1)) == 0;
+    if (!powerOfTwo || partitionSize < MIN_PARTITION || partitionSize > MAX_PARTITION ||
+        maxPartitions == 0 || memory == nullptr ||
+        memorySize < MemorySize(partitionSize, maxPartitions)) {
+        return false;
+    }
+
+    const size_t b = partitionSize;
+    partitionSize_ = b;
+    maxPartitions_ = maxPartitions;
+    bins_ = b;
+    spectrum_ = 2 * b;
+    bits_ = 0;
+    while ((static_cast<size_t>(1) << bits_) < b) {
+        ++bits_;
+    }
+
+    const uintptr_t bytes = ALIGN * sizeof(float);
+    float* p = reinterpret_cast<float*>(
+        (reinterpret_cast<uintptr_t>(memory) + bytes - 1) & ~(bytes - 1));
+    auto take = [&p](size_t floats) {
+        float* region = p;
+        p += floats;
+        return region;
+    };
+    cosTable_ = take(b);
+    sinTable_ = take(b);
+    realCos_ = take(b);
+    realSin_ = take(b);
+    irSpectra_[0] = take(maxPartitions * spectrum_);
+    irSpectra_[1] = take(maxPartitions * spectrum_);
+    history_ = take(maxPartitions * spectrum_);
+    input_ = take(2 * b);
+    output_ = take(b);
+    sum_ = take(2 * b);
+    work_ = take(2 * b);
+
+    // The 2B-point real transform runs as a B-point complex one
+    const double pi = 3.14159265358979323846;
+    cosTable_[0] = 1.0f;
+    sinTable_[0] = 0.0f;
+    for (size_t half = 1; half < b; half <<= 1) {
+        for (size_t k = 0; k < half; ++k) {
+            double angle = pi * static_cast<double>(k) / static_cast<double>(half);
+            cosTable_[half + k] = static_cast<float>(std::cos(angle));
+            sinTable_[half + k] = static_cast<float>(std::sin(angle));
+        }
+    }
+    for (size_t k = 0; k < b; ++k) {
+        double angle = pi * static_cast<double>(k) / static_cast<double>(b);
+        realCos_[k] = static_cast<float>(std::cos(angle));
+        realSin_[k] = static_cast<float>(std::sin(angle));
+    }
+
+    partitions_[0] = 0;
+    partitions_[1] = 0;
+    active_.store(0);
+    pending_.store(0);
+    Reset();
+    return true;
+}
+
+void Convolver::Reset() {
+    if (partitionSize_ == 0) {
+        return;
+    }
+    std::memset(history_, 0, maxPartitions_ * spectrum_ * sizeof(float));
+    std::memset(input_, 0, 2 * partitionSize_ * sizeof(float));
+    std::memset(output_, 0, partitionSize_ * sizeof(float));
+    head_ = 0;
+    fill_ = 0;
+}
+
+void Convolver::Process(const float* in, float* out, size_t size) {
+    const size_t b = partitionSize_;
+    while (size > 0) {
+        size_t n = b - fill_;
+        n = (n < size) ? n : size;
+        // Input first, so that in and out may alias
+        std::memcpy(input_ + b + fill_, in, n * sizeof(float));
+        std::memcpy(out, output_ + fill_, n * sizeof(float));
+        in += n;
+        out += n;
+        size -= n;
+        fill_ += n;
+        if (fill_ == b) {
+            ProcessPartition();
+            fill_ = 0;
+        }
+    }
+}
+
+bool Convolver::SetImpulseResponse(const float* ir, size_t length, float gain) {
+    if (partitionSize_ == 0) {
+        return false;
+    }
+    const int playing = active_.load(std::memory_order_acquire);
+    if (pending_.load(std::memory_order_relaxed) != playing) {
+        return false;
+    }
+    const int target = 1 - playing;
+    const size_t b = partitionSize_;
+    size_t partitions = (length + b - 1) / b;
+    partitions = (partitions < maxPartitions_) ? partitions : maxPartitions_;
+
+    // Folding 1 / 2B into the impulse response leaves the inverse
+    // transform unscaled
+    const float scale = gain / static_cast<float>(2 * b);
+    for (size_t part = 0; part < partitions; ++part) {
+        float* re = irSpectra_[target] + part * spectrum_;
+        float* im = re + bins_;
+        const size_t first = part * b;
+        for (size_t n = 0; n < bins_; ++n) {
+            size_t r = Reverse(n, bits_);
+            size_t even = first + 2 * n;
+            bool inside = 2 * n < b;
+            re[r] = (inside && even < length) ? ir[even] * scale : 0.0f;
+            im[r] = (inside && even + 1 < length) ? ir[even + 1] * scale : 0.0f;
+        }
+        ForwardSplit(re, im);
+    }
+    partitions_[target] = partitions;
+    pending_.store(target, std::memory_order_release);
+    return true;
+}
+
+void Convolver::ForwardSplit(float* re, float* im) const {
+    // Even samples in re and odd in im make one B-point complex
+    // transform; untangle it into the 2B-point real spectrum
+    const size_t m = bins_;
+    ComplexFft(re, im, m, cosTable_, sinTable_, -1.0f);
+    const float even = re[0];
+    const float odd = im[0];
+    re[0] = even + odd;
+    im[0] = even - odd;
+    for (size_t k = 1; k <= m / 2; ++k) {
+        const size_t j = m - k;
+        const float evenRe = 0.5f * (re[k] + re[j]);
+        const float evenIm = 0.5f * (im[k] - im[j]);
+        const float oddRe = 0.5f * (im[k] + im[j]);
+        const float oddIm = -0.5f * (re[k] - re[j]);
+        const float c = realCos_[k];
+        const float s = realSin_[k];
+        const float tr = c * oddRe + s * oddIm;
+        const float ti = c * oddIm - s * oddRe;
+        re[k] = evenRe + tr;
+        im[k] = evenIm + ti;
+        re[j] = evenRe - tr;
+        im[j] = ti - evenIm;
+    }
+}
+
+void Convolver::InverseSplit(float* re, float* im, float* outRe, float* outIm) const {
+    // The reverse untangling, then one B-point inverse; scaled by 2B
+    const size_t m = bins_;
+    const float dc = re[0];
+    const float nyquist = im[0];
+    re[0] = dc + nyquist;
+    im[0] = dc - nyquist;
+    for (size_t k = 1; k <= m / 2; ++k) {
+        const size_t j = m - k;
+        const float evenRe = re[k] + re[j];
+        const float evenIm = im[k] - im[j];
+        const float dr = re[k] - re[j];
+        const float di = im[k] + im[j];
+        const float c = realCos_[k];
+        const float s = realSin_[k];
+        const float oddRe = dr * c - di * s;
+        const float oddIm = dr * s + di * c;
+        re[k] = evenRe - oddIm;
+        im[k] = evenIm + oddRe;
+        re[j] = evenRe + oddIm;
+        im[j] = oddRe - evenIm;
+    }
+    for (size_t k = 0; k < m; ++k) {
+        size_t r = Reverse(k, bits_);
+        outRe[r] = re[k];
+        outIm[r] = im[k];
+    }
+    ComplexFft(outRe, outIm, m, cosTable_, sinTable_, 1.0f);
+}
+
+void Convolver::ProcessPartition() {
+    const size_t b = partitionSize_;
+    const int pending = pending_.load(std::memory_order_acquire);
+    if (pending != active_.load(std::memory_order_relaxed)) {
+        active_.store(pending, std::memory_order_release);
+    }
+
+    // Newest input spectrum into the history
+    head_ = (head_ + 1 < maxPartitions_) ? head_ + 1 : 0;
+    float* newest = history_ + head_ * spectrum_;
+    for (size_t n = 0; n < bins_; ++n) {
+        size_t r = Reverse(n, bits_);
+        newest[r] = input_[2 * n];
+        newest[bins_ + r] = input_[2 * n + 1];
+    }
+    ForwardSplit(newest, newest + bins_);
+    std::memcpy(input_, input_ + b, b * sizeof(float));
+
+    const size_t partitions = partitions_[pending];
+    if (partitions == 0) {
+        std::memset(output_, 0, b * sizeof(float));
+        return;
+    }
+
+    // Multiply-accumulate every partition against the input spectrum
+    // of its age. Bin 0 packs DC and Nyquist, which multiply as two
+    // reals, so it is redone on its own after the vector pass.
+    const float* ir = irSpectra_[pending];
+    std::memset(sum_, 0, spectrum_ * sizeof(float));
+    float dc = 0.0f;
+    float nyquist = 0.0f;
+    size_t age = head_;
+    for (size_t part = 0; part < partitions; ++part) {
+        const float* x = history_ + age * spectrum_;
+        const float* h = ir + part * spectrum_;
+        for (size_t n = 0; n < bins_; n += simd::WIDTH) {
+            simd::Float xr = simd::Load(x + n);
+            simd::Float xi = simd::Load(x + bins_ + n);
+            simd::Float hr = simd::Load(h + n);
+            simd::Float hi = simd::Load(h + bins_ + n);
+            simd::Float sr = simd::Load(sum_ + n);
+            simd::Float si = simd::Load(sum_ + bins_ + n);
+            simd::Store(sum_ + n, sr + (xr * hr - xi * hi));
+            simd::Store(sum_ + bins_ + n, si + (xr * hi + xi * hr));
+        }
+        dc += x[0] * h[0];
+        nyquist += x[bins_] * h[bins_];
+        age = (age > 0) ? age - 1 : maxPartitions_ - 1;
+    }
+    sum_[0] = dc;
+    sum_[bins_] = nyquist;
+
+    // Overlap-save: the second half of the inverse is the new output
+    InverseSplit(sum_, sum_ + bins_, work_, work_ + bins_);
+    for (size_t n = bins_ / 2; n < bins_; ++n) {
+        output_[2 * n - b] = work_[n];
+        output_[2 * n + 1 - b] = work_[bins_ + n];
+    }
+}
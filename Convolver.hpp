@@ -0,0 +1,123 @@
+#pragma once
+#ifndef CONVOLVER_HPP
+#define CONVOLVER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// Uniformly partitioned FFT convolution (overlap-save), for convolving
+// the pulsar train with a sampled impulse response.
+//
+// The impulse response is cut into partitions of B samples, each kept
+// as the spectrum of a 2B-point real FFT. Every B input samples one
+// forward FFT adds the newest block to a delay line of spectra, which
+// is multiplied bin by bin against the partitions (simd::WIDTH bins at a
+// time), and one inverse FFT yields the next B output samples. Latency
+// is fixed at B samples; the work per block is the same whether Process
+// is called with one sample or many, and lands on the call that
+// completes a block, so B should not exceed the audio block size where
+// load spikes matter.
+//
+// Nothing is allocated: Init lays everything out in caller memory of
+// MemorySize() floats. Room is kept for two impulse responses, so a new
+// one can be loaded on another thread while the current one plays; the
+// swap happens at the next block boundary.
+class Convolver {
+public:
+    static constexpr size_t MIN_PARTITION = 16;
+    static constexpr size_t MAX_PARTITION = 4096;
+
+    // Every region of the memory starts on a simd::Float boundary; 32
+    // bytes covers all backends
+    static constexpr size_t ALIGN = 8;
+
+    // Floats of memory Init needs for partitions of partitionSize samples
+    // (a power of two, MIN_PARTITION to MAX_PARTITION) and impulse
+    // responses of up to maxPartitions partitions
+    static constexpr size_t MemorySize(size_t partitionSize, size_t maxPartitions) {
+        return ALIGN +                                  // aligning the base
+               4 * partitionSize +                      // twiddle tables
+               3 * maxPartitions * 2 * partitionSize +  // two impulse responses, history_
+               7 * partitionSize;                       // input_, output_, sum_, work_
+    }
+
+    // Gain that brings an impulse response to unit energy, or 1.0 for a
+    // silent one
+    static float NormalizingGain(const float* ir, size_t length);
+
+    Convolver() = default;
+    Convolver(const Convolver&) = delete;
+    Convolver& operator=(const Convolver&) = delete;
+
+    // Lay out memory of memorySize floats; returns false, and leaves the
+    // convolver unusable, for a bad partition size or too little memory.
+    // Starts with no impulse response, which outputs silence.
+    bool Init(size_t partitionSize, size_t maxPartitions, float* memory,
+              size_t memorySize);
+
+    // Clear the signal history; the impulse response stays
+    void Reset();
+
+    // Convolve size samples; in and out may be the same buffer
+    void Process(const float* in, float* out, size_t size);
+
+    // Transform length samples of ir, times gain, for use from the next
+    // block boundary. Samples past maxPartitions partitions are dropped.
+    // Returns false, changing nothing, while the previous impulse
+    // response has yet to be taken up by Process. Not to be called
+    // concurrently with itself.
+    bool SetImpulseResponse(const float* ir, size_t length, float gain = 1.0f);
+
+    size_t GetLatency() const { return partitionSize_; }
+    size_t GetPartitionSize() const { return partitionSize_; }
+    size_t GetMaxPartitions() const { return maxPartitions_; }
+
+    // Partitions of the impulse response playing now
+    size_t GetPartitionCount() const { return partitions_[active_.load()]; }
+
+private:
+    // Convolve the completed input block into output_
+    void ProcessPartition();
+
+    // 2B-point real transforms between B even/odd sample pairs (re
+    // holding the even samples, im the odd) and B bins, DC and Nyquist
+    // in bin 0's real and imaginary parts. The forward transform takes
+    // the pairs in bit-reversed order and works in place; the inverse
+    // leaves the pairs in outRe and outIm, scaled by 2B.
+    void ForwardSplit(float* re, float* im) const;
+    void InverseSplit(float* re, float* im, float* outRe, float* outIm) const;
+
+    size_t partitionSize_ = 0;
+    size_t maxPartitions_ = 0;
+    size_t bins_ = 0;      // partitionSize_; DC and Nyquist share bin 0
+    size_t spectrum_ = 0;  // Floats per spectrum, split real then imaginary
+    int bits_ = 0;         // log2(bins_)
+
+    // Twiddles for the half-size complex transform, stage by stage, and
+    // for the real transform's split step
+    float* cosTable_ = nullptr;
+    float* sinTable_ = nullptr;
+    float* realCos_ = nullptr;
+    float* realSin_ = nullptr;
+
+    // Two impulse responses, partition spectra in order. Process plays
+    // active_ and moves it to pending_ when they differ.
+    float* irSpectra_[2] = {nullptr, nullptr};
+    size_t partitions_[2] = {0, 0};
+    std::atomic<int> active_{0};
+    std::atomic<int> pending_{0};
+
+    // Input spectra, newest at head_ and older ones before it (wrapping)
+    float* history_ = nullptr;
+    size_t head_ = 0;
+
+    // Previous and current input blocks, the output block being read
+    // out, the accumulated spectrum and the inverse transform
+    float* input_ = nullptr;
+    float* output_ = nullptr;
+    float* sum_ = nullptr;
+    float* work_ = nullptr;
+    size_t fill_ = 0;
+};
+
+#endif // CONVOLVER_HPP
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef DAISY_HARDWARE_HPP
+#define DAISY_HARDWARE_HPP
+
+#include "daisy_versio.h"
+#include "LoadMonitor.hpp"
+#include "PulsarControls.hpp"
+#include "Settings.hpp"
+
+// The Versio panel, audio and QSPI flash through libDaisy, as the
+// Hardware of PulsarFirmware (see PulsarFirmware.hpp)
+class DaisyHardware {
+public:
+    typedef DwtClock Clock;
+
+    DaisyHardware() : storage_(hw_.seed.qspi) {}
+
+    void Init() {
+        hw_.Init();
+        hw_.SetAudioSampleRate(daisy::SaiHandle::Config::SampleRate::SAI_96KHZ);
+        hw_.StartAdc();
+    }
+
+    void StartAudio(daisy::AudioHandle::AudioCallback callback) { hw_.StartAudio(callback); }
+
+    float AudioSampleRate() { return hw_.AudioSampleRate(); }
+
+    // The DWT cycle counter, enabled by the load monitor's Init
+    uint32_t ClockRate() const { return daisy::System::GetSysClkFreq(); }
+    uint32_t Now() const { return Clock().Now(); }
+    uint32_t Millis() const { return daisy::System::GetNow(); }
+    void DelayMs(uint32_t ms) { daisy::System::Delay(ms); }
+
+    void ProcessControls() {
+        hw_.ProcessAllControls();
+        hw_.tap.Debounce();
+    }
+    float KnobValue(int k) { return hw_.GetKnobValue(k); }
+    float CvRaw() { return hw_.knobs[daisy::DaisyVersio::KNOB_0].GetRawValue(); }
+    SwitchPosition ReadSwitch(int index) {
+        int position = hw_.sw[index].Read();
+        if (position == daisy::Switch3::POS_LEFT) {
+            return SwitchPosition::LEFT;
+        } else if (position == daisy::Switch3::POS_CENTER) {
+            return SwitchPosition::CENTER;
+        }
+        return SwitchPosition::RIGHT;
+    }
+    bool Gate() { return hw_.Gate(); }
+
+    void DebounceTap() { hw_.tap.Debounce(); }
+    bool TapRisingEdge() { return hw_.tap.RisingEdge(); }
+    bool TapFallingEdge() { return hw_.tap.FallingEdge(); }
+    bool TapPressed() { return hw_.tap.Pressed(); }
+    bool TapRaw() { return hw_.tap.RawState(); }
+    float TapHeldMs() { return hw_.tap.TimeHeldMs(); }
+
+    void SetLed(int led, float r, float g, float b) { hw_.SetLed(led, r, g, b); }
+    void UpdateLeds() { hw_.UpdateLeds(); }
+
+    void InitSettings(const Settings& defaults) { storage_.Init(defaults); }
+    Settings& GetSettings() { return storage_.GetSettings(); }
+    void SaveSettings() { storage_.Save(); }
+    void RestoreDefaultSettings() { storage_.RestoreDefaults(); }
+
+private:
+    daisy::DaisyVersio hw_;
+    daisy::PersistentStorage<Settings> storage_;
+};
+
+#endif // DAISY_HARDWARE_HPP
@@ -0,0 +1,165 @@
+#pragma once
+#ifndef FAST_MATH_HPP
+#define FAST_MATH_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "PulsarSimd.hpp"
+
+// Polynomial sin and exp for the per-sample paths, in place of libm.
+//
+// Each function comes as a scalar float version and a simd::Float
+// version that give bit-identical results. The scalar ones are
+// branch-free (selects, sign-bit operations and truncating conversions;
+// no tables, no libm calls), which on the Cortex-M7 is VSEL, VABS and
+// VCVT. The maximum errors below are measured against double precision
+// over the whole stated domain by the accuracy sweep in host/test.cpp.
+//
+//   PULSAR_FAST_MATH  1  Sin2Pi, Exp and Exp2 use the approximations
+//                        (default)
+//                     0  they call sinf, expf and exp2f
+#ifndef PULSAR_FAST_MATH
+#define PULSAR_FAST_MATH 1
+#endif
+
+namespace fastmath {
+
+// Absolute error of FastSin2Pi, any finite x
+static constexpr float SIN_MAX_ERROR = 3.0e-7f;
+// Relative error of FastExp2, -126 <= x <= 127
+static constexpr float EXP2_MAX_ERROR = 2.5e-7f;
+// Relative error of FastExp, -87 <= x <= 88
+static constexpr float EXP_MAX_ERROR = 2.5e-7f;
+
+namespace detail {
+
+static constexpr float LOG2E = 1.442695041f;
+// ln 2 split so that n * LN2_HI is exact for the whole exponent range
+static constexpr float LN2_HI = 0.693145751953125f;
+static constexpr float LN2_LO = 1.428606765e-06f;
+
+template <typename T> T Splat(float c);
+template <> inline float Splat<float>(float c) { return c; }
+template <> inline simd::Float Splat<simd::Float>(float c) { return simd::Set1(c); }
+
+// sin(2 pi m) for -0.25 <= m <= 0.25, odd minimax fit
+template <typename T>
+inline T SinPoly(T m) {
+    T m2 = m * m;
+    return m * (Splat<T>(6.283185160e+00f) + m2 * (Splat<T>(-4.134165503e+01f) +
+                m2 * (Splat<T>(8.160100395e+01f) + m2 * (Splat<T>(-7.654977934e+01f) +
+                m2 * Splat<T>(3.953668217e+01f)))));
+}
+
+// 2^f for -0.5 <= f <= 0.5, minimax fit with 2^0 exactly 1
+template <typename T>
+inline T Exp2Poly(T f) {
+    return Splat<T>(1.0f) + f * (Splat<T>(6.931469776e-01f) + f * (Splat<T>(2.402224211e-01f) +
+                            f * (Splat<T>(5.550733760e-02f) + f * (Splat<T>(9.671510817e-03f) +
+                            f * Splat<T>(1.326471326e-03f)))));
+}
+
+// 2^(e - 127) for a biased exponent e, 1 <= e <= 254
+inline float Pow2Biased(int32_t e) {
+    uint32_t bits = static_cast<uint32_t>(e) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return scale;
+}
+
+}  // namespace detail
+
+// sin(2 pi x): x is in cycles, as pulsaret phases are
+inline float FastSin2Pi(float x) {
+    // Whole cycles off by rounding to nearest (all floats from 2^23 up
+    // are whole), leaving |r| <= 0.5; then sin(2 pi |r|) is symmetric
+    // about |r| = 0.25. Every step is exact.
+    x = (fabsf(x) < 8388608.0f) ? x : 0.0f;
+    float r = x - static_cast<float>(static_cast<int32_t>(x + copysignf(0.5f, x)));
+    float a = fabsf(r);
+    float b = 0.5f - a;
+    float m = (a < b) ? a : b;
+    return detail::SinPoly(m) * copysignf(1.0f, r);
+}
+
+// 2^x, saturating outside [-126, 127]
+inline float FastExp2(float x) {
+    x = (x > -126.0f) ? x : -126.0f;
+    x = (x < 127.0f) ? x : 127.0f;
+    // Biased exponent of the nearest power of two; the sum is positive,
+    // so truncation rounds down
+    int32_t e = static_cast<int32_t>(x + 127.5f);
+    float n = static_cast<float>(e) - 127.0f;
+    return detail::Exp2Poly(x - n) * detail::Pow2Biased(e);
+}
+
+// e^x, saturating outside [-87, 88]
+inline float FastExp(float x) {
+    x = (x > -87.0f) ? x : -87.0f;
+    x = (x < 88.0f) ? x : 88.0f;
+    int32_t e = static_cast<int32_t>(x * detail::LOG2E + 127.5f);
+    float n = static_cast<float>(e) - 127.0f;
+    float r = (x - n * detail::LN2_HI) - n * detail::LN2_LO;
+    return detail::Exp2Poly(r * detail::LOG2E) * detail::Pow2Biased(e);
+}
+
+// The same, simd::WIDTH lanes at a time
+inline simd::Float FastSin2Pi(simd::Float x) {
+    using namespace simd;
+    const Int SIGN = Set1Int(0x80000000u);
+    Float ax = AsFloat(AsInt(x) & Set1Int(0x7FFFFFFFu));
+    x = Select(ax < Set1(8388608.0f), x, Set1(0.0f));
+    Float half = AsFloat(AsInt(Set1(0.5f)) ^ (AsInt(x) & SIGN));
+    Float r = x - ToFloat(Truncate(x + half));
+    Int rSign = AsInt(r) & SIGN;
+    Float a = AsFloat(AsInt(r) ^ rSign);
+    Float m = Min(a, Set1(0.5f) - a);
+    return AsFloat(AsInt(detail::SinPoly(m)) ^ rSign);
+}
+
+inline simd::Float FastExp2(simd::Float x) {
+    using namespace simd;
+    x = Min(Max(x, Set1(-126.0f)), Set1(127.0f));
+    Int e = Truncate(x + Set1(127.5f));
+    Float n = ToFloat(e) - Set1(127.0f);
+    return detail::Exp2Poly(x - n) * AsFloat(ShiftLeft<23>(e));
+}
+
+inline simd::Float FastExp(simd::Float x) {
+    using namespace simd;
+    x = Min(Max(x, Set1(-87.0f)), Set1(88.0f));
+    Int e = Truncate(x * Set1(detail::LOG2E) + Set1(127.5f));
+    Float n = ToFloat(e) - Set1(127.0f);
+    Float r = (x - n * Set1(detail::LN2_HI)) - n * Set1(detail::LN2_LO);
+    return detail::Exp2Poly(r * Set1(detail::LOG2E)) * AsFloat(ShiftLeft<23>(e));
+}
+
+// What the engine calls, per PULSAR_FAST_MATH
+inline float Sin2Pi(float x) {
+#if PULSAR_FAST_MATH
+    return FastSin2Pi(x);
+#else
+    return sinf(x * 6.283185307f);
+#endif
+}
+
+inline float Exp2(float x) {
+#if PULSAR_FAST_MATH
+    return FastExp2(x);
+#else
+    return exp2f(x);
+#endif
+}
+
+inline float Exp(float x) {
+#if PULSAR_FAST_MATH
+    return FastExp(x);
+#else
+    return expf(x);
+#endif
+}
+
+}  // namespace fastmath
+
+#endif // FAST_MATH_HPP
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef LOAD_MONITOR_HPP
+#define LOAD_MONITOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "TripleBuffer.hpp"
+
+#if defined(__arm__)
+// Cycle counter of the Cortex-M7 data watchpoint and trace unit
+class DwtClock {
+public:
+    // Enable the counter; the debugger may already have done so
+    void Init() {
+        Register(DEMCR) |= DEMCR_TRCENA;
+        Register(DWT_LAR) = DWT_UNLOCK;
+        Register(DWT_CYCCNT) = 0;
+        Register(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+    }
+
+    uint32_t Now() const { return Register(DWT_CYCCNT); }
+
+private:
+    static constexpr uintptr_t DEMCR = 0xE000EDFCu;
+    static constexpr uintptr_t DWT_CTRL = 0xE0001000u;
+    static constexpr uintptr_t DWT_CYCCNT = 0xE0001004u;
+    static constexpr uintptr_t DWT_LAR = 0xE0001FB0u;
+
+    static constexpr uint32_t DEMCR_TRCENA = 1u << 24;
+    static constexpr uint32_t DWT_CTRL_CYCCNTENA = 1u;
+    static constexpr uint32_t DWT_UNLOCK = 0xC5ACCE55u;
+
+    static volatile uint32_t& Register(uintptr_t address) {
+        return *reinterpret_cast<volatile uint32_t*>(address);
+    }
+};
+#else
+#include <time.h>
+
+// Monotonic nanoseconds, wrapping at 32 bits like a cycle counter;
+// use a clock rate of 1 GHz with it
+class HostClock {
+public:
+    void Init() {}
+
+    uint32_t Now() const {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint32_t>(static_cast<uint64_t>(now.tv_sec) * 1000000000u +
+                                     static_cast<uint64_t>(now.tv_nsec));
+    }
+};
+#endif
+
+// Clock that only moves when told to, for testing the bookkeeping
+class SimulatedClock {
+public:
+    void Init() {}
+    uint32_t Now() const { return now_; }
+    void Set(uint32_t now) { now_ = now; }
+    void Advance(uint32_t cycles) { now_ += cycles; }
+
+private:
+    uint32_t now_ = 0;
+};
+
+// Audio callback load since the last reset. A block's budget is the
+// time until the next callback: its length in samples at the clock rate.
+struct LoadStats {
+    // Tenths of the budget, plus one bin for deadline misses
+    static constexpr int HISTOGRAM_BINS = 11;
+
+    uint32_t blocks = 0;
+    uint32_t misses = 0;  // Blocks that took longer than their budget
+    uint32_t minCycles = 0;
+    uint32_t maxCycles = 0;
+    uint64_t totalCycles = 0;
+    uint64_t totalBudget = 0;
+    uint32_t histogram[HISTOGRAM_BINS] = {};
+
+    // Smoothed share of the budget in use, 0.0 to 1.0 and beyond
+    float load = 0.0f;
+
+    float AverageCycles() const {
+        return blocks > 0 ? static_cast<float>(totalCycles) / blocks : 0.0f;
+    }
+    float AverageLoad() const {
+        return totalBudget > 0 ? static_cast<float>(totalCycles) / totalBudget : 0.0f;
+    }
+};
+
+// Per-block timing of the audio callback.
+//
+// Call BeginBlock and EndBlock around the work in the callback. Stats
+// are kept privately by the callback and handed to the main loop through
+// a TripleBuffer after every block, so GetStats never sees a block half
+// recorded. Clock is any class with Init() and a wrapping uint32_t
+// Now(); blocks must take less than one wrap of it.
+template <typename Clock>
+class LoadMonitor {
+public:
+    // Weight of each block in the smoothed load
+    static constexpr float LOAD_SMOOTHING = 0.01f;
+
+    LoadMonitor() : cyclesPerSample_(0.0f), start_(0), resetRequested_(false) {}
+
+    void Init(float sampleRate, uint32_t clockHz) {
+        clock_.Init();
+        cyclesPerSample_ = static_cast<float>(clockHz) / sampleRate;
+        stats_ = LoadStats();
+        published_.Init(stats_);
+        resetRequested_.store(false, std::memory_order_relaxed);
+    }
+
+    Clock& GetClock() { return clock_; }
+
+    // Audio side: bracket the callback's work
+    void BeginBlock() { start_ = clock_.Now(); }
+    void EndBlock(size_t size) { Record(clock_.Now() - start_, size); }
+
+    // Audio side: account one block of size samples taking cycles
+    void Record(uint32_t cycles, size_t size) {
+        if (resetRequested_.exchange(false, std::memory_order_acquire)) {
+            stats_ = LoadStats();
+        }
+
+        uint32_t budget = static_cast<uint32_t>(cyclesPerSample_ * size + 0.5f);
+        budget = (budget > 0) ? budget : 1;
+        bool miss = cycles > budget;
+
+        stats_.minCycles = (stats_.blocks == 0 || cycles < stats_.minCycles)
+                               ? cycles : stats_.minCycles;
+        stats_.maxCycles = (cycles > stats_.maxCycles) ? cycles : stats_.maxCycles;
+        stats_.blocks++;
+        stats_.misses += miss ? 1 : 0;
+        stats_.totalCycles += cycles;
+        stats_.totalBudget += budget;
+
+        uint32_t bin = static_cast<uint32_t>(static_cast<uint64_t>(cycles) * 10 / budget);
+        bin = miss ? LoadStats::HISTOGRAM_BINS - 1 : (bin < 9 ? bin : 9);
+        stats_.histogram[bin]++;
+
+        float load = static_cast<float>(cycles) / static_cast<float>(budget);
+        stats_.load = (stats_.blocks == 1)
+                          ? load : stats_.load + (load - stats_.load) * LOAD_SMOOTHING;
+
+        published_.Publish(stats_);
+    }
+
+    // Main loop side: the stats as of the last recorded block
+    const LoadStats& GetStats() {
+        published_.Acquire();
+        return published_.Read();
+    }
+
+    // Main loop side: start counting afresh from the next block
+    void Reset() { resetRequested_.store(true, std::memory_order_release); }
+
+private:
+    Clock clock_;
+    float cyclesPerSample_;
+    uint32_t start_;
+    std::atomic<bool> resetRequested_;
+
+    // Written by the audio side only
+    LoadStats stats_;
+
+    // Audio side publishes, main loop acquires
+    TripleBuffer<LoadStats> published_;
+};
+
+#endif // LOAD_MONITOR_HPP
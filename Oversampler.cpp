@@ -0,0 +1,168 @@
+#include "Oversampler.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+float BesselI0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    float halfX = 0.5f * x;
+    for (int k = 1; k < 20; ++k) {
+        term *= halfX / static_cast<float>(k);
+        sum += term * term;
+    }
+    return sum;
+}
+
+static constexpr float KAISER_BETA = 8.0f;
+static constexpr float PI = 3.14159265358979323846f;
+
+}  // namespace
+
+void HalfBand::Init(int halfLength) {
+    halfLength_ = (halfLength < 1) ? 1
+                  : ((halfLength > MAX_HALF_LENGTH) ? MAX_HALF_LENGTH : halfLength);
+    taps_ = 2 * halfLength_;
+    Design(halfLength_, coeffs_);
+    Reset();
+}
+
+void HalfBand::Design(int halfLength, float* branch) {
+    // Non-zero taps sit at odd offsets d = 2i + 1 from the centre of a
+    // 4M - 1 tap filter. branch holds them as one symmetric 2M-tap
+    // branch, outermost first; the filters fold the symmetry and only
+    // read the first half.
+    const float center = static_cast<float>(2 * halfLength - 1);
+    const float norm = BesselI0(KAISER_BETA);
+    float sum = 0.0f;
+    for (int i = 0; i < halfLength; ++i) {
+        float d = static_cast<float>(2 * i + 1);
+        float sinc = sinf(0.5f * PI * d) / (PI * d);
+        float r = d / center;
+        float window = BesselI0(KAISER_BETA * sqrtf(fmaxf(0.0f, 1.0f - r * r))) / norm;
+        float h = sinc * window;
+        branch[halfLength - 1 - i] = h;
+        branch[halfLength + i] = h;
+        sum += 2.0f * h;
+    }
+
+    // The branch must sum to 0.5 for unity DC gain
+    for (int j = 0; j < 2 * halfLength; ++j) {
+        branch[j] *= 0.5f / sum;
+    }
+}
+
+void HalfBand::Reset() {
+    std::memset(upWork_, 0, sizeof(upWork_));
+    std::memset(downEven_, 0, sizeof(downEven_));
+    std::memset(downOdd_, 0, sizeof(downOdd_));
+}
+
+void HalfBand::Upsample(const float* in, float* out, size_t size) {
+    const int history = taps_ - 1;
+    std::memcpy(upWork_ + history, in, size * sizeof(float));
+
+    for (size_t n = 0; n < size; ++n) {
+        const float* window = upWork_ + n;
+        float acc = 0.0f;
+        for (int j = 0; j < halfLength_; ++j) {
+            acc += coeffs_[j] * (window[j] + window[taps_ - 1 - j]);
+        }
+        // Filter branch, then the delay branch (centre tap)
+        out[2 * n] = 2.0f * acc;
+        out[2 * n + 1] = window[halfLength_];
+    }
+
+    std::memmove(upWork_, upWork_ + size, history * sizeof(float));
+}
+
+void HalfBand::Downsample(const float* in, float* out, size_t size) {
+    const int history = taps_ - 1;
+    for (size_t n = 0; n < size; ++n) {
+        downEven_[history + n] = in[2 * n];
+        downOdd_[halfLength_ + n] = in[2 * n + 1];
+    }
+
+    for (size_t n = 0; n < size; ++n) {
+        const float* window = downEven_ + n;
+        float acc = 0.0f;
+        for (int j = 0; j < halfLength_; ++j) {
+            acc += coeffs_[j] * (window[j] + window[taps_ - 1 - j]);
+        }
+        out[n] = acc + 0.5f * downOdd_[n];
+    }
+
+    std::memmove(downEven_, downEven_ + size, history * sizeof(float));
+    std::memmove(downOdd_, downOdd_ + size, halfLength_ * sizeof(float));
+}
+
+void Oversampler::Init(int factor) {
+    factor_ = (factor >= 4) ? 4 : ((factor >= 2) ? 2 : 1);
+    stage1_.Init(HalfBand::MAX_HALF_LENGTH);
+    stage2_.Init(HalfBand::MAX_HALF_LENGTH / 2);
+
+    latency_ = 0;
+    if (factor_ >= 2) {
+        latency_ += stage1_.Latency();
+    }
+    if (factor_ == 4) {
+        latency_ += (stage2_.Latency() + 1) / 2;
+    }
+
+    Reset();
+}
+
+void Oversampler::Reset() {
+    stage1_.Reset();
+    stage2_.Reset();
+    std::memset(history_, 0, sizeof(history_));
+    bypassed_ = false;
+    pad_ = 0.0f;
+}
+
+void Oversampler::Bypass(float* io, size_t size) {
+    if (factor_ == 1) {
+        return;
+    }
+    bypassed_ = true;
+
+    while (size > 0) {
+        size_t n = (size < CHUNK) ? size : CHUNK;
+        Remember(io, n);
+        const float* delayed = history_ + HISTORY - n - latency_;
+        std::memcpy(io, delayed, n * sizeof(float));
+        io += n;
+        size -= n;
+    }
+}
+
+void Oversampler::Remember(const float* in, size_t size) {
+    std::memcpy(history_ + HISTORY, in, size * sizeof(float));
+    std::memmove(history_, history_ + size, HISTORY * sizeof(float));
+}
+
+void Oversampler::Prime() {
+    stage1_.Reset();
+    stage2_.Reset();
+    pad_ = 0.0f;
+    float scratch[CHUNK];
+    for (size_t start = 0; start < HISTORY; start += CHUNK) {
+        size_t n = (HISTORY - start < CHUNK) ? HISTORY - start : CHUNK;
+        stage1_.Upsample(history_ + start, rateA_, n);
+        if (factor_ == 4) {
+            stage2_.Upsample(rateA_, rateB_, 2 * n);
+            stage2_.Downsample(rateB_, rateA_, 2 * n);
+            Pad(rateA_, 2 * n);
+        }
+        stage1_.Downsample(rateA_, scratch, n);
+    }
+}
+
+void Oversampler::Pad(float* io, size_t size) {
+    float last = io[size - 1];
+    std::memmove(io + 1, io, (size - 1) * sizeof(float));
+    io[0] = pad_;
+    pad_ = last;
+}
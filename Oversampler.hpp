@@ -0,0 +1,149 @@
+#pragma once
+#ifndef OVERSAMPLER_HPP
+#define OVERSAMPLER_HPP
+
+#include <cstddef>
+
+// Polyphase half-band 2x resampler stage.
+//
+// The half-band FIR (Kaiser-windowed sinc, 4M-1 taps) has every other
+// tap zero, so each polyphase branch is either a pure delay or a
+// symmetric 2M-tap filter. Upsampling and downsampling keep separate
+// histories and process blocks of up to MAX_BLOCK input samples
+// (upsampling) or output samples (downsampling) per call.
+class HalfBand {
+public:
+    static constexpr int MAX_HALF_LENGTH = 8;
+    static constexpr int MAX_TAPS = 2 * MAX_HALF_LENGTH;
+    static constexpr size_t MAX_BLOCK = 64;
+
+    HalfBand() { Init(MAX_HALF_LENGTH); }
+
+    // halfLength M (1 to MAX_HALF_LENGTH) sets 2M taps per branch
+    void Init(int halfLength);
+
+    // Clear filter histories
+    void Reset();
+
+    // size input samples to 2 * size output samples
+    void Upsample(const float* in, float* out, size_t size);
+
+    // 2 * size input samples to size output samples
+    void Downsample(const float* in, float* out, size_t size);
+
+    // Delay added by an up/down pair, in samples at the lower rate
+    int Latency() const { return 2 * halfLength_ - 1; }
+
+    // The 2M non-zero taps of the filter for halfLength M, as the
+    // symmetric branch the resampler runs (outermost first, summing to
+    // 0.5); the centre tap of the full filter is 0.5
+    static void Design(int halfLength, float* branch);
+
+private:
+    int halfLength_;
+    int taps_;
+    float coeffs_[MAX_TAPS];
+
+    // History followed by the current block
+    float upWork_[MAX_TAPS - 1 + MAX_BLOCK];
+    float downEven_[MAX_TAPS - 1 + MAX_BLOCK];
+    float downOdd_[MAX_HALF_LENGTH + MAX_BLOCK];
+};
+
+// 2x or 4x oversampling around a block nonlinearity, built from
+// cascaded HalfBand stages. The second stage of 4x runs at twice the
+// rate and has a wider transition band, so it uses a shorter filter.
+// Its delay is an odd number of samples at that rate, so it is padded
+// by one more to keep the total a whole number of base-rate samples.
+//
+// While the nonlinearity is not needed, Bypass delays the signal by the
+// filter latency instead, so switching between the two does not jump in
+// time. The last HISTORY input samples are kept either way and replayed
+// through the filters when Process resumes, so it starts from the state
+// it would have had if it had been running all along.
+class Oversampler {
+public:
+    // Base-rate samples per internal chunk; the second stage of 4x
+    // sees twice as many
+    static constexpr size_t CHUNK = HalfBand::MAX_BLOCK / 2;
+
+    // Input samples kept for the bypass delay and for priming the filters
+    static constexpr size_t HISTORY = 64;
+
+    Oversampler() { Init(2); }
+
+    // factor 1, 2 or 4 (other values are clamped down)
+    void Init(int factor);
+
+    void Reset();
+
+    int GetFactor() const { return factor_; }
+
+    // Delay of Process and Bypass, in samples at the base rate
+    int Latency() const { return latency_; }
+
+    // Delay a block by Latency() without running the filters
+    void Bypass(float* io, size_t size);
+
+    // Apply shaper(buffer, count) to the oversampled signal, in place.
+    // The shaper sees the block in chunks of up to CHUNK * factor
+    // samples, in order, so it may keep state across calls.
+    template <typename Shaper>
+    void Process(float* io, size_t size, Shaper&& shaper) {
+        if (factor_ == 1) {
+            shaper(io, size);
+            return;
+        }
+        if (bypassed_) {
+            Prime();
+            bypassed_ = false;
+        }
+
+        while (size > 0) {
+            size_t n = (size < CHUNK) ? size : CHUNK;
+            Remember(io, n);
+
+            stage1_.Upsample(io, rateA_, n);
+            float* up = rateA_;
+            if (factor_ == 4) {
+                stage2_.Upsample(rateA_, rateB_, 2 * n);
+                up = rateB_;
+            }
+
+            shaper(up, n * static_cast<size_t>(factor_));
+
+            if (factor_ == 4) {
+                stage2_.Downsample(rateB_, rateA_, 2 * n);
+                Pad(rateA_, 2 * n);
+            }
+            stage1_.Downsample(rateA_, io, n);
+
+            io += n;
+            size -= n;
+        }
+    }
+
+private:
+    // Append to the input history
+    void Remember(const float* in, size_t size);
+
+    // Run the filters over the input history, discarding the output
+    void Prime();
+
+    // Delay the second stage's output by one sample
+    void Pad(float* io, size_t size);
+
+    int factor_;
+    int latency_;
+    bool bypassed_;
+    float pad_;  // Last sample out of the second stage
+    HalfBand stage1_;
+    HalfBand stage2_;
+    float rateA_[2 * CHUNK];
+    float rateB_[4 * CHUNK];
+
+    // Input history followed by room for one chunk
+    float history_[HISTORY + CHUNK];
+};
+
+#endif // OVERSAMPLER_HPP
@@ -0,0 +1,234 @@
+#include "PulsarBank.hpp"
+#include "PulsaretTables.hpp"
+#include <cmath>
+
+void PulsarBank::Init(float sampleRate, size_t numVoices) {
+    sampleRate_ = sampleRate;
+    invSampleRate_ = 1.0f / sampleRate;
+    numVoices_ = (numVoices > MAX_VOICES) ? MAX_VOICES : numVoices;
+    maskingMode_ = MaskingMode::OFF;
+
+    PulsaretTables::Init();
+
+    for (size_t v = 0; v < MAX_VOICES; ++v) {
+        phase_[v] = 0.0f;
+        phaseIncrement_[v] = 0.0f;
+        dutyCycle_[v] = 0.5f;
+        invDutyCycle_[v] = 2.0f;
+
+        waveRowA_[v] = 0;
+        waveRowB_[v] = 0;
+        waveMorph_[v] = 0.0f;
+        noiseWeight_[v] = 0.0f;
+        envRowA_[v] = static_cast<uint32_t>(PulsaretEnvelope::GAUSSIAN) *
+                      PulsaretTables::TABLE_STRIDE;
+        envRowB_[v] = envRowA_[v];
+        envMorph_[v] = 0.0f;
+
+        // Lanes past numVoices_ stay silent
+        amplitude_[v] = (v < numVoices_) ? 1.0f : 0.0f;
+        emit_[v] = 1.0f;
+
+        maskingProbability_[v] = 1.0f;
+        burstCount_[v] = 4;
+        restCount_[v] = 0;
+        burstPosition_[v] = 0;
+    }
+
+    SetRandomSeed(rng::DEFAULT_SEED);
+
+    for (size_t v = 0; v < numVoices_; ++v) {
+        SetFrequency(v, 220.0f);
+    }
+}
+
+void PulsarBank::Reset() {
+    for (size_t v = 0; v < MAX_VOICES; ++v) {
+        phase_[v] = 0.0f;
+        burstPosition_[v] = 0;
+        emit_[v] = 1.0f;
+    }
+}
+
+void PulsarBank::Process(float* out, size_t size) {
+    using namespace simd;
+
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = 0.0f;
+    }
+
+    // Row offsets index from the first table of each kind
+    const float* waveTables = PulsaretTables::Waveform(PulsaretWaveform::SINE);
+    const float* envTables = PulsaretTables::Envelope(PulsaretEnvelope::RECTANGULAR);
+
+    const Float zero = Set1(0.0f);
+    const Float one = Set1(1.0f);
+    const Float tableSize = Set1(static_cast<float>(WAVETABLE_SIZE));
+    const Float maxPhase = Set1(0.99999994f);
+    const Int oneInt = Set1Int(1);
+    const Int noiseStep = Set1Int(rng::GAMMA);
+    const Int noiseStart = Set1Int(noisePosition_ * rng::GAMMA);
+
+    for (size_t v = 0; v < numVoices_; v += WIDTH) {
+        Float phase = Load(phase_ + v);
+        const Float increment = Load(phaseIncrement_ + v);
+        const Float duty = Load(dutyCycle_ + v);
+        const Float invDuty = Load(invDutyCycle_ + v);
+        const Int waveA = LoadInt(waveRowA_ + v);
+        const Int waveB = LoadInt(waveRowB_ + v);
+        const Float waveMorph = Load(waveMorph_ + v);
+        const Float noiseWeight = Load(noiseWeight_ + v);
+        const Int envA = LoadInt(envRowA_ + v);
+        const Int envB = LoadInt(envRowB_ + v);
+        const Float envMorph = Load(envMorph_ + v);
+        const Float amplitude = Load(amplitude_ + v);
+        Float gain = amplitude * Load(emit_ + v);
+        const Int noiseKey = LoadInt(noiseKey_ + v);
+        Int noiseCounter = noiseStart;
+
+        for (size_t i = 0; i < size; ++i) {
+            Mask active = phase < duty;
+
+            // Pulsaret phase to table position
+            Float pulsaretPhase = Min(phase * invDuty, maxPhase);
+            Float index = pulsaretPhase * tableSize;
+            Int i0 = Truncate(index);
+            Int i1 = i0 + oneInt;
+            Float frac = index - ToFloat(i0);
+
+            Float wa0 = Gather(waveTables, waveA + i0);
+            Float wa1 = Gather(waveTables, waveA + i1);
+            Float wb0 = Gather(waveTables, waveB + i0);
+            Float wb1 = Gather(waveTables, waveB + i1);
+            Float wa = wa0 + (wa1 - wa0) * frac;
+            Float wb = wb0 + (wb1 - wb0) * frac;
+
+            // NOISE rows are zero; its share comes from the generator
+            Float white = rng::ToBipolar(rng::Mix(noiseCounter ^ noiseKey));
+            noiseCounter = noiseCounter + noiseStep;
+            Float wave = wa + (wb - wa) * waveMorph + white * noiseWeight;
+
+            Float ea0 = Gather(envTables, envA + i0);
+            Float ea1 = Gather(envTables, envA + i1);
+            Float eb0 = Gather(envTables, envB + i0);
+            Float eb1 = Gather(envTables, envB + i1);
+            Float ea = ea0 + (ea1 - ea0) * frac;
+            Float eb = eb0 + (eb1 - eb0) * frac;
+            Float env = ea + (eb - ea) * envMorph;
+
+            out[i] += HorizontalSum(Select(active, wave * env * gain, zero));
+
+            // Advance phase, wrapping per lane
+            phase = phase + increment;
+            Mask wrapped = phase >= one;
+            phase = Select(wrapped, phase - one, phase);
+
+            int bits = Bits(wrapped);
+            if (bits != 0) {
+                for (size_t lane = 0; lane < WIDTH; ++lane) {
+                    if (bits & (1 << lane)) {
+                        NextPulsar(v + lane);
+                    }
+                }
+                gain = amplitude * Load(emit_ + v);
+            }
+        }
+
+        Store(phase_ + v, phase);
+    }
+    noisePosition_ += static_cast<uint32_t>(size);
+}
+
+void PulsarBank::SetFrequency(size_t voice, float freq) {
+    if (voice >= numVoices_) return;
+    freq = fmaxf(0.1f, fminf(freq, sampleRate_ * 0.45f));
+    phaseIncrement_[voice] = freq * invSampleRate_;
+}
+
+void PulsarBank::SetFormantRatio(size_t voice, float ratio) {
+    if (voice >= numVoices_) return;
+    ratio = fmaxf(0.01f, fminf(1.0f, ratio));
+    dutyCycle_[voice] = ratio;
+    invDutyCycle_[voice] = 1.0f / ratio;
+}
+
+void PulsarBank::SetWaveformMorph(size_t voice, float morphValue) {
+    if (voice >= numVoices_) return;
+    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
+
+    int idx = static_cast<int>(morphValue);
+    int next = (idx < 6) ? idx + 1 : 6;
+    float morph = morphValue - static_cast<float>(idx);
+    const int noise = static_cast<int>(PulsaretWaveform::NOISE);
+
+    waveRowA_[voice] = static_cast<uint32_t>(idx * PulsaretTables::TABLE_STRIDE);
+    waveRowB_[voice] = static_cast<uint32_t>(next * PulsaretTables::TABLE_STRIDE);
+    waveMorph_[voice] = morph;
+    noiseWeight_[voice] = ((idx == noise) ? 1.0f - morph : 0.0f) +
+                          ((next == noise && idx != noise) ? morph : 0.0f);
+}
+
+void PulsarBank::SetEnvelopeMorph(size_t voice, float morphValue) {
+    if (voice >= numVoices_) return;
+    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
+
+    int idx = static_cast<int>(morphValue);
+    int next = (idx < 6) ? idx + 1 : 6;
+
+    envRowA_[voice] = static_cast<uint32_t>(idx * PulsaretTables::TABLE_STRIDE);
+    envRowB_[voice] = static_cast<uint32_t>(next * PulsaretTables::TABLE_STRIDE);
+    envMorph_[voice] = morphValue - static_cast<float>(idx);
+}
+
+void PulsarBank::SetAmplitude(size_t voice, float amp) {
+    if (voice >= numVoices_) return;
+    amplitude_[voice] = fmaxf(0.0f, fminf(1.0f, amp));
+}
+
+void PulsarBank::SetBurstRatio(size_t voice, int burst, int rest) {
+    if (voice >= numVoices_) return;
+    burstCount_[voice] = (burst < 1) ? 1 : ((burst > 16) ? 16 : burst);
+    restCount_[voice] = (rest < 0) ? 0 : ((rest > 16) ? 16 : rest);
+}
+
+void PulsarBank::SetMaskingProbability(size_t voice, float probability) {
+    if (voice >= numVoices_) return;
+    maskingProbability_[voice] = fmaxf(0.0f, fminf(1.0f, probability));
+}
+
+void PulsarBank::SetMaskingMode(MaskingMode mode) {
+    maskingMode_ = mode;
+}
+
+void PulsarBank::SetRandomSeed(uint32_t seed) {
+    for (size_t v = 0; v < MAX_VOICES; ++v) {
+        const uint32_t voice = static_cast<uint32_t>(v) << rng::VOICE_SHIFT;
+        noiseKey_[v] = rng::Key(seed, rng::NOISE | voice);
+        masking_[v].Seed(seed, rng::MASKING | voice);
+    }
+    noisePosition_ = 0;
+}
+
+void PulsarBank::NextPulsar(size_t voice) {
+    burstPosition_[voice]++;
+    if (burstPosition_[voice] >= (burstCount_[voice] + restCount_[voice])) {
+        burstPosition_[voice] = 0;
+    }
+
+    bool emit = true;
+    switch (maskingMode_) {
+        case MaskingMode::OFF:
+            emit = true;
+            break;
+
+        case MaskingMode::BURST:
+            emit = (burstPosition_[voice] < burstCount_[voice]);
+            break;
+
+        case MaskingMode::STOCHASTIC:
+            emit = (masking_[voice].Next() < maskingProbability_[voice]);
+            break;
+    }
+
+    emit_[voice] = emit ? 1.0f : 0.0f;
+}
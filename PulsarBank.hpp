@@ -0,0 +1,98 @@
+#pragma once
+#ifndef PULSAR_BANK_HPP
+#define PULSAR_BANK_HPP
+
+#include "PulsarEngine.hpp"
+#include "PulsarSimd.hpp"
+#include "Random.hpp"
+
+// Bank of independent pulsar trains rendered several voices at a time.
+//
+// Voice state is kept as structure-of-arrays so that simd::WIDTH voices
+// share each instruction. Shapes always come from PulsaretTables. Each
+// voice has its own frequency, formant ratio, waveform/envelope morph,
+// amplitude, masking parameters and noise generator; the masking mode
+// is shared by the bank. Masked or silent lanes are blended to zero
+// rather than branched around. Wavefolding and edge smoothing are left
+// to the single-voice PulsarEngine.
+class PulsarBank {
+public:
+    // Voice capacity, a multiple of every simd::WIDTH
+    static constexpr size_t MAX_VOICES = 32;
+
+    PulsarBank() { Init(48000.0f, 1); }
+    ~PulsarBank() = default;
+
+    // Initialize with sample rate and number of active voices
+    void Init(float sampleRate, size_t numVoices);
+
+    // Reset all phases and masking state
+    void Reset();
+
+    size_t GetNumVoices() const { return numVoices_; }
+
+    // Render the sum of all voices
+    void Process(float* out, size_t size);
+
+    // Per-voice parameters, with the same ranges as PulsarEngine
+    void SetFrequency(size_t voice, float freq);
+    void SetFormantRatio(size_t voice, float ratio);
+    void SetWaveformMorph(size_t voice, float morphValue);
+    void SetEnvelopeMorph(size_t voice, float morphValue);
+    void SetAmplitude(size_t voice, float amp);
+    void SetBurstRatio(size_t voice, int burst, int rest);
+    void SetMaskingProbability(size_t voice, float probability);
+
+    // Masking mode for the whole bank
+    void SetMaskingMode(MaskingMode mode);
+
+    // Restart every voice's noise and masking streams under a seed
+    void SetRandomSeed(uint32_t seed);
+
+    float GetPhase(size_t voice) const { return phase_[voice]; }
+
+private:
+    // Start a new pulsar period on one voice: advance its burst
+    // position and decide whether it emits
+    void NextPulsar(size_t voice);
+
+    float sampleRate_;
+    float invSampleRate_;
+    size_t numVoices_;
+    MaskingMode maskingMode_;
+
+    // Structure-of-arrays voice state
+    alignas(32) float phase_[MAX_VOICES];
+    alignas(32) float phaseIncrement_[MAX_VOICES];
+    alignas(32) float dutyCycle_[MAX_VOICES];
+    alignas(32) float invDutyCycle_[MAX_VOICES];
+
+    // Morph pairs as table row offsets plus weight; noiseWeight_ is the
+    // share of the waveform morph that comes from NOISE
+    alignas(32) uint32_t waveRowA_[MAX_VOICES];
+    alignas(32) uint32_t waveRowB_[MAX_VOICES];
+    alignas(32) float waveMorph_[MAX_VOICES];
+    alignas(32) float noiseWeight_[MAX_VOICES];
+    alignas(32) uint32_t envRowA_[MAX_VOICES];
+    alignas(32) uint32_t envRowB_[MAX_VOICES];
+    alignas(32) float envMorph_[MAX_VOICES];
+
+    // Output gain is amplitude_ * emit_, where emit_ is 1.0 or 0.0
+    // depending on whether the current pulsar is masked
+    alignas(32) float amplitude_[MAX_VOICES];
+    alignas(32) float emit_[MAX_VOICES];
+
+    // Per-voice noise stream keys, all at the shared noisePosition_,
+    // and per-voice masking streams
+    alignas(32) uint32_t noiseKey_[MAX_VOICES];
+    uint32_t noisePosition_;
+    RandomStream masking_[MAX_VOICES];
+
+    // Masking bookkeeping, touched only when a voice wraps
+    float maskingProbability_[MAX_VOICES];
+    int burstCount_[MAX_VOICES];
+    int restCount_[MAX_VOICES];
+    int burstPosition_[MAX_VOICES];
+};
+
+#endif // PULSAR_BANK_HPP
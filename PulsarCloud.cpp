@@ -0,0 +1,357 @@
+#include "PulsarCloud.hpp"
+#include "PulsaretTables.hpp"
+#include <cmath>
+
+static_assert(PulsarCloud::MAX_PULSARETS <= 32, "occupied_ holds one bit per slot");
+static_assert(PulsarCloud::MAX_PULSARETS % simd::WIDTH == 0,
+              "slots are swept simd::WIDTH at a time");
+
+namespace {
+
+// Table rows and weights for a morph position, as in PulsarBank
+void SplitMorph(float morphValue, uint32_t& rowA, uint32_t& rowB, float& morph) {
+    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
+    int idx = static_cast<int>(morphValue);
+    int next = (idx < 6) ? idx + 1 : 6;
+    rowA = static_cast<uint32_t>(idx * PulsaretTables::TABLE_STRIDE);
+    rowB = static_cast<uint32_t>(next * PulsaretTables::TABLE_STRIDE);
+    morph = morphValue - static_cast<float>(idx);
+}
+
+}  // namespace
+
+void PulsarCloud::Init(float sampleRate, size_t capacity) {
+    sampleRate_ = sampleRate;
+    invSampleRate_ = 1.0f / sampleRate;
+    stealPolicy_ = StealPolicy::OLDEST;
+
+    PulsaretTables::Init();
+
+    jitter_ = 0.0f;
+    maskingMode_ = MaskingMode::OFF;
+    burstCount_ = 4;
+    restCount_ = 0;
+    maskingProbability_ = 1.0f;
+    amplitude_ = 1.0f;
+    stolen_ = 0;
+    dropped_ = 0;
+    SetRandomSeed(rng::DEFAULT_SEED);
+
+    SetFrequency(220.0f);
+    SetFormantFrequency(440.0f);
+    SetWaveformMorph(0.0f);
+    SetEnvelopeMorph(1.0f);
+
+    capacity_ = 0;
+    occupied_ = 0;
+    SetCapacity(capacity);
+    Reset();
+}
+
+void PulsarCloud::Reset() {
+    occupied_ = 0;
+    for (size_t s = 0; s < MAX_PULSARETS; ++s) {
+        phase_[s] = 0.0f;
+        increment_[s] = 0.0f;
+        gain_[s] = 0.0f;
+        waveRowA_[s] = 0;
+        waveRowB_[s] = 0;
+        waveMorph_[s] = 0.0f;
+        noiseWeight_[s] = 0.0f;
+        envRowA_[s] = 0;
+        envRowB_[s] = 0;
+        envMorph_[s] = 0.0f;
+        emitted_[s] = 0;
+    }
+    untilEmission_ = 0.0f;
+    emissions_ = 0;
+    burstPosition_ = 0;
+}
+
+void PulsarCloud::Process(float* out, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = 0.0f;
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        // Up to the sample the next pulsaret starts on
+        size_t wait = static_cast<size_t>(ceilf(untilEmission_));
+        size_t n = (wait < size - done) ? wait : size - done;
+        Sweep(out + done, n);
+        noisePosition_ += static_cast<uint32_t>(n);
+        done += n;
+        untilEmission_ -= static_cast<float>(n);
+
+        if (done < size) {
+            // untilEmission_ is now in (-1, 0]: how far past the
+            // emission this sample falls
+            Emit(-untilEmission_);
+            untilEmission_ += NextInterval();
+        }
+    }
+}
+
+void PulsarCloud::Sweep(float* out, size_t size) {
+    using namespace simd;
+
+    if (size == 0 || occupied_ == 0) {
+        return;
+    }
+
+    // Row offsets index from the first table of each kind
+    const float* waveTables = PulsaretTables::Waveform(PulsaretWaveform::SINE);
+    const float* envTables = PulsaretTables::Envelope(PulsaretEnvelope::RECTANGULAR);
+
+    const Float zero = Set1(0.0f);
+    const Float one = Set1(1.0f);
+    const Float tableSize = Set1(static_cast<float>(WAVETABLE_SIZE));
+    const Int oneInt = Set1Int(1);
+    const Int noiseStep = Set1Int(rng::GAMMA);
+    const Int noiseStart = Set1Int(noisePosition_ * rng::GAMMA);
+    const uint32_t groupMask = (1u << WIDTH) - 1u;
+
+    for (size_t v = 0; v < capacity_; v += WIDTH) {
+        if (((occupied_ >> v) & groupMask) == 0) {
+            continue;
+        }
+
+        Float phase = Load(phase_ + v);
+        Float increment = Load(increment_ + v);
+        Float gain = Load(gain_ + v);
+        const Int waveA = LoadInt(waveRowA_ + v);
+        const Int waveB = LoadInt(waveRowB_ + v);
+        const Float waveMorph = Load(waveMorph_ + v);
+        const Float noiseWeight = Load(noiseWeight_ + v);
+        const Int envA = LoadInt(envRowA_ + v);
+        const Int envB = LoadInt(envRowB_ + v);
+        const Float envMorph = Load(envMorph_ + v);
+        const Int noiseKey = LoadInt(noiseKey_ + v);
+        Int noiseCounter = noiseStart;
+
+        for (size_t i = 0; i < size; ++i) {
+            // The phase of a sounding pulsaret stays below 1
+            Float index = phase * tableSize;
+            Int i0 = Truncate(index);
+            Int i1 = i0 + oneInt;
+            Float frac = index - ToFloat(i0);
+
+            Float wa0 = Gather(waveTables, waveA + i0);
+            Float wa1 = Gather(waveTables, waveA + i1);
+            Float wb0 = Gather(waveTables, waveB + i0);
+            Float wb1 = Gather(waveTables, waveB + i1);
+            Float wa = wa0 + (wa1 - wa0) * frac;
+            Float wb = wb0 + (wb1 - wb0) * frac;
+
+            // NOISE rows are zero; its share comes from the generator
+            Float white = rng::ToBipolar(rng::Mix(noiseCounter ^ noiseKey));
+            noiseCounter = noiseCounter + noiseStep;
+            Float wave = wa + (wb - wa) * waveMorph + white * noiseWeight;
+
+            Float ea0 = Gather(envTables, envA + i0);
+            Float ea1 = Gather(envTables, envA + i1);
+            Float eb0 = Gather(envTables, envB + i0);
+            Float eb1 = Gather(envTables, envB + i1);
+            Float ea = ea0 + (ea1 - ea0) * frac;
+            Float eb = eb0 + (eb1 - eb0) * frac;
+            Float env = ea + (eb - ea) * envMorph;
+
+            out[i] += HorizontalSum(wave * env * gain);
+
+            // Pulsarets that have played out free their slots
+            phase = phase + increment;
+            Mask ended = phase >= one;
+            int bits = Bits(ended);
+            if (bits != 0) {
+                phase = Select(ended, zero, phase);
+                increment = Select(ended, zero, increment);
+                gain = Select(ended, zero, gain);
+                occupied_ &= ~(static_cast<uint32_t>(bits) << v);
+            }
+        }
+
+        Store(phase_ + v, phase);
+        Store(increment_ + v, increment);
+        Store(gain_ + v, gain);
+    }
+}
+
+void PulsarCloud::Emit(float offset) {
+    emissions_++;
+
+    burstPosition_++;
+    if (burstPosition_ >= (burstCount_ + restCount_)) {
+        burstPosition_ = 0;
+    }
+
+    bool emit = true;
+    switch (maskingMode_) {
+        case MaskingMode::OFF:
+            emit = true;
+            break;
+
+        case MaskingMode::BURST:
+            emit = (burstPosition_ < burstCount_);
+            break;
+
+        case MaskingMode::STOCHASTIC:
+            emit = (masking_.Next() < maskingProbability_);
+            break;
+    }
+    if (!emit) {
+        return;
+    }
+
+    int slot = AllocateSlot();
+    if (slot < 0) {
+        return;
+    }
+
+    size_t s = static_cast<size_t>(slot);
+    occupied_ |= 1u << s;
+    emitted_[s] = emissions_;
+    phase_[s] = offset * pulsaretIncrement_;
+    increment_[s] = pulsaretIncrement_;
+    gain_[s] = amplitude_;
+    waveRowA_[s] = nextWaveRowA_;
+    waveRowB_[s] = nextWaveRowB_;
+    waveMorph_[s] = nextWaveMorph_;
+    noiseWeight_[s] = nextNoiseWeight_;
+    envRowA_[s] = nextEnvRowA_;
+    envRowB_[s] = nextEnvRowB_;
+    envMorph_[s] = nextEnvMorph_;
+}
+
+int PulsarCloud::AllocateSlot() {
+    // Lowest free slot, which keeps sounding pulsarets in as few groups
+    // as possible
+    for (size_t s = 0; s < capacity_; ++s) {
+        if ((occupied_ & (1u << s)) == 0) {
+            return static_cast<int>(s);
+        }
+    }
+
+    int victim = -1;
+    switch (stealPolicy_) {
+        case StealPolicy::NONE:
+            break;
+
+        case StealPolicy::OLDEST: {
+            uint32_t oldest = 0;
+            for (size_t s = 0; s < capacity_; ++s) {
+                // Ages rather than counts, so the count may wrap
+                uint32_t age = emissions_ - emitted_[s];
+                if (victim < 0 || age > oldest) {
+                    victim = static_cast<int>(s);
+                    oldest = age;
+                }
+            }
+            break;
+        }
+
+        case StealPolicy::QUIETEST: {
+            float quietest = 0.0f;
+            for (size_t s = 0; s < capacity_; ++s) {
+                float level = SlotLevel(s);
+                if (victim < 0 || level < quietest) {
+                    victim = static_cast<int>(s);
+                    quietest = level;
+                }
+            }
+            break;
+        }
+    }
+
+    if (victim < 0) {
+        dropped_++;
+    } else {
+        stolen_++;
+    }
+    return victim;
+}
+
+float PulsarCloud::SlotLevel(size_t slot) const {
+    const float* envTables = PulsaretTables::Envelope(PulsaretEnvelope::RECTANGULAR);
+    float ea = PulsaretTables::Lookup(envTables + envRowA_[slot], phase_[slot]);
+    float eb = PulsaretTables::Lookup(envTables + envRowB_[slot], phase_[slot]);
+    return fabsf(ea + (eb - ea) * envMorph_[slot]) * gain_[slot];
+}
+
+float PulsarCloud::NextInterval() {
+    float interval = interval_;
+    if (jitter_ > 0.0f) {
+        interval *= 1.0f + jitter_ * jitterStream_.NextBipolar();
+    }
+    // At most one emission per sample
+    return fmaxf(1.0f, interval);
+}
+
+void PulsarCloud::SetRandomSeed(uint32_t seed) {
+    for (size_t s = 0; s < MAX_PULSARETS; ++s) {
+        const uint32_t slot = static_cast<uint32_t>(s) << rng::VOICE_SHIFT;
+        noiseKey_[s] = rng::Key(seed, rng::NOISE | slot);
+    }
+    noisePosition_ = 0;
+    masking_.Seed(seed, rng::MASKING);
+    jitterStream_.Seed(seed, rng::JITTER);
+}
+
+void PulsarCloud::SetCapacity(size_t capacity) {
+    capacity = (capacity < 1) ? 1 : ((capacity > MAX_PULSARETS) ? MAX_PULSARETS : capacity);
+    for (size_t s = capacity; s < capacity_; ++s) {
+        phase_[s] = 0.0f;
+        increment_[s] = 0.0f;
+        gain_[s] = 0.0f;
+    }
+    capacity_ = capacity;
+    occupied_ &= (capacity < 32) ? (1u << capacity) - 1u : 0xFFFFFFFFu;
+}
+
+size_t PulsarCloud::GetActiveCount() const {
+    size_t count = 0;
+    for (uint32_t bits = occupied_; bits != 0; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+}
+
+void PulsarCloud::SetFrequency(float freq) {
+    freq = fmaxf(0.1f, fminf(freq, sampleRate_ * 0.45f));
+    interval_ = sampleRate_ / freq;
+}
+
+void PulsarCloud::SetFormantFrequency(float freq) {
+    freq = fmaxf(0.1f, fminf(freq, sampleRate_ * 0.45f));
+    pulsaretIncrement_ = freq * invSampleRate_;
+}
+
+void PulsarCloud::SetJitter(float amount) {
+    jitter_ = fmaxf(0.0f, fminf(1.0f, amount));
+}
+
+void PulsarCloud::SetWaveformMorph(float morphValue) {
+    SplitMorph(morphValue, nextWaveRowA_, nextWaveRowB_, nextWaveMorph_);
+
+    const uint32_t noise = static_cast<uint32_t>(PulsaretWaveform::NOISE) *
+                           PulsaretTables::TABLE_STRIDE;
+    nextNoiseWeight_ = ((nextWaveRowA_ == noise) ? 1.0f - nextWaveMorph_ : 0.0f) +
+                       ((nextWaveRowB_ == noise && nextWaveRowA_ != noise)
+                            ? nextWaveMorph_ : 0.0f);
+}
+
+void PulsarCloud::SetEnvelopeMorph(float morphValue) {
+    SplitMorph(morphValue, nextEnvRowA_, nextEnvRowB_, nextEnvMorph_);
+}
+
+void PulsarCloud::SetAmplitude(float amp) {
+    amplitude_ = fmaxf(0.0f, fminf(1.0f, amp));
+}
+
+void PulsarCloud::SetBurstRatio(int burst, int rest) {
+    burstCount_ = (burst < 1) ? 1 : ((burst > 16) ? 16 : burst);
+    restCount_ = (rest < 0) ? 0 : ((rest > 16) ? 16 : rest);
+}
+
+void PulsarCloud::SetMaskingProbability(float probability) {
+    maskingProbability_ = fmaxf(0.0f, fminf(1.0f, probability));
+}
@@ -0,0 +1,159 @@
+#pragma once
+#ifndef PULSAR_CLOUD_HPP
+#define PULSAR_CLOUD_HPP
+
+#include "PulsarEngine.hpp"
+#include "PulsarSimd.hpp"
+#include "Random.hpp"
+
+// Which sounding pulsaret a new one replaces when the pool is full. The
+// replaced one stops at once.
+enum class StealPolicy {
+    NONE = 0,  // Drop the new pulsaret
+    OLDEST,    // Replace the one emitted longest ago
+    QUIETEST   // Replace the one with the lowest envelope times gain
+};
+
+// Asynchronous pulsar cloud: pulsarets emitted at a (jittered) rate
+// and left to play out, overlapping whenever one lasts longer than the
+// interval to the next.
+//
+// Each sounding pulsaret occupies a slot of a fixed pool, allocated
+// lowest slot first, with its state kept as structure-of-arrays so that
+// simd::WIDTH slots share each instruction. Groups of slots with nothing
+// sounding are skipped, so the cost follows the number of overlapping
+// pulsarets and is bounded by the capacity. Shapes, amplitude and the
+// pulsaret length are taken when a pulsaret is emitted; shapes come
+// from PulsaretTables. Masking decides per emission, and masked
+// emissions take no slot.
+class PulsarCloud {
+public:
+    // Pool size, a multiple of every simd::WIDTH
+    static constexpr size_t MAX_PULSARETS = 32;
+
+    PulsarCloud() { Init(48000.0f, MAX_PULSARETS); }
+    ~PulsarCloud() = default;
+
+    // Initialize with sample rate and pool capacity (1 to MAX_PULSARETS)
+    void Init(float sampleRate, size_t capacity);
+
+    // Silence every pulsaret and emit the next one on the next sample
+    void Reset();
+
+    // Render the sum of all sounding pulsarets
+    void Process(float* out, size_t size);
+
+    // Limit the pool; pulsarets in slots past the new capacity stop
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const { return capacity_; }
+
+    void SetStealPolicy(StealPolicy policy) { stealPolicy_ = policy; }
+
+    // Set emission rate (Hz), the cloud's fundamental
+    void SetFrequency(float freq);
+
+    // Set the pulsaret frequency (Hz): each pulsaret lasts one cycle of
+    // it, so pulsarets overlap when it is below the emission rate
+    void SetFormantFrequency(float freq);
+
+    // Randomize each emission interval by up to +/- amount of itself
+    // (0.0 to 1.0)
+    void SetJitter(float amount);
+
+    // Shape and level, as for PulsarEngine
+    void SetWaveformMorph(float morphValue);
+    void SetEnvelopeMorph(float morphValue);
+    void SetAmplitude(float amp);
+    void SetBurstRatio(int burst, int rest);
+    void SetMaskingProbability(float probability);
+    void SetMaskingMode(MaskingMode mode) { maskingMode_ = mode; }
+
+    // Restart the noise, masking and jitter streams under a seed
+    void SetRandomSeed(uint32_t seed);
+
+    // Pulsarets sounding now
+    size_t GetActiveCount() const;
+
+    // Emissions that replaced a sounding pulsaret, or were dropped for
+    // want of a slot, since Init
+    uint32_t GetStolenCount() const { return stolen_; }
+    uint32_t GetDroppedCount() const { return dropped_; }
+
+private:
+    // Render size samples of every occupied group into out
+    void Sweep(float* out, size_t size);
+
+    // Start a pulsaret offset samples before the current one
+    void Emit(float offset);
+
+    // Slot for a new pulsaret under the steal policy, or -1 to drop it
+    int AllocateSlot();
+
+    // Current level of a sounding pulsaret, for QUIETEST
+    float SlotLevel(size_t slot) const;
+
+    // Samples to the next emission, jitter applied
+    float NextInterval();
+
+    float sampleRate_;
+    float invSampleRate_;
+    size_t capacity_;
+    StealPolicy stealPolicy_;
+
+    // Emission schedule; untilEmission_ counts from the next sample to
+    // render and may be up to one sample in the past
+    float interval_;
+    float jitter_;
+    float untilEmission_;
+    uint32_t emissions_;
+
+    // Settings taken by the next pulsaret
+    float pulsaretIncrement_;
+    uint32_t nextWaveRowA_;
+    uint32_t nextWaveRowB_;
+    float nextWaveMorph_;
+    float nextNoiseWeight_;
+    uint32_t nextEnvRowA_;
+    uint32_t nextEnvRowB_;
+    float nextEnvMorph_;
+    float amplitude_;
+
+    // Masking
+    MaskingMode maskingMode_;
+    int burstCount_;
+    int restCount_;
+    int burstPosition_;
+    float maskingProbability_;
+
+    // One draw per emission from masking_, per interval from jitterStream_
+    RandomStream masking_;
+    RandomStream jitterStream_;
+
+    // Bit per occupied slot
+    uint32_t occupied_;
+    uint32_t stolen_;
+    uint32_t dropped_;
+
+    // Structure-of-arrays slot state. Free slots hold zero gain and
+    // increment, so they sound nothing and never end.
+    alignas(32) float phase_[MAX_PULSARETS];
+    alignas(32) float increment_[MAX_PULSARETS];
+    alignas(32) float gain_[MAX_PULSARETS];
+    alignas(32) uint32_t waveRowA_[MAX_PULSARETS];
+    alignas(32) uint32_t waveRowB_[MAX_PULSARETS];
+    alignas(32) float waveMorph_[MAX_PULSARETS];
+    alignas(32) float noiseWeight_[MAX_PULSARETS];
+    alignas(32) uint32_t envRowA_[MAX_PULSARETS];
+    alignas(32) uint32_t envRowB_[MAX_PULSARETS];
+    alignas(32) float envMorph_[MAX_PULSARETS];
+
+    // Per-slot noise stream keys, all at the shared noisePosition_,
+    // which counts output samples
+    alignas(32) uint32_t noiseKey_[MAX_PULSARETS];
+    uint32_t noisePosition_;
+
+    // Emission count when each slot was filled, for OLDEST
+    uint32_t emitted_[MAX_PULSARETS];
+};
+
+#endif // PULSAR_CLOUD_HPP
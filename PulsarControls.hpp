@@ -0,0 +1,118 @@
+#pragma once
+#ifndef PULSAR_CONTROLS_HPP
+#define PULSAR_CONTROLS_HPP
+
+#include "FastMath.hpp"
+#include "PulsarEngine.hpp"
+#include <cmath>
+
+// Versio panel to engine parameter mapping, shared by the firmware and
+// the host tools so that both hear the same thing for the same panel.
+
+// Base frequencies for each range
+static constexpr float BASE_FREQ_LOW = 4.0f;      // LFO range
+static constexpr float BASE_FREQ_MID = 65.41f;    // C2
+static constexpr float BASE_FREQ_HIGH = 261.63f;  // C4
+
+// V/Oct input range after calibration
+static constexpr float PITCH_VOLTS_MAX = 5.0f;
+
+// Default output level
+static constexpr float DEFAULT_OUTPUT_LEVEL = 0.8f;
+
+static constexpr int NUM_PANEL_KNOBS = 7;
+
+// Three-position toggle, as seen from the front panel
+enum class SwitchPosition {
+    LEFT = 0,
+    CENTER,
+    RIGHT
+};
+
+// Panel state in the units the control loop reads it
+struct PanelState {
+    // KNOB_0 is the V/Oct input in calibrated volts (0.0 to 5.0);
+    // KNOB_1 to KNOB_6 are 0.0 to 1.0
+    float knobs[NUM_PANEL_KNOBS] = {0.0f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f,
+                                    DEFAULT_OUTPUT_LEVEL};
+
+    // Top switch: masking mode. Bottom switch: frequency range.
+    SwitchPosition maskSwitch = SwitchPosition::LEFT;
+    SwitchPosition rangeSwitch = SwitchPosition::CENTER;
+};
+
+// Module-wide engine modes the firmware runs with
+inline void ConfigureEngine(PulsarEngine& engine) {
+    engine.SetAmplitude(DEFAULT_OUTPUT_LEVEL);
+    engine.SetEdgeMode(EdgeMode::BAND_LIMITED);
+    engine.SetFoldOversampling(2);
+    engine.SetFoldMode(FoldMode::ADAA);
+}
+
+// Map the panel onto params, with the V/Oct input given as the ratio
+// 2^volts (the firmware looks it up in its calibration table) in place
+// of knobs[0]. Fields a mode does not use (burst ratio outside BURST,
+// probability outside STOCHASTIC, spread outside OFF) keep their
+// values.
+inline void ApplyPanel(const PanelState& panel, float pitchRatio, PulsarParams& params) {
+    // Top switch: LEFT = OFF, CENTER = BURST, RIGHT = STOCHASTIC
+    switch (panel.maskSwitch) {
+        case SwitchPosition::LEFT:   params.maskingMode = MaskingMode::OFF; break;
+        case SwitchPosition::CENTER: params.maskingMode = MaskingMode::BURST; break;
+        case SwitchPosition::RIGHT:  params.maskingMode = MaskingMode::STOCHASTIC; break;
+    }
+
+    // Stochastic masking scatters pulsars at random; otherwise they
+    // alternate between the outputs, which suits burst patterns
+    params.spatialMode = (params.maskingMode == MaskingMode::STOCHASTIC)
+                             ? SpatialMode::SCATTER
+                             : SpatialMode::ALTERNATE;
+
+    // Bottom switch: LEFT = LO (LFO), CENTER = MID, RIGHT = HI
+    float baseFreq = BASE_FREQ_MID;
+    switch (panel.rangeSwitch) {
+        case SwitchPosition::LEFT:   baseFreq = BASE_FREQ_LOW; break;
+        case SwitchPosition::CENTER: baseFreq = BASE_FREQ_MID; break;
+        case SwitchPosition::RIGHT:  baseFreq = BASE_FREQ_HIGH; break;
+    }
+
+    // KNOB_0: V/oct pitch
+    params.frequency = baseFreq * pitchRatio;
+
+    // KNOB_1: Formant ratio (duty cycle)
+    // 0 = short duty (bright), 1 = full duty (mellow)
+    params.formantRatio = 0.05f + panel.knobs[1] * 0.95f;
+
+    // KNOB_2, KNOB_3: Pulsaret waveform and envelope (0-6 morph)
+    params.waveformMorph = panel.knobs[2] * 6.0f;
+    params.envelopeMorph = panel.knobs[3] * 6.0f;
+
+    // KNOB_4: Stereo spread OR burst count OR masking probability
+    // KNOB_5: Rest count OR fold amount
+    float knob4 = panel.knobs[4];
+    float knob5 = panel.knobs[5];
+    if (params.maskingMode == MaskingMode::OFF) {
+        // No masking, KNOB_4 spreads pulsars between the outputs and
+        // KNOB_5 controls fold
+        params.spread = knob4;
+        params.fold = knob5;
+    } else if (params.maskingMode == MaskingMode::BURST) {
+        params.burstCount = 1 + static_cast<int>(knob4 * 7.0f);  // 1-8
+        params.restCount = static_cast<int>(knob5 * 7.0f);       // 0-7
+        params.fold = 0.0f;
+    } else {
+        params.maskingProbability = knob4;
+        params.fold = knob5;
+    }
+
+    // KNOB_6: Output level
+    params.amplitude = panel.knobs[6];
+}
+
+// Map the panel onto params, V/Oct from knobs[0] in volts
+inline void ApplyPanel(const PanelState& panel, PulsarParams& params) {
+    float volts = fmaxf(0.0f, fminf(PITCH_VOLTS_MAX, panel.knobs[0]));
+    ApplyPanel(panel, fastmath::Exp2(volts), params);
+}
+
+#endif // PULSAR_CONTROLS_HPP
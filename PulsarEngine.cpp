@@ -1,19 +1,361 @@
 #include "PulsarEngine.hpp"
+#include "FastMath.hpp"
+#include "PulsarKernels.hpp"
+#include "PulsarSimd.hpp"
+#include "PulsaretShapes.hpp"
+#include "PulsaretTables.hpp"
+#include "SampledPulsaret.hpp"
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846f
-#endif
+using namespace pulsaret;
+
+namespace {
+
+const WaveformFn kWaveformFns[] = {
+    WaveSine, WaveTriangle, WaveSawUp, WaveSawDown,
+    WaveSquare, WavePulse, WaveNoise
+};
+
+const EnvelopeFn kEnvelopeFns[] = {
+    EnvRectangular, EnvGaussian, EnvExpoDec, EnvLinearDecay,
+    EnvLinearAttack, EnvExpoAttack, EnvFof
+};
+
+// Shapes with steps inside the pulsaret, which a table smears across a cell
+inline bool HasSteps(PulsaretWaveform shape) {
+    return shape == PulsaretWaveform::SQUARE || shape == PulsaretWaveform::PULSE;
+}
+
+// Waveform morph pair, resolved once per block. Table lookup replaces
+// the computed shapes, except for NOISE, and except for stepped shapes
+// when their edges are band-limited (the correction assumes an exact step).
+// A sampled pulsaret replaces the pair altogether.
+struct WaveShape {
+    const float* tableA;
+    const float* tableB;
+    WaveformFn fnA;
+    WaveformFn fnB;
+    PulsaretWaveform shapeA;
+    PulsaretWaveform shapeB;
+    float morph;
+    bool morphing;
+    bool sampled;
+    SampledPulsaret::Reader reader;
+
+    void Resolve(PulsaretWaveform a, PulsaretWaveform b, float m, bool tables,
+                 bool exactSteps) {
+        shapeA = a;
+        shapeB = b;
+        bool useTableA = tables && a != PulsaretWaveform::NOISE && !(exactSteps && HasSteps(a));
+        bool useTableB = tables && b != PulsaretWaveform::NOISE && !(exactSteps && HasSteps(b));
+        tableA = useTableA ? PulsaretTables::Waveform(a) : nullptr;
+        tableB = useTableB ? PulsaretTables::Waveform(b) : nullptr;
+        fnA = kWaveformFns[static_cast<int>(a)];
+        fnB = kWaveformFns[static_cast<int>(b)];
+        morph = m;
+        morphing = m > 0.0f;
+        sampled = false;
+    }
+
+    // Play sample at a pulsaret phase step per sample, which selects
+    // its mipmap levels
+    void UseSample(const SampledPulsaret& sample, float phaseStep) {
+        reader = sample.Select(phaseStep);
+        sampled = true;
+    }
+
+    // Whether operator() uses its noise draw
+    bool Noisy() const {
+        return !sampled && (shapeA == PulsaretWaveform::NOISE ||
+                            (morphing && shapeB == PulsaretWaveform::NOISE));
+    }
+
+    float operator()(float phase, float noise) const {
+        if (sampled) {
+            return reader(phase);
+        }
+        float sample = tableA ? PulsaretTables::Lookup(tableA, phase) : fnA(phase, noise);
+        if (morphing) {
+            float next = tableB ? PulsaretTables::Lookup(tableB, phase) : fnB(phase, noise);
+            sample += (next - sample) * morph;
+        }
+        return sample;
+    }
+
+    // Deterministic part of the shape, for edge heights; NOISE counts
+    // as zero
+    float EdgeValue(float phase) const {
+        if (sampled) {
+            return reader(phase);
+        }
+        float a = tableA ? PulsaretTables::Lookup(tableA, phase) : fnA(phase, 0.0f);
+        float b = tableB ? PulsaretTables::Lookup(tableB, phase) : fnB(phase, 0.0f);
+        return a + (b - a) * morph;
+    }
+};
+
+// Envelope morph pair, resolved once per block
+struct EnvShape {
+    const float* tableA;
+    const float* tableB;
+    EnvelopeFn fnA;
+    EnvelopeFn fnB;
+    float morph;
+    bool morphing;
+
+    void Resolve(PulsaretEnvelope a, PulsaretEnvelope b, float m, bool tables) {
+        tableA = tables ? PulsaretTables::Envelope(a) : nullptr;
+        tableB = tables ? PulsaretTables::Envelope(b) : nullptr;
+        fnA = kEnvelopeFns[static_cast<int>(a)];
+        fnB = kEnvelopeFns[static_cast<int>(b)];
+        morph = m;
+        morphing = m > 0.0f;
+    }
+
+    float operator()(float phase) const {
+        float env = tableA ? PulsaretTables::Lookup(tableA, phase) : fnA(phase);
+        if (morphing) {
+            float next = tableB ? PulsaretTables::Lookup(tableB, phase) : fnB(phase);
+            env += (next - env) * morph;
+        }
+        return env;
+    }
+};
+
+// Discontinuity in the pulsar train, at a fixed fundamental phase
+struct Edge {
+    float position;    // Fundamental phase of the edge
+    float valueBefore; // Signal just before the edge
+    float valueAfter;  // Signal just after the edge
+    float slopeStep;   // Change of slope, per sample
+    bool periodStart;  // At the wrap: the two sides belong to different pulsars
+};
+
+// Room for start, end and two internal edges per shape of the morph pair
+static constexpr int MAX_EDGES_PER_FORMANT = 6;
+
+// Internal edges of one waveform (as pulsaret phase, value step, slope
+// step per unit of pulsaret phase)
+int WaveformEdges(PulsaretWaveform shape, float* at, float* step, float* slope) {
+    switch (shape) {
+        case PulsaretWaveform::TRIANGLE:
+            at[0] = 0.25f; step[0] = 0.0f; slope[0] = -8.0f;
+            at[1] = 0.75f; step[1] = 0.0f; slope[1] = 8.0f;
+            return 2;
+        case PulsaretWaveform::SQUARE:
+            at[0] = 0.5f; step[0] = -2.0f; slope[0] = 0.0f;
+            return 1;
+        case PulsaretWaveform::PULSE:
+            at[0] = 0.25f; step[0] = -1.33f; slope[0] = 0.0f;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Collect the discontinuities of one formant's pulsaret: its start at
+// phase 0, its end at the duty cycle and the waveform's own edges
+int CollectEdges(Edge* edges, const WaveShape& wave, const EnvShape& env,
+                 float duty, float gain, float increment) {
+    const float delta = 1.0f / static_cast<float>(WAVETABLE_SIZE);
+    // Pulsaret phase units to per-sample units
+    const float slopeScale = increment / duty;
+    int count = 0;
+
+    float start = wave.EdgeValue(0.0f) * env(0.0f) * gain;
+    float startSlope = (wave.EdgeValue(delta) * env(delta) * gain - start) / delta;
+    float end = wave.EdgeValue(1.0f) * env(1.0f) * gain;
+    float endSlope = (end - wave.EdgeValue(1.0f - delta) * env(1.0f - delta) * gain) / delta;
+
+    // With a full duty cycle the pulsaret runs straight into the next one
+    bool full = duty >= 1.0f;
+    edges[count++] = Edge{0.0f, full ? end : 0.0f, start,
+                          (startSlope - (full ? endSlope : 0.0f)) * slopeScale, true};
+    if (!full) {
+        edges[count++] = Edge{duty, end, 0.0f, -endSlope * slopeScale, false};
+    }
+
+    // Corners inside a sample are left to its mipmap
+    const PulsaretWaveform shapes[2] = {wave.shapeA, wave.shapeB};
+    const float weights[2] = {1.0f - wave.morph, wave.morph};
+    for (int s = 0; s < 2 && !wave.sampled; ++s) {
+        if (weights[s] <= 0.0f) {
+            continue;
+        }
+        float at[2];
+        float step[2];
+        float slope[2];
+        int n = WaveformEdges(shapes[s], at, step, slope);
+        for (int e = 0; e < n; ++e) {
+            float scale = weights[s] * env(at[e]) * gain;
+            edges[count++] = Edge{at[e] * duty, 0.0f, step[e] * scale,
+                                  slope[e] * scale * slopeScale, false};
+        }
+    }
+    return count;
+}
+
+// Whether phase is within one sample of an edge at position
+inline bool NearPosition(float phase, float position, float increment) {
+    float t = phase - position;
+    if (t < 0.0f) {
+        t += 1.0f;
+    }
+    return t < increment || t > 1.0f - increment;
+}
+
+// Whether any edge CollectEdges would report for this formant is within
+// one sample of phase. Only needs the positions, not the shape values.
+bool NearEdges(const WaveShape& wave, float duty, float phase, float increment) {
+    if (NearPosition(phase, 0.0f, increment) ||
+        (duty < 1.0f && NearPosition(phase, duty, increment))) {
+        return true;
+    }
+
+    const PulsaretWaveform shapes[2] = {wave.shapeA, wave.shapeB};
+    const float weights[2] = {1.0f - wave.morph, wave.morph};
+    for (int s = 0; s < 2 && !wave.sampled; ++s) {
+        if (weights[s] <= 0.0f) {
+            continue;
+        }
+        float at[2];
+        float step[2];
+        float slope[2];
+        int n = WaveformEdges(shapes[s], at, step, slope);
+        for (int e = 0; e < n; ++e) {
+            if (NearPosition(phase, at[e] * duty, increment)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Fold inputs beyond this are clamped, which also catches NaN and Inf
+static constexpr float FOLD_LIMIT = 1024.0f;
+
+// Below this input step ADAA falls back to folding the midpoint
+static constexpr float ADAA_EPSILON = 1.0e-3f;
+
+// Fold input to a position in the fold's period of 4, offset so that
+// t = 1 is x = 0
+inline float FoldPosition(float x) {
+    // fminf returns the other operand for NaN
+    x = fmaxf(-FOLD_LIMIT, fminf(FOLD_LIMIT, x));
+    float t = x + 1.0f;
+    return t - 4.0f * floorf(t * 0.25f);
+}
+
+// Triangle fold, reflecting at -1 and 1
+inline float Fold(float x) {
+    return 1.0f - fabsf(FoldPosition(x) - 2.0f);
+}
+
+// Antiderivative of Fold: periodic, since the fold integrates to zero
+// over a period, and zero at each period boundary
+inline float FoldIntegral(float x) {
+    float t = FoldPosition(x);
+    float rising = t * (0.5f * t - 1.0f);
+    float falling = 3.0f * (t - 2.0f) - 0.5f * (t * t - 4.0f);
+    return (t <= 2.0f) ? rising : falling;
+}
+
+// Highest fundamental, as a fraction of the sample rate
+static constexpr float MAX_INCREMENT = 0.45f;
+
+// Morph position (0.0 to 6.0) to a shape pair and weight
+inline void SplitMorph(float morphValue, int& idx, int& next, float& morph) {
+    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
+    idx = static_cast<int>(morphValue);
+    next = (idx < 6) ? idx + 1 : 6;
+    morph = morphValue - static_cast<float>(idx);
+}
+
+// Shortest silent stretch worth leaving the renderers for
+static constexpr size_t MIN_SILENT_RUN = 16;
+
+// Phase after n samples, with the increment ramping by step before each
+// sample as in Render
+inline float PhaseAfter(float phase, float increment, float step, size_t n) {
+    float k = static_cast<float>(n);
+    return phase + k * (increment + step * 0.5f * (k + 1.0f));
+}
+
+// Number of samples, at most limit, that start below target. Rounding
+// can put it a sample out from the renderers' phase, so it only decides
+// where to split a run, which leaves the output as it is.
+size_t SamplesBelow(float phase, float increment, float step, float target,
+                    size_t limit) {
+    if (phase >= target) {
+        return 0;
+    }
+
+    // Root of step/2 n^2 + (increment + step/2) n = target - phase, in
+    // the form that holds as step goes to zero, then settle its rounding
+    float distance = target - phase;
+    float b = increment + 0.5f * step;
+    float root = b * b + 2.0f * step * distance;
+    float estimate = (root > 0.0f && b > 0.0f) ? 2.0f * distance / (b + sqrtf(root))
+                                                : static_cast<float>(limit);
+    size_t n = (estimate < static_cast<float>(limit))
+                   ? static_cast<size_t>(ceilf(estimate)) : limit;
+    n = (n > 0) ? n : 1;
+    while (n > 1 && PhaseAfter(phase, increment, step, n - 1) >= target) {
+        --n;
+    }
+    while (n < limit && PhaseAfter(phase, increment, step, n) < target) {
+        ++n;
+    }
+    return n;
+}
 
-static constexpr float TWO_PI = 2.0f * M_PI;
+// First rising zero crossing of in[from, size): the first i with
+// in[i - 1] <= 0 and in[i] > 0, where in[from - 1] is given as prev.
+// Scans simd::WIDTH samples at a time; returns size if there is none.
+size_t NextCrossing(const float* in, size_t from, size_t size, float prev) {
+    using namespace simd;
+    if (from >= size) {
+        return size;
+    }
+    if (prev <= 0.0f && in[from] > 0.0f) {
+        return from;
+    }
+    const Float zero = Set1(0.0f);
+    size_t i = from + 1;
+    for (; i + WIDTH <= size; i += WIDTH) {
+        int bits = Bits((zero >= LoadUnaligned(in + i - 1)) & (zero < LoadUnaligned(in + i)));
+        if (bits != 0) {
+            while ((bits & 1) == 0) {
+                bits >>= 1;
+                ++i;
+            }
+            return i;
+        }
+    }
+    for (; i < size; ++i) {
+        if (in[i - 1] <= 0.0f && in[i] > 0.0f) {
+            return i;
+        }
+    }
+    return size;
+}
+
+}  // namespace
 
 void PulsarEngine::Init(float sampleRate) {
     sampleRate_ = sampleRate;
     invSampleRate_ = 1.0f / sampleRate;
 
+    PulsaretTables::Init();
+    shapeLookup_ = ShapeLookup::TABLE;
+    edgeMode_ = EdgeMode::SMOOTHED;
+    sample_ = nullptr;
+
     phase_ = 0.0f;
     pulsaretPhase_ = 0.0f;
-    phaseIncrement_ = 0.0f;
+    phaseIncrement_.Jump(0.0f);
 
     fundamentalFreq_ = 220.0f;
     formantFreq_ = 440.0f;
@@ -27,7 +369,25 @@ void PulsarEngine::Init(float sampleRate) {
     envelopeNext_ = PulsaretEnvelope::GAUSSIAN;
     envelopeMorph_ = 0.0f;
 
-    foldAmount_ = 0.0f;
+    formantCount_ = 1;
+    primaryGain_ = 1.0f;
+    for (int k = 0; k < MAX_FORMANTS - 1; ++k) {
+        extraFormants_[k].dutyCycle = 0.5f;
+        extraFormants_[k].waveform = PulsaretWaveform::SINE;
+        extraFormants_[k].waveformNext = PulsaretWaveform::SINE;
+        extraFormants_[k].waveformMorph = 0.0f;
+        extraFormants_[k].gain = 0.0f;
+    }
+
+    foldAmount_.Jump(0.0f);
+    foldMode_ = FoldMode::DIRECT;
+    foldOversampling_ = 1;
+    foldEngaged_ = false;
+    foldTail_ = 0;
+    foldPrevInput_ = 0.0f;
+    foldPrevIntegral_ = FoldIntegral(0.0f);
+    foldRestart_ = true;
+    foldOversampler_.Init(foldOversampling_);
 
     maskingMode_ = MaskingMode::OFF;
     burstCount_ = 4;
@@ -35,14 +395,30 @@ void PulsarEngine::Init(float sampleRate) {
     burstPosition_ = 0;
     maskingProbability_ = 1.0f;
     currentPulsarMasked_ = false;
+    previousPulsarMasked_ = false;
 
     inPulsaret_ = true;
-    amplitude_ = 1.0f;
-
-    randomSeed_ = 12345;
+    amplitude_.Jump(1.0f);
+
+    clock_ = 0;
+    pulsarCount_ = 0;
+    placements_[0].start = 0;
+    placements_[0].pulsar = 0;
+    placementCount_ = 1;
+    oldestPlacement_ = 0;
+    spatialMode_ = SpatialMode::ALTERNATE;
+    spread_ = 0.0f;
+
+    SetRandomSeed(rng::DEFAULT_SEED);
     prevSample_ = 0.0f;
+    prevSyncIn_ = 0.0f;
 
     SetFrequency(fundamentalFreq_);
+    phaseIncrement_.End();
+
+    params_.Init(PulsarParams());
+    resetCount_ = 0;
+    paramsApplied_ = false;
 }
 
 void PulsarEngine::Reset() {
@@ -50,85 +426,902 @@ void PulsarEngine::Reset() {
     pulsaretPhase_ = 0.0f;
     burstPosition_ = 0;
     currentPulsarMasked_ = false;
+    previousPulsarMasked_ = false;
     inPulsaret_ = true;
     prevSample_ = 0.0f;
+    PlacePulsar(clock_);
 }
 
-void PulsarEngine::Sync() {
-    phase_ = 0.0f;
-    pulsaretPhase_ = 0.0f;
+void PulsarEngine::Sync(float elapsed) {
+    phase_ = fmaxf(0.0f, fminf(1.0f, elapsed)) * phaseIncrement_.value;
+    pulsaretPhase_ = (phase_ < dutyCycle_) ? phase_ / dutyCycle_ : 0.0f;
     inPulsaret_ = true;
     // Check masking for new pulsar
+    previousPulsarMasked_ = currentPulsarMasked_;
     currentPulsarMasked_ = !ShouldEmitPulsar();
+    PlacePulsar(clock_);
 }
 
 float PulsarEngine::Process() {
-    float sample = 0.0f;
+    float sample;
+    BeginBlock(1);
+    RenderSparse(&sample, 1);
+    FinishBlock(&sample, 1);
+    return sample;
+}
 
-    // Calculate duty cycle threshold
-    // dutyCycle_ represents the fraction of the period that is the pulsaret
-    float dutyThreshold = dutyCycle_;
+void PulsarEngine::ProcessBlock(float* out, size_t size) {
+    BeginBlock(size);
+    RenderSparse(out, size);
+    FinishBlock(out, size);
+}
+
+void PulsarEngine::ProcessBlock(const PulsarModulation& mod, float* out, size_t size) {
+    BeginBlock(size);
+    Render<true>(out, size, &mod, 0);
+    FinishBlock(out, size);
+}
 
-    // Are we in the pulsaret portion of the period?
-    inPulsaret_ = (phase_ < dutyThreshold);
+void PulsarEngine::ProcessBlock(const float* syncIn, const float* ringIn,
+                                float* out, float* ringOut, size_t size,
+                                const PulsarModulation* mod) {
+    BeginBlock(size);
+    RenderSynced(syncIn, out, size, mod);
+    FinishBlock(out, size);
+
+    if (ringOut != nullptr) {
+        if (ringIn != nullptr) {
+            for (size_t i = 0; i < size; ++i) {
+                ringOut[i] = out[i] * (1.0f + ringIn[i]);
+            }
+        } else {
+            for (size_t i = 0; i < size; ++i) {
+                ringOut[i] = out[i];
+            }
+        }
+    }
+}
 
-    if (inPulsaret_ && !currentPulsarMasked_) {
-        // Calculate pulsaret phase (0 to 1 within the duty cycle)
-        pulsaretPhase_ = phase_ / dutyThreshold;
+void PulsarEngine::ProcessBlock(const float* syncIn, const float* ringIn,
+                                const PulsarOutput& output, size_t size,
+                                const PulsarModulation* mod) {
+    float* out = output.channels[0];
+    BeginBlock(size);
+    RenderSynced(syncIn, out, size, mod);
+    FinishBlock(out, size);
+
+    if (ringIn != nullptr) {
+        for (size_t i = 0; i < size; ++i) {
+            out[i] *= 1.0f + ringIn[i];
+        }
+    }
+    Spatialize(output, size);
+}
 
-        // Generate waveform with morphing
-        float waveA = GenerateWaveform(pulsaretPhase_, waveform_);
-        float waveB = GenerateWaveform(pulsaretPhase_, waveformNext_);
-        float waveformSample = waveA + (waveB - waveA) * waveformMorph_;
+void PulsarEngine::RenderSynced(const float* syncIn, float* out, size_t size,
+                                const PulsarModulation* mod) {
+    if (syncIn == nullptr || size == 0) {
+        RenderRun(out, 0, size, mod);
+        return;
+    }
 
-        // Generate envelope with morphing
-        float envA = GenerateEnvelope(pulsaretPhase_, envelope_);
-        float envB = GenerateEnvelope(pulsaretPhase_, envelopeNext_);
-        float envelopeSample = envA + (envB - envA) * envelopeMorph_;
+    // Render in segments between sync points so the inner loop never
+    // has to test the sync input. A band-limited sync step is corrected
+    // on the samples either side of it: the one before as soon as the
+    // crossing is found, the one after once its segment is rendered.
+    // Folded or scaled samples are past correcting, as is a sample
+    // before the block.
+    const bool correct = (edgeMode_ == EdgeMode::BAND_LIMITED) && !FoldsInline();
+    const bool deferFold = foldOversampling_ > 1 || foldMode_ == FoldMode::ADAA;
+    size_t start = 0;
+    size_t from = 0;
+    float step = 0.0f;     // Step before out[start], still to correct there
+    float elapsed = 0.0f;  // Samples from the last crossing to out[start]
+    for (;;) {
+        float prev = (from > 0) ? syncIn[from - 1] : prevSyncIn_;
+        size_t i = NextCrossing(syncIn, from, size, prev);
+        RenderRun(out, start, i - start, mod);
+        if (step != 0.0f) {
+            out[start] += step * PolyBlep(elapsed);
+        }
+        if (i == size) {
+            break;
+        }
 
-        // Apply envelope to waveform
-        sample = waveformSample * envelopeSample;
+        // Where the input crossed zero, by linear interpolation
+        float before = (i > 0) ? syncIn[i - 1] : prevSyncIn_;
+        elapsed = syncIn[i] / (syncIn[i] - before);
+
+        // The train where the sync cuts it, and where the new pulsar
+        // starts, as Render's edges would see them
+        step = 0.0f;
+        float cut = 0.0f;
+        if (correct && !currentPulsarMasked_) {
+            float phase = phase_ - elapsed * phaseIncrement_.value;
+            cut = TrainValue((phase > 0.0f) ? phase : 0.0f);
+        }
+        Sync(elapsed);
+        if (correct) {
+            float restart = currentPulsarMasked_ ? 0.0f : TrainValue(0.0f);
+            step = (restart - cut) * (deferFold ? 1.0f : amplitude_.value);
+            // PolyBlep's residual before the step, kept on this side of
+            // it when the crossing lands on the earlier sample
+            if (i > 0) {
+                out[i - 1] += step * 0.5f * elapsed * elapsed;
+            }
+        }
+        start = i;
+        from = i + 1;
+    }
+    prevSyncIn_ = syncIn[size - 1];
+}
 
-        // Apply wavefolding
-        if (foldAmount_ > 0.001f) {
-            sample = ApplyFold(sample);
+float PulsarEngine::TrainValue(float phase) const {
+    const bool tables = (shapeLookup_ == ShapeLookup::TABLE);
+    const bool bandLimited = (edgeMode_ == EdgeMode::BAND_LIMITED);
+    EnvShape env;
+    env.Resolve(envelope_, envelopeNext_, envelopeMorph_, tables);
+
+    float value = 0.0f;
+    if (phase < dutyCycle_) {
+        WaveShape wave;
+        wave.Resolve(waveform_, waveformNext_, waveformMorph_, tables, bandLimited);
+        if (sample_ != nullptr) {
+            wave.UseSample(*sample_, phaseIncrement_.value / dutyCycle_);
+        }
+        float pulsaretPhase = phase / dutyCycle_;
+        value = wave.EdgeValue(pulsaretPhase) * env(pulsaretPhase) * primaryGain_;
+    }
+    for (int k = 0; k < formantCount_ - 1; ++k) {
+        const Formant& f = extraFormants_[k];
+        if (phase < f.dutyCycle) {
+            WaveShape wave;
+            wave.Resolve(f.waveform, f.waveformNext, f.waveformMorph, tables, bandLimited);
+            float pulsaretPhase = phase / f.dutyCycle;
+            value += wave.EdgeValue(pulsaretPhase) * env(pulsaretPhase) * f.gain;
+        }
+    }
+    return value;
+}
+
+void PulsarEngine::Publish(const PulsarParams& params) {
+    params_.Publish(params);
+}
+
+void PulsarEngine::BeginBlock(size_t size) {
+    if (params_.Acquire()) {
+        ApplyParams(params_.Read());
+    }
+
+    // Let go of placements that ended before the first sample this
+    // block outputs, which the fold delays
+    const uint32_t outputStart = clock_ - static_cast<uint32_t>(foldOversampler_.Latency());
+    while (placementCount_ - oldestPlacement_ > 1) {
+        const Placement& next = placements_[(oldestPlacement_ + 1) % MAX_PLACEMENTS];
+        if (static_cast<int32_t>(next.start - outputStart) > 0) {
+            break;
         }
+        oldestPlacement_++;
+    }
 
-        // Apply amplitude
-        sample *= amplitude_;
+    if (size == 0) {
+        return;
+    }
+    phaseIncrement_.Begin(size);
+    foldAmount_.Begin(size);
+    amplitude_.Begin(size);
+}
+
+void PulsarEngine::ApplyParams(const PulsarParams& params) {
+    if (params.resetCount != resetCount_) {
+        resetCount_ = params.resetCount;
+        Reset();
+    }
+
+    // Only fields that differ from the last snapshot go through their
+    // setters. The duty cycle is worked out from the frequency, so a new
+    // frequency takes the formant ratio again.
+    const PulsarParams& last = applied_;
+    const bool all = !paramsApplied_;
+    const bool frequency = all || params.frequency != last.frequency;
+    if (frequency) {
+        SetFrequency(params.frequency);
+    }
+    if (frequency || params.formantRatio != last.formantRatio) {
+        SetFormantRatio(params.formantRatio);
+    }
+    if (all || params.waveformMorph != last.waveformMorph) {
+        SetWaveformMorph(params.waveformMorph);
+    }
+    if (all || params.envelopeMorph != last.envelopeMorph) {
+        SetEnvelopeMorph(params.envelopeMorph);
+    }
+    if (all || params.fold != last.fold) {
+        SetFold(params.fold);
+    }
+    if (all || params.amplitude != last.amplitude) {
+        SetAmplitude(params.amplitude);
+    }
+    if (all || params.maskingMode != last.maskingMode) {
+        SetMaskingMode(params.maskingMode);
+    }
+    if (all || params.burstCount != last.burstCount || params.restCount != last.restCount) {
+        SetBurstRatio(params.burstCount, params.restCount);
     }
+    if (all || params.maskingProbability != last.maskingProbability) {
+        SetMaskingProbability(params.maskingProbability);
+    }
+    if (all || params.spatialMode != last.spatialMode) {
+        SetSpatialMode(params.spatialMode);
+    }
+    if (all || params.spread != last.spread) {
+        SetSpread(params.spread);
+    }
+    if (all || params.sample != last.sample) {
+        SetSample(params.sample);
+    }
+    applied_ = params;
+    paramsApplied_ = true;
+}
+
+void PulsarEngine::FinishBlock(float* out, size_t size) {
+    if (foldOversampling_ <= 1 && foldMode_ == FoldMode::DIRECT) {
+        // Render has already run the ramps
+        phaseIncrement_.End();
+        foldAmount_.End();
+        amplitude_.End();
+        return;
+    }
+
+    // The fold only runs while engaged, and for one filter latency
+    // after it goes to zero so that folded samples still in the filters
+    // come out. In between, the oversampler keeps the same delay, and
+    // ADAA restarts from its next input.
+    bool active = foldAmount_.value > 0.001f || foldAmount_.target > 0.001f;
+    if (active) {
+        foldTail_ = foldOversampler_.Latency() + 1;
+    }
+    bool engaged = active || foldTail_ > 0;
+    if (!active) {
+        foldTail_ = (foldTail_ > static_cast<int>(size)) ? foldTail_ - static_cast<int>(size) : 0;
+    }
+    if (engaged) {
+        if (!foldEngaged_) {
+            foldRestart_ = true;
+        }
+        foldOversampler_.Process(out, size, [this](float* io, size_t n) {
+            FoldBlock(io, n);
+        });
+    } else {
+        foldOversampler_.Bypass(out, size);
+    }
+    foldEngaged_ = engaged;
+
+    float amplitude = amplitude_.value;
+    const float amplitudeStep = amplitude_.step;
+    for (size_t i = 0; i < size; ++i) {
+        amplitude += amplitudeStep;
+        out[i] *= amplitude;
+    }
+
+    phaseIncrement_.End();
+    foldAmount_.End();
+    amplitude_.End();
+}
+
+float PulsarEngine::PulsaretEnd() const {
+    float end = dutyCycle_;
+    for (int k = 0; k < formantCount_ - 1; ++k) {
+        end = fmaxf(end, extraFormants_[k].dutyCycle);
+    }
+    return end;
+}
+
+void PulsarEngine::SilentWindow(bool masked, float& start, float& end) const {
+    // Band-limited edges reach a sample either side of their position,
+    // at up to the largest increment left in the block
+    float margin = (edgeMode_ == EdgeMode::BAND_LIMITED)
+                       ? fmaxf(phaseIncrement_.value, phaseIncrement_.target) : 0.0f;
+    end = 1.0f - margin;
+    if (!masked) {
+        start = PulsaretEnd() + margin;
+    } else if (margin > 0.0f) {
+        // Only the previous pulsar's end edge sounds
+        start = margin;
+    } else {
+        // The fade where the pulsaret ends halves the sample before it,
+        // which is silent unless it came from the previous pulsar
+        start = (prevSample_ == 0.0f) ? 0.0f : PulsaretEnd();
+    }
+}
 
-    // Advance phase
-    float prevPhase = phase_;
-    phase_ += phaseIncrement_;
 
-    // Check for period wrap
-    if (phase_ >= 1.0f) {
-        phase_ -= 1.0f;
+size_t PulsarEngine::ActiveSamples(size_t size) const {
+    const float increment = phaseIncrement_.value;
+    float start;
+    float end;
+    SilentWindow(currentPulsarMasked_, start, end);
 
-        // Update burst position for masking
+    // Up to where this pulsar falls silent, or else to the end of it, as
+    // the next may be masked or fall silent sooner
+    bool worthSkipping = (end - start) * static_cast<float>(MIN_SILENT_RUN) >=
+                         fmaxf(increment, phaseIncrement_.target);
+    float target = (phase_ < start && worthSkipping) ? start : 1.0f;
+    size_t n = SamplesBelow(phase_, increment, phaseIncrement_.step, target, size);
+    return (n > 0) ? n : 1;
+}
+
+size_t PulsarEngine::SkipSilence(float* out, size_t size) {
+    float start;
+    float end;
+    SilentWindow(currentPulsarMasked_, start, end);
+    float phase = phase_;
+    if (phase < start || phase >= end) {
+        return 0;
+    }
+
+    // Step the phase sample by sample as the renderers do, so that
+    // skipping leaves the same state to the last bit
+    float increment = phaseIncrement_.value;
+    const float step = phaseIncrement_.step;
+    float last = phase;
+    size_t count = 0;
+    while (count < size && phase < end) {
+        last = phase;
+        increment += step;
+        phase += increment;
+        ++count;
+    }
+    if (count < MIN_SILENT_RUN && count < size) {
+        return 0;
+    }
+
+    std::fill(out, out + count, 0.0f);
+    inPulsaret_ = last < PulsaretEnd();
+    phaseIncrement_.value = increment;
+
+    // The ramps the renderers would have run
+    const bool deferFold = foldOversampling_ > 1 || foldMode_ == FoldMode::ADAA;
+    if (!deferFold) {
+        if (FoldsInline() && foldAmount_.step != 0.0f) {
+            for (size_t i = 0; i < count; ++i) {
+                foldAmount_.value += foldAmount_.step;
+            }
+        }
+        if (amplitude_.step != 0.0f) {
+            for (size_t i = 0; i < count; ++i) {
+                amplitude_.value += amplitude_.step;
+            }
+        }
+    }
+
+    // Only the last sample can reach the next pulsar
+    if (phase >= 1.0f) {
+        phase -= 1.0f;
         burstPosition_++;
         if (burstPosition_ >= (burstCount_ + restCount_)) {
             burstPosition_ = 0;
         }
-
-        // Check masking for new pulsar
+        previousPulsarMasked_ = currentPulsarMasked_;
         currentPulsarMasked_ = !ShouldEmitPulsar();
+        PlacePulsar(clock_ + static_cast<uint32_t>(count));
+    }
+
+    phase_ = phase;
+    pulsaretPhase_ = (phase < dutyCycle_) ? phase / dutyCycle_ : 0.0f;
+    prevSample_ = 0.0f;
+    Advance(count);
+    return count;
+}
+
+void PulsarEngine::RenderSparse(float* out, size_t size) {
+    // Pulsars too short to hold a silent stretch worth skipping are
+    // rendered straight through
+    const bool sparse = fmaxf(phaseIncrement_.value, phaseIncrement_.target) *
+                            static_cast<float>(MIN_SILENT_RUN) < 1.0f;
+    while (size > 0) {
+        size_t n = sparse ? SkipSilence(out, size) : 0;
+        if (n == 0) {
+            n = sparse ? ActiveSamples(size) : size;
+            Kernel kernel = SelectKernel();
+            if (kernel != nullptr) {
+                (this->*kernel)(out, n);
+            } else {
+                Render<false>(out, n, nullptr, 0);
+            }
+        }
+        out += n;
+        size -= n;
+    }
+}
+
+void PulsarEngine::RenderRun(float* out, size_t start, size_t size,
+                             const PulsarModulation* mod) {
+    if (mod != nullptr) {
+        Render<true>(out + start, size, mod, start);
+    } else {
+        RenderSparse(out + start, size);
     }
+}
 
-    // Smooth transitions at pulsaret boundaries to reduce clicks
-    if (prevPhase < dutyThreshold && phase_ >= dutyThreshold) {
-        // Transitioning from pulsaret to silence - apply small fade
-        sample = prevSample_ * 0.5f;
+// Dispatch tables for RenderKernel, built at compile time. Entries for
+// kernels left out by PULSAR_KERNELS and its masks are null.
+struct KernelTable {
+    typedef PulsarEngine::Kernel Kernel;
+
+    template <bool ENABLED, typename Wave, typename Env, bool FOLD>
+    struct Entry {
+        static constexpr Kernel Get() { return nullptr; }
+    };
+
+    template <typename Wave, typename Env, bool FOLD>
+    struct Entry<true, Wave, Env, FOLD> {
+        static constexpr Kernel Get() { return &PulsarEngine::RenderKernel<Wave, Env, FOLD>; }
+    };
+
+    // Table kernels, by [wave morph][envelope morph][fold]
+    template <bool MW, bool ME, bool FOLD>
+    static constexpr Kernel TableKernel() {
+        return Entry<(PULSAR_KERNELS >= 1), kernel::TableWave<MW>, kernel::TableEnv<ME>,
+                     FOLD>::Get();
     }
 
-    prevSample_ = sample;
-    return sample;
+    static const Kernel table[2][2][2];
+
+#if PULSAR_KERNELS >= 2
+    // Computed kernels, flattened from [waveform][wave morph][envelope]
+    // [envelope morph][fold]. NOISE never gets one, nor does a morph
+    // into it; the last envelope never morphs.
+    static constexpr size_t COMPUTED_SIZE = 7 * 2 * 7 * 2 * 2;
+
+    static constexpr size_t ComputedIndex(int w, bool mw, int e, bool me, bool fold) {
+        return ((((static_cast<size_t>(w) * 2 + mw) * 7 + e) * 2 + me) * 2) + fold;
+    }
+
+    template <size_t I>
+    static constexpr Kernel ComputedKernel() {
+        constexpr int W = static_cast<int>(I / 56);
+        constexpr bool MW = (I / 28) % 2;
+        constexpr int E = static_cast<int>((I / 4) % 7);
+        constexpr bool ME = (I / 2) % 2;
+        constexpr bool FOLD = I % 2;
+        constexpr bool ENABLED = ((PULSAR_KERNEL_WAVEFORMS >> W) & 1) &&
+                                 ((PULSAR_KERNEL_ENVELOPES >> E) & 1) &&
+                                 W < 6 && !(MW && W >= 5) && !(ME && E >= 6);
+        return Entry<ENABLED, kernel::ComputedWave<W, MW>, kernel::ComputedEnv<E, ME>,
+                     FOLD>::Get();
+    }
+
+    template <size_t... I>
+    struct Computed {
+        static constexpr Kernel kernels[sizeof...(I)] = {ComputedKernel<I>()...};
+    };
+
+    template <size_t... I>
+    static constexpr const Kernel* ComputedTable(std::index_sequence<I...>) {
+        return Computed<I...>::kernels;
+    }
+
+    static const Kernel* const computed;
+#endif
+};
+
+const KernelTable::Kernel KernelTable::table[2][2][2] = {
+    {{TableKernel<false, false, false>(), TableKernel<false, false, true>()},
+     {TableKernel<false, true, false>(), TableKernel<false, true, true>()}},
+    {{TableKernel<true, false, false>(), TableKernel<true, false, true>()},
+     {TableKernel<true, true, false>(), TableKernel<true, true, true>()}},
+};
+
+#if PULSAR_KERNELS >= 2
+template <size_t... I>
+constexpr KernelTable::Kernel KernelTable::Computed<I...>::kernels[sizeof...(I)];
+
+const KernelTable::Kernel* const KernelTable::computed =
+    KernelTable::ComputedTable(std::make_index_sequence<KernelTable::COMPUTED_SIZE>());
+#endif
+
+bool PulsarEngine::FoldsInline() const {
+    bool deferFold = foldOversampling_ > 1 || foldMode_ == FoldMode::ADAA;
+    return !deferFold && (foldAmount_.value > 0.001f || foldAmount_.target > 0.001f);
+}
+
+PulsarEngine::Kernel PulsarEngine::SelectKernel() const {
+    if (formantCount_ != 1 || edgeMode_ != EdgeMode::SMOOTHED ||
+        waveform_ == PulsaretWaveform::NOISE || sample_ != nullptr) {
+        return nullptr;
+    }
+    const bool morphWave = waveformMorph_ > 0.0f;
+    const bool morphEnv = envelopeMorph_ > 0.0f;
+    if (morphWave && waveformNext_ == PulsaretWaveform::NOISE) {
+        return nullptr;
+    }
+    const bool fold = FoldsInline();
+    if (shapeLookup_ == ShapeLookup::TABLE) {
+        return KernelTable::table[morphWave][morphEnv][fold];
+    }
+#if PULSAR_KERNELS >= 2
+    return KernelTable::computed[KernelTable::ComputedIndex(
+        static_cast<int>(waveform_), morphWave, static_cast<int>(envelope_), morphEnv,
+        fold)];
+#else
+    return nullptr;
+#endif
+}
+
+template <typename Wave, typename Env, bool FOLD>
+void PulsarEngine::RenderKernel(float* out, size_t size) {
+    const Wave wave(waveform_, waveformNext_, waveformMorph_);
+    const Env env(envelope_, envelopeNext_, envelopeMorph_);
+    const float duty = dutyCycle_;
+    const float invDuty = 1.0f / duty;
+    const float gain = primaryGain_;
+
+    // As in Render: deferred folding leaves amplitude to FinishBlock
+    const bool deferFold = foldOversampling_ > 1 || foldMode_ == FoldMode::ADAA;
+    float increment = phaseIncrement_.value;
+    const float incrementStep = phaseIncrement_.step;
+    float foldAmount = foldAmount_.value;
+    const float foldStep = foldAmount_.step;
+    float amplitude = deferFold ? 1.0f : amplitude_.value;
+    const float amplitudeStep = deferFold ? 0.0f : amplitude_.step;
+
+    float phase = phase_;
+    float prevSample = prevSample_;
+    bool masked = currentPulsarMasked_;
+    bool prevMasked = previousPulsarMasked_;
+    bool inPulsaret = inPulsaret_;
+
+    float shapePhase[kernel::CHUNK];
+    bool sounding[kernel::CHUNK];
+    float drive[kernel::CHUNK];
+    float level[kernel::CHUNK];
+    uint8_t fades[kernel::CHUNK];
+
+    for (size_t base = 0; base < size; base += kernel::CHUNK) {
+        const size_t n = (size - base < kernel::CHUNK) ? size - base : kernel::CHUNK;
+        float* chunk = out + base;
+
+        // Timeline: phase, masking and ramps, which carry from sample
+        // to sample
+        int numFades = 0;
+        for (size_t i = 0; i < n; ++i) {
+            increment += incrementStep;
+            amplitude += amplitudeStep;
+            if (FOLD) {
+                foldAmount += foldStep;
+                drive[i] = 1.0f + foldAmount * 8.0f;
+            }
+            level[i] = amplitude;
+
+            inPulsaret = (phase < duty);
+            sounding[i] = inPulsaret && !masked;
+            shapePhase[i] = phase * invDuty;
+
+            float prevPhase = phase;
+            phase += increment;
+            if (phase >= 1.0f) {
+                phase -= 1.0f;
+                burstPosition_++;
+                if (burstPosition_ >= (burstCount_ + restCount_)) {
+                    burstPosition_ = 0;
+                }
+                prevMasked = masked;
+                masked = !ShouldEmitPulsar();
+                PlacePulsar(clock_ + static_cast<uint32_t>(base + i + 1));
+            }
+            if (prevPhase < duty && phase >= duty) {
+                fades[numFades++] = static_cast<uint8_t>(i);
+            }
+        }
+
+        // Shapes: independent per sample, without branches
+        for (size_t i = 0; i < n; ++i) {
+            float p = shapePhase[i];
+            float sample = wave(p) * env(p) * gain;
+            sample = sounding[i] ? sample : 0.0f;
+            if (FOLD) {
+                sample = Fold(sample * drive[i]);
+            }
+            chunk[i] = sample * level[i];
+        }
+
+        // Half-sample fade where a pulsaret ends, as in Render
+        for (int f = 0; f < numFades; ++f) {
+            size_t i = fades[f];
+            chunk[i] = ((i > 0) ? chunk[i - 1] : prevSample) * 0.5f;
+        }
+        prevSample = chunk[n - 1];
+    }
+
+    phaseIncrement_.value = increment;
+    if (!deferFold) {
+        foldAmount_.value = foldAmount;
+        amplitude_.value = amplitude;
+    }
+
+    phase_ = phase;
+    pulsaretPhase_ = (phase < duty) ? phase * invDuty : 0.0f;
+    prevSample_ = prevSample;
+    currentPulsarMasked_ = masked;
+    previousPulsarMasked_ = prevMasked;
+    inPulsaret_ = inPulsaret;
+    Advance(size);
+}
+
+template <bool MODULATED>
+void PulsarEngine::Render(float* out, size_t size, const PulsarModulation* mod,
+                          size_t offset) {
+    // Everything derived from parameters is resolved once per run
+    // dutyCycle_ represents the fraction of the period that is the pulsaret
+    const float baseDuty = dutyCycle_;
+    float dutyThreshold = baseDuty;
+    float invDuty = 1.0f / dutyThreshold;
+    const float edgeIncrement = phaseIncrement_.target;
+    const bool tables = (shapeLookup_ == ShapeLookup::TABLE);
+    const bool bandLimited = (edgeMode_ == EdgeMode::BAND_LIMITED);
+
+    WaveShape wave;
+    wave.Resolve(waveform_, waveformNext_, waveformMorph_, tables, bandLimited);
+    if (sample_ != nullptr) {
+        // Mipmap levels for the faster end of the frequency ramp, held
+        // for the run whatever the modulation does
+        float increment = fmaxf(phaseIncrement_.value, phaseIncrement_.target);
+        wave.UseSample(*sample_, increment * invDuty);
+    }
+    EnvShape env;
+    env.Resolve(envelope_, envelopeNext_, envelopeMorph_, tables);
+    const float primaryGain = primaryGain_;
+
+    // Extra formants share the phase; the period goes silent after
+    // the longest one ends
+    const int extraFormants = formantCount_ - 1;
+    WaveShape extraWave[MAX_FORMANTS - 1];
+    float extraDuty[MAX_FORMANTS - 1];
+    float extraInvDuty[MAX_FORMANTS - 1];
+    float extraGain[MAX_FORMANTS - 1];
+    float extraEnd = 0.0f;
+    bool extraNoisy = false;
+    for (int k = 0; k < extraFormants; ++k) {
+        const Formant& f = extraFormants_[k];
+        extraWave[k].Resolve(f.waveform, f.waveformNext, f.waveformMorph, tables,
+                             bandLimited);
+        extraDuty[k] = f.dutyCycle;
+        extraInvDuty[k] = 1.0f / f.dutyCycle;
+        extraGain[k] = f.gain;
+        extraEnd = fmaxf(extraEnd, f.dutyCycle);
+        extraNoisy = extraNoisy || extraWave[k].Noisy();
+    }
+    float pulsaretEnd = fmaxf(dutyThreshold, extraEnd);
+
+    // Band-limited edges replace the end-of-pulsaret fade
+    Edge edges[MAX_FORMANTS * MAX_EDGES_PER_FORMANT];
+    int numEdges = 0;
+    if (bandLimited) {
+        numEdges = CollectEdges(edges, wave, env, dutyThreshold, primaryGain,
+                                edgeIncrement);
+        for (int k = 0; k < extraFormants; ++k) {
+            numEdges += CollectEdges(edges + numEdges, extraWave[k], env,
+                                     extraDuty[k], extraGain[k], edgeIncrement);
+        }
+    }
+    float invIncrement = (edgeIncrement > 0.0f) ? 1.0f / edgeIncrement : 0.0f;
+
+    // Ramped parameters advance before each sample
+    float rampedIncrement = phaseIncrement_.value;
+    const float incrementStep = phaseIncrement_.step;
+    float increment = rampedIncrement;
+
+    // Modulation buffers, offset to this run. Modulated shapes and edges
+    // are resolved again per sample; edges only near their position.
+    const float* pitchMod = nullptr;
+    const float* linearFmMod = nullptr;
+    const float* formantMod = nullptr;
+    const float* waveformMod = nullptr;
+    const float* envelopeMod = nullptr;
+    if (MODULATED) {
+        pitchMod = mod->pitch ? mod->pitch + offset : nullptr;
+        linearFmMod = mod->linearFm ? mod->linearFm + offset : nullptr;
+        formantMod = mod->formantRatio ? mod->formantRatio + offset : nullptr;
+        waveformMod = mod->waveformMorph ? mod->waveformMorph + offset : nullptr;
+        envelopeMod = mod->envelopeMorph ? mod->envelopeMorph + offset : nullptr;
+    }
+    const bool frequencyModulated = pitchMod != nullptr || linearFmMod != nullptr;
+    const bool edgesModulated = MODULATED && bandLimited &&
+                                (frequencyModulated || formantMod != nullptr ||
+                                 waveformMod != nullptr || envelopeMod != nullptr);
+    const float baseWaveformMorph = static_cast<float>(waveform_) + waveformMorph_;
+    const float baseEnvelopeMorph = static_cast<float>(envelope_) + envelopeMorph_;
+
+    // Oversampled and ADAA folding happen in FinishBlock, so the run
+    // stays unfolded and at unit amplitude
+    const bool deferFold = foldOversampling_ > 1 || foldMode_ == FoldMode::ADAA;
+    const bool fold = FoldsInline();
+    float foldAmount = foldAmount_.value;
+    const float foldStep = foldAmount_.step;
+    float amplitude = deferFold ? 1.0f : amplitude_.value;
+    const float amplitudeStep = deferFold ? 0.0f : amplitude_.step;
+
+    float phase = phase_;
+    float prevSample = prevSample_;
+    bool masked = currentPulsarMasked_;
+    bool prevMasked = previousPulsarMasked_;
+    bool inPulsaret = inPulsaret_;
+
+    for (size_t i = 0; i < size; ++i) {
+        float sample = 0.0f;
+        rampedIncrement += incrementStep;
+        increment = rampedIncrement;
+        amplitude += amplitudeStep;
+
+        if (MODULATED) {
+            if (frequencyModulated) {
+                // Exponential FM in octaves, linear FM in multiples of
+                // the fundamental; no through-zero
+                float ratio = pitchMod ? fastmath::Exp2(pitchMod[i]) : 1.0f;
+                if (linearFmMod) {
+                    ratio += linearFmMod[i];
+                }
+                increment = fmaxf(0.0f, fminf(MAX_INCREMENT, rampedIncrement * ratio));
+            }
+            if (formantMod) {
+                dutyThreshold = fmaxf(0.01f, fminf(1.0f, baseDuty + formantMod[i]));
+                invDuty = 1.0f / dutyThreshold;
+                pulsaretEnd = fmaxf(dutyThreshold, extraEnd);
+            }
+            if (waveformMod && sample_ == nullptr) {
+                int idx;
+                int next;
+                float morph;
+                SplitMorph(baseWaveformMorph + waveformMod[i], idx, next, morph);
+                wave.Resolve(static_cast<PulsaretWaveform>(idx),
+                             static_cast<PulsaretWaveform>(next), morph, tables,
+                             bandLimited);
+            }
+            if (envelopeMod) {
+                int idx;
+                int next;
+                float morph;
+                SplitMorph(baseEnvelopeMorph + envelopeMod[i], idx, next, morph);
+                env.Resolve(static_cast<PulsaretEnvelope>(idx),
+                            static_cast<PulsaretEnvelope>(next), morph, tables);
+            }
+            if (edgesModulated) {
+                bool near = NearEdges(wave, dutyThreshold, phase, increment);
+                for (int k = 0; k < extraFormants && !near; ++k) {
+                    near = NearEdges(extraWave[k], extraDuty[k], phase, increment);
+                }
+                numEdges = 0;
+                if (near && increment > 0.0f) {
+                    numEdges = CollectEdges(edges, wave, env, dutyThreshold,
+                                            primaryGain, increment);
+                    for (int k = 0; k < extraFormants; ++k) {
+                        numEdges += CollectEdges(edges + numEdges, extraWave[k], env,
+                                                 extraDuty[k], extraGain[k], increment);
+                    }
+                    invIncrement = 1.0f / increment;
+                }
+            }
+        }
+
+        // Are we in the pulsaret portion of the period?
+        inPulsaret = (phase < pulsaretEnd);
+
+        if (inPulsaret && !masked) {
+            // One draw per sample, shared by the formants
+            const float noise = (extraNoisy || wave.Noisy())
+                                    ? noise_.PeekBipolar(static_cast<uint32_t>(i))
+                                    : 0.0f;
+            if (phase < dutyThreshold) {
+                // Calculate pulsaret phase (0 to 1 within the duty cycle)
+                float pulsaretPhase = phase * invDuty;
+
+                // Waveform and envelope, each with morphing
+                sample = wave(pulsaretPhase, noise) * env(pulsaretPhase) *
+                         primaryGain;
+            }
+
+            for (int k = 0; k < extraFormants; ++k) {
+                if (phase < extraDuty[k]) {
+                    float pulsaretPhase = phase * extraInvDuty[k];
+                    sample += extraWave[k](pulsaretPhase, noise) *
+                              env(pulsaretPhase) * extraGain[k];
+                }
+            }
+        }
+
+        // Polynomial corrections for edges within one sample, placed at
+        // their fractional position
+        for (int e = 0; e < numEdges; ++e) {
+            const Edge& edge = edges[e];
+            float t = phase - edge.position;
+            if (t < 0.0f) {
+                t += 1.0f;
+            }
+
+            float x;
+            if (t < increment) {
+                x = t * invIncrement;
+            } else if (t > 1.0f - increment) {
+                x = (t - 1.0f) * invIncrement;
+            } else {
+                continue;
+            }
+
+            // Across the wrap the sides belong to different pulsars;
+            // ahead of it the next pulsar is assumed to match this one
+            bool emitBefore;
+            bool emitAfter;
+            if (edge.periodStart && x >= 0.0f) {
+                emitBefore = !prevMasked;
+                emitAfter = !masked;
+            } else {
+                emitBefore = !masked;
+                emitAfter = !masked;
+            }
+            float before = emitBefore ? edge.valueBefore : 0.0f;
+            float after = emitAfter ? edge.valueAfter : 0.0f;
+            float slope = emitAfter ? edge.slopeStep : 0.0f;
+            sample += (after - before) * PolyBlep(x) + slope * PolyBlamp(x);
+        }
+
+        // Apply wavefolding
+        if (fold) {
+            foldAmount += foldStep;
+            sample = Fold(sample * (1.0f + foldAmount * 8.0f));
+        }
+
+        // Apply amplitude
+        sample *= amplitude;
+
+        // Advance phase
+        float prevPhase = phase;
+        phase += increment;
+
+        // Check for period wrap
+        if (phase >= 1.0f) {
+            phase -= 1.0f;
+
+            // Update burst position for masking
+            burstPosition_++;
+            if (burstPosition_ >= (burstCount_ + restCount_)) {
+                burstPosition_ = 0;
+            }
+
+            // Check masking for new pulsar
+            prevMasked = masked;
+            masked = !ShouldEmitPulsar();
+            PlacePulsar(clock_ + static_cast<uint32_t>(i + 1));
+        }
+
+        // Smooth transitions at pulsaret boundaries to reduce clicks
+        if (!bandLimited && prevPhase < pulsaretEnd && phase >= pulsaretEnd) {
+            // Transitioning from pulsaret to silence - apply small fade
+            sample = prevSample * 0.5f;
+        }
+
+        prevSample = sample;
+        out[i] = sample;
+    }
+
+    phaseIncrement_.value = rampedIncrement;
+    if (!deferFold) {
+        foldAmount_.value = foldAmount;
+        amplitude_.value = amplitude;
+    }
+
+    phase_ = phase;
+    pulsaretPhase_ = (phase < dutyThreshold) ? phase * invDuty : 0.0f;
+    prevSample_ = prevSample;
+    currentPulsarMasked_ = masked;
+    previousPulsarMasked_ = prevMasked;
+    inPulsaret_ = inPulsaret;
+    Advance(size);
 }
 
 void PulsarEngine::SetFrequency(float freq) {
-    fundamentalFreq_ = fmaxf(0.1f, fminf(freq, sampleRate_ * 0.45f));
-    phaseIncrement_ = fundamentalFreq_ * invSampleRate_;
+    fundamentalFreq_ = fmaxf(0.1f, fminf(freq, sampleRate_ * MAX_INCREMENT));
+    phaseIncrement_.target = fundamentalFreq_ * invSampleRate_;
 
     // Update duty cycle based on formant/fundamental ratio
     if (formantFreq_ > 0.1f) {
@@ -164,13 +1357,12 @@ void PulsarEngine::SetWaveform(PulsaretWaveform waveform) {
 }
 
 void PulsarEngine::SetWaveformMorph(float morphValue) {
-    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
-
-    int idx = static_cast<int>(morphValue);
-    waveformMorph_ = morphValue - static_cast<float>(idx);
+    int idx;
+    int next;
+    SplitMorph(morphValue, idx, next, waveformMorph_);
 
     waveform_ = static_cast<PulsaretWaveform>(idx);
-    waveformNext_ = static_cast<PulsaretWaveform>(fminf(6.0f, static_cast<float>(idx + 1)));
+    waveformNext_ = static_cast<PulsaretWaveform>(next);
 }
 
 void PulsarEngine::SetEnvelope(PulsaretEnvelope envelope) {
@@ -180,17 +1372,59 @@ void PulsarEngine::SetEnvelope(PulsaretEnvelope envelope) {
 }
 
 void PulsarEngine::SetEnvelopeMorph(float morphValue) {
-    morphValue = fmaxf(0.0f, fminf(6.0f, morphValue));
-
-    int idx = static_cast<int>(morphValue);
-    envelopeMorph_ = morphValue - static_cast<float>(idx);
+    int idx;
+    int next;
+    SplitMorph(morphValue, idx, next, envelopeMorph_);
 
     envelope_ = static_cast<PulsaretEnvelope>(idx);
-    envelopeNext_ = static_cast<PulsaretEnvelope>(fminf(6.0f, static_cast<float>(idx + 1)));
+    envelopeNext_ = static_cast<PulsaretEnvelope>(next);
+}
+
+void PulsarEngine::SetFormantCount(int count) {
+    formantCount_ = (count < 1) ? 1 : ((count > MAX_FORMANTS) ? MAX_FORMANTS : count);
+}
+
+void PulsarEngine::SetFormant(int formant, float ratio, float waveformMorph, float gain) {
+    if (formant < 0 || formant >= MAX_FORMANTS) {
+        return;
+    }
+    gain = fmaxf(0.0f, fminf(1.0f, gain));
+
+    if (formant == 0) {
+        SetFormantRatio(ratio);
+        SetWaveformMorph(waveformMorph);
+        primaryGain_ = gain;
+        return;
+    }
+
+    Formant& f = extraFormants_[formant - 1];
+    f.dutyCycle = fmaxf(0.01f, fminf(1.0f, ratio));
+    int idx;
+    int next;
+    SplitMorph(waveformMorph, idx, next, f.waveformMorph);
+    f.waveform = static_cast<PulsaretWaveform>(idx);
+    f.waveformNext = static_cast<PulsaretWaveform>(next);
+    f.gain = gain;
 }
 
 void PulsarEngine::SetFold(float amount) {
-    foldAmount_ = fmaxf(0.0f, fminf(1.0f, amount));
+    foldAmount_.target = fmaxf(0.0f, fminf(1.0f, amount));
+}
+
+void PulsarEngine::SetFoldOversampling(int factor) {
+    int clamped = (factor >= 4) ? 4 : ((factor >= 2) ? 2 : 1);
+    if (clamped != foldOversampling_) {
+        foldOversampling_ = clamped;
+        foldOversampler_.Init(clamped);
+        foldEngaged_ = false;
+    }
+}
+
+void PulsarEngine::SetFoldMode(FoldMode mode) {
+    if (mode != foldMode_) {
+        foldMode_ = mode;
+        foldEngaged_ = false;
+    }
 }
 
 void PulsarEngine::SetBurstRatio(int burst, int rest) {
@@ -206,122 +1440,77 @@ void PulsarEngine::SetMaskingMode(MaskingMode mode) {
     maskingMode_ = mode;
 }
 
-void PulsarEngine::SetAmplitude(float amp) {
-    amplitude_ = fmaxf(0.0f, fminf(1.0f, amp));
+void PulsarEngine::SetRandomSeed(uint32_t seed) {
+    noise_.Seed(seed, rng::NOISE);
+    masking_.Seed(seed, rng::MASKING);
+    scatter_.Seed(seed, rng::SCATTER);
 }
 
-float PulsarEngine::GenerateWaveform(float phase, PulsaretWaveform waveform) {
-    float sample = 0.0f;
-
-    switch (waveform) {
-        case PulsaretWaveform::SINE:
-            sample = sinf(phase * TWO_PI);
-            break;
-
-        case PulsaretWaveform::TRIANGLE:
-            if (phase < 0.25f) {
-                sample = phase * 4.0f;
-            } else if (phase < 0.75f) {
-                sample = 1.0f - (phase - 0.25f) * 4.0f;
-            } else {
-                sample = (phase - 0.75f) * 4.0f - 1.0f;
-            }
-            break;
-
-        case PulsaretWaveform::SAW_UP:
-            sample = 2.0f * phase - 1.0f;
-            break;
-
-        case PulsaretWaveform::SAW_DOWN:
-            sample = 1.0f - 2.0f * phase;
-            break;
-
-        case PulsaretWaveform::SQUARE:
-            sample = (phase < 0.5f) ? 1.0f : -1.0f;
-            break;
-
-        case PulsaretWaveform::PULSE:
-            // Narrow pulse (25% duty)
-            sample = (phase < 0.25f) ? 1.0f : -0.33f;
-            break;
-
-        case PulsaretWaveform::NOISE:
-            sample = FastRandom() * 2.0f - 1.0f;
-            break;
-    }
-
-    return sample;
+void PulsarEngine::SetSpatialMode(SpatialMode mode) {
+    spatialMode_ = mode;
 }
 
-float PulsarEngine::GenerateEnvelope(float phase, PulsaretEnvelope envelope) {
-    float env = 1.0f;
-
-    switch (envelope) {
-        case PulsaretEnvelope::RECTANGULAR:
-            env = 1.0f;
-            break;
-
-        case PulsaretEnvelope::GAUSSIAN: {
-            // Gaussian centered at 0.5
-            float x = (phase - 0.5f) * 3.0f;
-            env = expf(-x * x);
-            break;
-        }
-
-        case PulsaretEnvelope::EXPODEC: {
-            // Exponential decay
-            float decay = 4.0f;
-            env = expf(-phase * decay);
-            break;
-        }
-
-        case PulsaretEnvelope::LINEAR_DECAY:
-            env = 1.0f - phase;
-            break;
+void PulsarEngine::SetSpread(float spread) {
+    spread_ = fmaxf(0.0f, fminf(1.0f, spread));
+}
 
-        case PulsaretEnvelope::LINEAR_ATTACK:
-            env = phase;
-            break;
+void PulsarEngine::SetAmplitude(float amp) {
+    amplitude_.target = fmaxf(0.0f, fminf(1.0f, amp));
+}
 
-        case PulsaretEnvelope::EXPO_ATTACK: {
-            // Exponential attack
-            float attack = 4.0f;
-            env = 1.0f - expf(-(phase) * attack);
-            break;
-        }
+void PulsarEngine::SetSample(const SampledPulsaret* sample) {
+    sample_ = (sample != nullptr && !sample->IsEmpty()) ? sample : nullptr;
+}
 
-        case PulsaretEnvelope::FOF: {
-            // FOF-style: sharp attack, exponential decay
-            float attackTime = 0.1f;
-            if (phase < attackTime) {
-                env = phase / attackTime;
-            } else {
-                float decay = 3.0f;
-                env = expf(-(phase - attackTime) * decay);
-            }
-            break;
-        }
-    }
+void PulsarEngine::SetShapeLookup(ShapeLookup lookup) {
+    shapeLookup_ = lookup;
+}
 
-    return env;
+void PulsarEngine::SetEdgeMode(EdgeMode mode) {
+    edgeMode_ = mode;
 }
 
-float PulsarEngine::ApplyFold(float sample) {
-    // West-coast style wavefolding
-    float gain = 1.0f + foldAmount_ * 8.0f;
-    sample *= gain;
+void PulsarEngine::FoldBlock(float* io, size_t size) {
+    // West-coast style wavefolding. The block may be oversampled, so the
+    // fold ramp is spread over factor times as many samples.
+    float amount = foldAmount_.value;
+    const float step = foldAmount_.step / static_cast<float>(foldOversampler_.GetFactor());
 
-    // Fold using sine function for smooth folding
-    while (sample > 1.0f || sample < -1.0f) {
-        if (sample > 1.0f) {
-            sample = 2.0f - sample;
-        }
-        if (sample < -1.0f) {
-            sample = -2.0f - sample;
+    if (foldMode_ == FoldMode::DIRECT) {
+        for (size_t i = 0; i < size; ++i) {
+            amount += step;
+            io[i] = Fold(io[i] * (1.0f + amount * 8.0f));
         }
+        foldAmount_.value = amount;
+        return;
     }
 
-    return sample;
+    // Average of the fold over the segment between consecutive inputs,
+    // as the difference of the antiderivative. Both results are
+    // computed and one selected, so the cost does not depend on the
+    // signal.
+    float prevInput = foldPrevInput_;
+    float prevIntegral = foldPrevIntegral_;
+    if (foldRestart_ && size > 0) {
+        prevInput = fmaxf(-FOLD_LIMIT, fminf(FOLD_LIMIT, io[0] * (1.0f + (amount + step) * 8.0f)));
+        prevIntegral = FoldIntegral(prevInput);
+        foldRestart_ = false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        amount += step;
+        float input = fmaxf(-FOLD_LIMIT, fminf(FOLD_LIMIT, io[i] * (1.0f + amount * 8.0f)));
+        float integral = FoldIntegral(input);
+        float delta = input - prevInput;
+        bool steep = fabsf(delta) > ADAA_EPSILON;
+        float slope = (integral - prevIntegral) / (steep ? delta : 1.0f);
+        float midpoint = Fold(0.5f * (input + prevInput));
+        io[i] = steep ? slope : midpoint;
+        prevInput = input;
+        prevIntegral = integral;
+    }
+    foldAmount_.value = amount;
+    foldPrevInput_ = prevInput;
+    foldPrevIntegral_ = prevIntegral;
 }
 
 bool PulsarEngine::ShouldEmitPulsar() {
@@ -334,14 +1523,108 @@ bool PulsarEngine::ShouldEmitPulsar() {
             return (burstPosition_ < burstCount_);
 
         case MaskingMode::STOCHASTIC:
-            return (FastRandom() < maskingProbability_);
+            return (masking_.Next() < maskingProbability_);
     }
 
     return true;
 }
 
-float PulsarEngine::FastRandom() {
-    // Linear congruential generator
-    randomSeed_ = randomSeed_ * 1664525u + 1013904223u;
-    return static_cast<float>(randomSeed_) / 4294967296.0f;
+void PulsarEngine::Advance(size_t size) {
+    clock_ += static_cast<uint32_t>(size);
+    noise_.Skip(static_cast<uint32_t>(size));
+}
+
+void PulsarEngine::PlacePulsar(uint32_t start) {
+    pulsarCount_++;
+    if (placementCount_ - oldestPlacement_ >= MAX_PLACEMENTS) {
+        return;
+    }
+    Placement& placement = placements_[placementCount_ % MAX_PLACEMENTS];
+    placement.start = start;
+    placement.pulsar = pulsarCount_;
+    placementCount_++;
+}
+
+void PulsarEngine::PanGains(uint32_t pulsar, size_t numChannels, float* gains) const {
+    // Place on the line from channel 0 (0.0) to the last (1.0)
+    const size_t last = numChannels - 1;
+    float place;
+    if (spatialMode_ == SpatialMode::SCATTER) {
+        place = 0.5f + 0.5f * scatter_.PeekBipolar(pulsar);
+    } else {
+        place = static_cast<float>(pulsar % numChannels) / static_cast<float>(last);
+    }
+    place = 0.5f + (place - 0.5f) * spread_;
+
+    // Between channels left and left + 1 at constant power: the cosine
+    // and sine of a quarter turn across the pair, both as sines so that
+    // a pulsar on a channel is exactly 1.0 there and 0.0 in the other
+    float x = place * static_cast<float>(last);
+    size_t left = static_cast<size_t>(x);
+    left = (left < last) ? left : last - 1;
+    float frac = x - static_cast<float>(left);
+    for (size_t c = 0; c < numChannels; ++c) {
+        gains[c] = 0.0f;
+    }
+    gains[left] = sinf((1.0f - frac) * (0.25f * TWO_PI));
+    gains[left + 1] = sinf(frac * (0.25f * TWO_PI));
+}
+
+void PulsarEngine::Spatialize(const PulsarOutput& output, size_t size) {
+    const size_t numChannels = output.numChannels;
+    if (numChannels < 2 || size == 0) {
+        return;
+    }
+
+    // The placements over this block's output, as block sample ranges.
+    // The oldest covers the block from its first sample, even if it
+    // starts later, as Init's does while the fold delay is filling.
+    const uint32_t outputStart = clock_ - static_cast<uint32_t>(size) -
+                                 static_cast<uint32_t>(foldOversampler_.Latency());
+    size_t ends[MAX_PLACEMENTS];
+    uint32_t pulsars[MAX_PLACEMENTS];
+    size_t count = 0;
+    for (uint32_t k = oldestPlacement_; k != placementCount_; ++k) {
+        const Placement& placement = placements_[k % MAX_PLACEMENTS];
+        int32_t start = static_cast<int32_t>(placement.start - outputStart);
+        if (count > 0 && start >= static_cast<int32_t>(size)) {
+            break;
+        }
+        if (count > 0) {
+            ends[count - 1] = (start > 0) ? static_cast<size_t>(start) : 0;
+        }
+        pulsars[count++] = placement.pulsar;
+    }
+    ends[count - 1] = size;
+
+    // Last to first, so that frames spread out of an interleaved
+    // channel 0 overwrite only samples already taken
+    float* mono = output.channels[0];
+    const size_t stride = output.stride;
+    float gains[PulsarOutput::MAX_CHANNELS];
+    for (size_t k = count; k-- > 0;) {
+        const size_t begin = (k > 0) ? ends[k - 1] : 0;
+        const size_t end = ends[k];
+        PanGains(pulsars[k], numChannels, gains);
+        if (stride == 1) {
+            for (size_t c = 1; c < numChannels; ++c) {
+                float* channel = output.channels[c];
+                const float gain = gains[c];
+                for (size_t i = begin; i < end; ++i) {
+                    channel[i] = mono[i] * gain;
+                }
+            }
+            const float gain = gains[0];
+            for (size_t i = begin; i < end; ++i) {
+                mono[i] *= gain;
+            }
+        } else {
+            for (size_t i = end; i-- > begin;) {
+                const float x = mono[i];
+                for (size_t c = numChannels; c-- > 0;) {
+                    output.channels[c][i * stride] = x * gains[c];
+                }
+            }
+        }
+    }
 }
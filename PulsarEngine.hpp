@@ -2,10 +2,16 @@
 #ifndef PULSAR_ENGINE_HPP
 #define PULSAR_ENGINE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
+#include "Oversampler.hpp"
+#include "Random.hpp"
+#include "TripleBuffer.hpp"
 
-// Maximum number of waveform table points
+class SampledPulsaret;
+
+// Points per precomputed pulsaret shape table
 static constexpr int WAVETABLE_SIZE = 256;
 
 // Pulsaret waveform types
@@ -30,6 +36,24 @@ enum class PulsaretEnvelope {
     FOF  // Formant synthesis style
 };
 
+// How pulsaret shapes are evaluated
+enum class ShapeLookup {
+    COMPUTED = 0,  // Reference shape functions per sample
+    TABLE          // Interpolated WAVETABLE_SIZE-point tables
+};
+
+// How pulsaret edges are treated
+enum class EdgeMode {
+    SMOOTHED = 0,  // Naive edges, half-sample fade where the pulsaret ends
+    BAND_LIMITED   // PolyBLEP/BLAMP corrections at every edge
+};
+
+// Wavefolder algorithm
+enum class FoldMode {
+    DIRECT = 0,  // Closed-form triangle fold
+    ADAA         // First-order antiderivative anti-aliasing
+};
+
 // Masking mode
 enum class MaskingMode {
     OFF = 0,
@@ -37,8 +61,92 @@ enum class MaskingMode {
     STOCHASTIC
 };
 
+// How pulsars are placed between output channels
+enum class SpatialMode {
+    ALTERNATE = 0,  // Successive pulsars step through the channels in turn
+    SCATTER         // Each pulsar lands at a random place
+};
+
+// Output buffers for PulsarEngine::ProcessBlock: sample i of channel c
+// is channels[c][i * stride], so planar and interleaved buffers are both
+// written in place. Channel 0 must also have room for the block as
+// contiguous samples, which either layout has: the engine renders
+// there and spreads the channels out from it.
+struct PulsarOutput {
+    static constexpr size_t MAX_CHANNELS = 8;
+
+    float* channels[MAX_CHANNELS];
+    size_t numChannels;
+    size_t stride;
+
+    // One buffer per channel
+    static PulsarOutput Planar(float* const* buffers, size_t numChannels) {
+        PulsarOutput output;
+        output.numChannels = ClampChannels(numChannels);
+        output.stride = 1;
+        for (size_t c = 0; c < output.numChannels; ++c) {
+            output.channels[c] = buffers[c];
+        }
+        return output;
+    }
+
+    // Frames of numChannels samples in one buffer
+    static PulsarOutput Interleaved(float* buffer, size_t numChannels) {
+        PulsarOutput output;
+        output.numChannels = ClampChannels(numChannels);
+        output.stride = output.numChannels;
+        for (size_t c = 0; c < output.numChannels; ++c) {
+            output.channels[c] = buffer + c;
+        }
+        return output;
+    }
+
+private:
+    static size_t ClampChannels(size_t n) {
+        return (n < 1) ? 1 : ((n > MAX_CHANNELS) ? MAX_CHANNELS : n);
+    }
+};
+
+// Control-rate parameters, published as one snapshot with
+// PulsarEngine::Publish. Fields take the ranges of the setters of the
+// same name.
+struct PulsarParams {
+    float frequency = 220.0f;
+    float formantRatio = 0.5f;
+    float waveformMorph = 0.0f;
+    float envelopeMorph = 1.0f;
+    float fold = 0.0f;
+    float amplitude = 1.0f;
+    MaskingMode maskingMode = MaskingMode::OFF;
+    int burstCount = 4;
+    int restCount = 0;
+    float maskingProbability = 1.0f;
+    SpatialMode spatialMode = SpatialMode::ALTERNATE;
+    float spread = 0.0f;
+
+    // Replaces the main formant's waveform while set (see SetSample)
+    const SampledPulsaret* sample = nullptr;
+
+    // Changing this requests a Reset at the start of the next block
+    uint32_t resetCount = 0;
+};
+
+// Audio-rate modulation for PulsarEngine::ProcessBlock. Each buffer is
+// optional; a given one holds one value per sample of the block, added
+// to the current parameter without going through its setter.
+struct PulsarModulation {
+    const float* pitch = nullptr;          // Exponential FM, in octaves
+    const float* linearFm = nullptr;       // Linear FM, in multiples of the fundamental
+    const float* formantRatio = nullptr;   // Offset to the formant ratio
+    const float* waveformMorph = nullptr;  // Offset to the waveform morph
+    const float* envelopeMorph = nullptr;  // Offset to the envelope morph
+};
+
 class PulsarEngine {
 public:
+    // Maximum pulsarets per period in multi-formant mode
+    static constexpr int MAX_FORMANTS = 4;
+
     PulsarEngine() { Init(48000.0f); }
     ~PulsarEngine() = default;
 
@@ -48,12 +156,51 @@ public:
     // Reset phase and state
     void Reset();
 
-    // Hard sync - reset phase immediately
-    void Sync();
+    // Hard sync: start a new pulsar now, or from a point elapsed (0.0
+    // to 1.0) samples before the next sample, which then plays at that
+    // much phase
+    void Sync(float elapsed = 0.0f);
 
     // Process one sample
     float Process();
 
+    // Render a block of samples. Parameters are read once per block, so
+    // setters called during the block take effect on the next one.
+    // Frequency, fold and amplitude ramp linearly across the block to
+    // their new values; the rest step at the block boundary.
+    void ProcessBlock(float* out, size_t size);
+
+    // Render a block with audio-rate modulation. Results are clamped to
+    // the setter ranges, and frequency does not go through zero.
+    void ProcessBlock(const PulsarModulation& mod, float* out, size_t size);
+
+    // Render a block with the Versio audio inputs applied:
+    // rising zero-crossings on syncIn hard-sync the phase, and ringOut
+    // receives out * (1 + ringIn). Any of syncIn, ringIn, ringOut and
+    // mod may be null. Each crossing is placed between its two samples
+    // by linear interpolation, and with BAND_LIMITED edges the step it
+    // cuts into the train is corrected there too.
+    void ProcessBlock(const float* syncIn, const float* ringIn,
+                      float* out, float* ringOut, size_t size,
+                      const PulsarModulation* mod = nullptr);
+
+    // Render a block into several channels, each pulsar placed between
+    // them as SetSpatialMode and SetSpread say. syncIn and mod act as
+    // above, and every channel is ring modulated by ringIn; either may
+    // be null. Pan gains are worked out once per pulsar, and the
+    // oversampled fold's delay is allowed for.
+    void ProcessBlock(const float* syncIn, const float* ringIn,
+                      const PulsarOutput& output, size_t size,
+                      const PulsarModulation* mod = nullptr);
+
+    // Hand a parameter snapshot to the audio path. Safe to call from a
+    // control loop that the audio callback interrupts: the next block
+    // applies the latest complete snapshot. After the first, a snapshot
+    // only sets the fields that differ from the one before it, so there
+    // is no need to publish when nothing has changed. The setters below
+    // are for use from the rendering context only.
+    void Publish(const PulsarParams& params);
+
     // Set fundamental frequency (Hz) - the pulsar repetition rate
     void SetFrequency(float freq);
 
@@ -71,6 +218,16 @@ public:
     // Set pulsaret waveform by interpolated index (0.0 to 6.0)
     void SetWaveformMorph(float morphValue);
 
+    // Set number of formants (1 to MAX_FORMANTS). Each formant is a
+    // pulsaret with its own duty cycle, waveform and gain, all driven by
+    // the one fundamental phase and sharing envelope and masking.
+    void SetFormantCount(int count);
+
+    // Configure one formant: ratio as in SetFormantRatio, waveform morph
+    // 0.0 to 6.0, gain 0.0 to 1.0. Formant 0 is the main formant, the
+    // same one SetFormantRatio and SetWaveformMorph control.
+    void SetFormant(int formant, float ratio, float waveformMorph, float gain);
+
     // Set pulsaret envelope type
     void SetEnvelope(PulsaretEnvelope envelope);
 
@@ -80,6 +237,17 @@ public:
     // Set wavefolding amount (0.0 to 1.0)
     void SetFold(float amount);
 
+    // Run the folder at 1x, 2x or 4x the sample rate (default 1). With
+    // 2x or 4x, whole blocks are folded between half-band filters, which
+    // delays the output by 15 (2x) or 19 (4x) samples.
+    void SetFoldOversampling(int factor);
+
+    // Select the folding algorithm (default DIRECT). ADAA folds whole
+    // blocks through the antiderivative of the fold, which suppresses
+    // aliasing at the cost of a half-sample delay and a gentle treble
+    // roll-off. Both run in constant time per sample.
+    void SetFoldMode(FoldMode mode);
+
     // Set burst masking ratio
     // burst = number of pulsars to emit, rest = number to skip
     void SetBurstRatio(int burst, int rest);
@@ -91,9 +259,42 @@ public:
     // Set masking mode
     void SetMaskingMode(MaskingMode mode);
 
+    // Restart the noise and stochastic masking streams under a seed.
+    // Noise is indexed by output sample, so the same seed and settings
+    // render the same output however the blocks are split.
+    void SetRandomSeed(uint32_t seed);
+
     // Set output amplitude (0.0 to 1.0)
     void SetAmplitude(float amp);
 
+    // Set how pulsars are placed between output channels (default
+    // ALTERNATE). The channels lie on a line from the first to the
+    // last; a pulsar is panned between the two around it at constant
+    // power, so it is as loud wherever it lands.
+    void SetSpatialMode(SpatialMode mode);
+
+    // Set how far pulsars are placed from the centre of the line (0.0
+    // to 1.0, default 0.0). At 0.0 every pulsar is in the centre, which
+    // for two channels is the whole train 3 dB down in each.
+    void SetSpread(float spread);
+
+    // Play a sampled pulsaret in place of the main formant's waveform
+    // morph, or go back to it with null (the default). An empty sample
+    // also plays the waveform morph. The sample is read in place and
+    // must outlive its use. Its mipmap levels are chosen once per block
+    // from the formant rate, so audio-rate modulation does not move
+    // them, and waveform modulation does not apply.
+    void SetSample(const SampledPulsaret* sample);
+
+    // Select computed or table-based pulsaret shapes (default TABLE)
+    void SetShapeLookup(ShapeLookup lookup);
+
+    // Select naive or band-limited pulsaret edges (default SMOOTHED).
+    // BAND_LIMITED corrects the pulsaret start and end, the SQUARE and
+    // PULSE steps and the TRIANGLE corners at their fractional sample
+    // position.
+    void SetEdgeMode(EdgeMode mode);
+
     // Get current phase (0.0 to 1.0)
     float GetPhase() const { return phase_; }
 
@@ -101,20 +302,109 @@ public:
     bool IsInPulsaret() const { return inPulsaret_; }
 
 private:
-    // Generate waveform sample at given phase
-    float GenerateWaveform(float phase, PulsaretWaveform waveform);
-
-    // Generate envelope value at given phase
-    float GenerateEnvelope(float phase, PulsaretEnvelope envelope);
-
-    // Apply wavefolding
-    float ApplyFold(float sample);
+    // Additional formant sharing the fundamental phase
+    struct Formant {
+        float dutyCycle;
+        PulsaretWaveform waveform;
+        PulsaretWaveform waveformNext;
+        float waveformMorph;
+        float gain;
+    };
+
+    // Linear per-block ramp, landing on the target at the last sample
+    struct Ramp {
+        float value;
+        float target;
+        float step;
+
+        void Jump(float v) {
+            value = v;
+            target = v;
+            step = 0.0f;
+        }
+        void Begin(size_t size) { step = (target - value) / static_cast<float>(size); }
+        void End() { value = target; }
+    };
+
+    // Apply any published snapshot and start the parameter ramps
+    void BeginBlock(size_t size);
+
+    // Apply one snapshot through the setters of the fields it changes
+    void ApplyParams(const PulsarParams& params);
+
+    // Render a run of samples with constant parameters, or with
+    // per-sample offsets from mod read from sample offset on
+    template <bool MODULATED>
+    void Render(float* out, size_t size, const PulsarModulation* mod, size_t offset);
+
+    // Render a run with constant parameters, event by event: silent
+    // stretches are filled in bulk, the rest goes to a kernel or
+    // Render<false>
+    void RenderSparse(float* out, size_t size);
+
+    // Samples to render before the state can next turn silent
+    size_t ActiveSamples(size_t size) const;
+
+    // Fill the samples, up to size, from the current state on that are
+    // certain to be silent and advance the state past them. Returns how
+    // many, or 0 if too few to be worth skipping.
+    size_t SkipSilence(float* out, size_t size);
+
+    // Phases within which the current pulsar is silent: after its
+    // pulsarets and their edges, or almost all of it if masked
+    void SilentWindow(bool masked, float& start, float& end) const;
+
+    // Fundamental phase where the longest formant's pulsaret ends
+    float PulsaretEnd() const;
+
+    // Render out[start, start + size), modulated if mod is given
+    void RenderRun(float* out, size_t start, size_t size, const PulsarModulation* mod);
+
+    // Render with shapes fixed at compile time (see PulsarKernels.hpp):
+    // the common case of Render<false>, with Wave and Env evaluating the
+    // shapes and FOLD folding inline
+    template <typename Wave, typename Env, bool FOLD>
+    void RenderKernel(float* out, size_t size);
+
+    typedef void (PulsarEngine::*Kernel)(float* out, size_t size);
+
+    // Kernel for the current settings, or null for Render
+    Kernel SelectKernel() const;
+
+    // Whether Render folds at 1x, rather than FinishBlock afterwards
+    bool FoldsInline() const;
+
+    friend struct KernelTable;
+
+    // Oversampled fold and amplitude over a whole rendered block
+    void FinishBlock(float* out, size_t size);
+
+    // Apply wavefolding to a block, in the current fold mode
+    void FoldBlock(float* io, size_t size);
 
     // Check burst masking
     bool ShouldEmitPulsar();
 
-    // Fast pseudo-random number generator
-    float FastRandom();
+    // Account for size rendered samples: the clock and the noise
+    void Advance(size_t size);
+
+    // Note that a new pulsar starts at clock time start
+    void PlacePulsar(uint32_t start);
+
+    // Spread the rendered block from output's channel 0 over all of
+    // its channels, pulsar by pulsar
+    void Spatialize(const PulsarOutput& output, size_t size);
+
+    // Channel gains for a pulsar
+    void PanGains(uint32_t pulsar, size_t numChannels, float* gains) const;
+
+    // Render a block, hard-synced by syncIn if given
+    void RenderSynced(const float* syncIn, float* out, size_t size,
+                      const PulsarModulation* mod);
+
+    // Train at a fundamental phase of the current pulsar, less noise
+    // and before fold and amplitude, for sync step heights
+    float TrainValue(float phase) const;
 
     // Sample rate
     float sampleRate_;
@@ -122,7 +412,7 @@ private:
 
     // Phase accumulator (0.0 to 1.0 per pulsar period)
     float phase_;
-    float phaseIncrement_;
+    Ramp phaseIncrement_;
 
     // Pulsaret phase (0.0 to 1.0 within duty cycle)
     float pulsaretPhase_;
@@ -143,8 +433,28 @@ private:
     PulsaretEnvelope envelopeNext_;
     float envelopeMorph_;
 
+    ShapeLookup shapeLookup_;
+    EdgeMode edgeMode_;
+    const SampledPulsaret* sample_;
+
+    // Multi-formant mode
+    int formantCount_;
+    float primaryGain_;
+    Formant extraFormants_[MAX_FORMANTS - 1];
+
     // Wavefolding
-    float foldAmount_;
+    Ramp foldAmount_;
+    FoldMode foldMode_;
+    int foldOversampling_;
+    bool foldEngaged_;
+    int foldTail_;  // Samples to keep folding after the amount reaches zero
+    Oversampler foldOversampler_;
+
+    // Previous fold input and its antiderivative, for ADAA; on restart
+    // the first input of the next block stands in for both
+    float foldPrevInput_;
+    float foldPrevIntegral_;
+    bool foldRestart_;
 
     // Masking
     MaskingMode maskingMode_;
@@ -153,16 +463,48 @@ private:
     int burstPosition_;
     float maskingProbability_;
     bool currentPulsarMasked_;
+    bool previousPulsarMasked_;
 
     // State
     bool inPulsaret_;
-    float amplitude_;
-
-    // Random state for stochastic masking and noise
-    uint32_t randomSeed_;
+    Ramp amplitude_;
+
+    // Noise draws, one per output sample, and masking draws, one per
+    // pulsar under STOCHASTIC
+    RandomStream noise_;
+    RandomStream masking_;
+
+    // Where pulsars start, in clock time, for Spatialize: a ring of
+    // the placements the output has yet to pass, oldest first. A pulsar
+    // past a full ring plays where the one before it does.
+    struct Placement {
+        uint32_t start;
+        uint32_t pulsar;
+    };
+    static constexpr uint32_t MAX_PLACEMENTS = 64;
+    Placement placements_[MAX_PLACEMENTS];
+    uint32_t placementCount_;  // Ever made; the newest is placementCount_ - 1
+    uint32_t oldestPlacement_;
+    uint32_t pulsarCount_;
+
+    // Samples rendered since Init
+    uint32_t clock_;
+
+    SpatialMode spatialMode_;
+    float spread_;
+    RandomStream scatter_;  // Read by pulsar number
 
     // Previous sample for edge smoothing
     float prevSample_;
+
+    // Previous sync input sample for zero-crossing detection
+    float prevSyncIn_;
+
+    // Snapshots from the control loop, and the last one applied
+    TripleBuffer<PulsarParams> params_;
+    PulsarParams applied_;
+    bool paramsApplied_;
+    uint32_t resetCount_;
 };
 
 #endif // PULSAR_ENGINE_HPP
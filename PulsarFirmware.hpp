@@ -0,0 +1,492 @@
+#pragma once
+#ifndef PULSAR_FIRMWARE_HPP
+#define PULSAR_FIRMWARE_HPP
+
+#include "ControlTask.hpp"
+#include "Convolver.hpp"
+#include "LoadMonitor.hpp"
+#include "PulsarControls.hpp"
+#include "PulsarEngine.hpp"
+#include "SampledPulsaret.hpp"
+#include "Settings.hpp"
+#include "VoctCalibration.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Build with PULSAR_CONVOLUTION=1 to convolve OUT_L with the captured
+// buffer instead of playing it as the pulsaret
+#ifndef PULSAR_CONVOLUTION
+#define PULSAR_CONVOLUTION 0
+#endif
+
+// Build with PULSAR_STEREO=1 to spread pulsars between OUT_L and OUT_R
+// instead of the dry and ring modulated outputs (ignored with
+// PULSAR_CONVOLUTION)
+#ifndef PULSAR_STEREO
+#define PULSAR_STEREO 0
+#endif
+
+// The main loop runs the control task at CONTROL_RATE and refreshes
+// the LEDs at LED_RATE, timed by the hardware's cycle counter
+static constexpr float CONTROL_RATE = 1500.0f;
+static constexpr float LED_RATE = 100.0f;
+
+// Knob and CV smoothing per control tick, and the movement that counts
+// as a change: a cent for V/Oct, a fraction of the travel for knobs
+static constexpr float PITCH_SMOOTHING = 0.5f;
+static constexpr float PITCH_THRESHOLD = 1.0f / 1200.0f;
+static constexpr float KNOB_SMOOTHING = 0.1f;
+static constexpr float KNOB_THRESHOLD = 0.002f;
+
+// Load display: holding the button toggles LED_0 between the phase
+// indicator and the audio callback load
+static constexpr float LOAD_DISPLAY_HOLD_MS = 2000.0f;
+static constexpr uint32_t LOAD_MISS_FLASH_MS = 250;
+
+// Sampled pulsaret: holding the button for CAPTURE_HOLD_MS, and letting
+// go before the load display toggles, captures IN_R into the slot not
+// being played; then the main loop builds its mipmap and publishes it.
+// A capture that never reaches CAPTURE_MIN_PEAK, as from an unpatched
+// input, is dropped. Moving the waveform knob goes back to the built-in
+// shapes.
+static constexpr size_t CAPTURE_SAMPLES = 2048;
+static constexpr float CAPTURE_HOLD_MS = 500.0f;
+static constexpr float CAPTURE_MIN_PEAK = 0.01f;  // -40 dBFS
+static constexpr float CAPTURE_RELEASE_MOVE = 0.05f;
+
+// Convolution: 64-sample partitions stay within one 48-sample callback
+// each, so the work spreads evenly; 32 of them take the whole capture
+static constexpr size_t CONVOLUTION_PARTITION = 64;
+static constexpr size_t CONVOLUTION_PARTITIONS = CAPTURE_SAMPLES / CONVOLUTION_PARTITION;
+
+// V/Oct calibration: raw ADC readings fall as the voltage rises. The
+// input may pin at the top of the ADC's range at 0 V, so a reading
+// within CALIBRATION_THRESH of it is extrapolated from 1 V and 2 V.
+static constexpr int CALIBRATION_MAX = 65536;
+static constexpr float CALIBRATION_THRESH = CALIBRATION_MAX - 200;
+static constexpr float DEFAULT_CALIBRATION_OFFSET = 64262.0f;
+static constexpr float DEFAULT_CALIBRATION_UNITS_PER_VOLT = 12826.0f;
+static_assert(VoctCalibration::POINTS == PITCH_VOLTS_MAX + 1,
+              "calibration points cover the V/Oct range");
+
+// The PulsarVersio firmware: audio callback, control loop, LEDs,
+// capture and V/Oct calibration, written against a thin hardware
+// interface so the same code runs on the module (DaisyHardware.hpp)
+// and in the host simulator (host/SimulatedHardware.hpp).
+//
+// Hardware is a class providing:
+//
+//   typedef Clock            cycle counter for the LoadMonitor
+//   AudioSampleRate()        float, Hz
+//   ClockRate()              uint32_t ticks per second of Now() and Clock
+//   Now()                    uint32_t free-running, wrapping tick count
+//   Millis()                 uint32_t milliseconds since power on
+//   DelayMs(ms)              block for ms milliseconds
+//   ProcessControls()        sample the knobs, CV and switches and
+//                            debounce the button, once per control tick
+//   KnobValue(k)             float knob k (1 to 6), 0 to 1
+//   CvRaw()                  float raw V/Oct reading, 0 to 65535,
+//                            falling as the voltage rises
+//   ReadSwitch(i)            SwitchPosition of switch 0 (top) or 1
+//   Gate()                   bool gate input
+//   DebounceTap()            sample the button
+//   TapRisingEdge(), TapFallingEdge(), TapPressed(), TapRaw()
+//                            bool button state as of the last debounce
+//   TapHeldMs()              float time the button has been held
+//   SetLed(led, r, g, b), UpdateLeds()
+//                            LEDs 0 to 3, components 0 to 1
+//   InitSettings(defaults), GetSettings(), SaveSettings(),
+//   RestoreDefaultSettings() persistent Settings
+//
+// The owner initializes the hardware, calls Init, starts audio with a
+// callback that forwards to ProcessAudio, then calls Poll forever.
+template <typename Hardware>
+class PulsarFirmware {
+public:
+    explicit PulsarFirmware(Hardware& hardware) : hw_(hardware) {}
+
+    // Everything up to starting audio: the engine, persistent settings
+    // and, with both switches right and the button held, calibration
+    void Init() {
+        sampleRate_ = hw_.AudioSampleRate();
+
+        pulsar_.Init(sampleRate_);
+        ConfigureEngine(pulsar_);
+#if PULSAR_CONVOLUTION
+        convolver_.Init(CONVOLUTION_PARTITION, CONVOLUTION_PARTITIONS, convolverMemory_,
+                        sizeof(convolverMemory_) / sizeof(convolverMemory_[0]));
+#endif
+
+        // Initialize persistent storage, keeping a calibration from an
+        // older layout
+        Settings defaults;
+        defaults.version = Settings::VERSION;
+        VoctCalibration::Linear(DEFAULT_CALIBRATION_OFFSET, DEFAULT_CALIBRATION_UNITS_PER_VOLT,
+                                defaults.calibrationCodes);
+        hw_.InitSettings(defaults);
+        Settings& settings = hw_.GetSettings();
+        uint32_t version = settings.version;
+        if (!UpgradeSettings(settings)) {
+            hw_.RestoreDefaultSettings();
+        } else if (version != Settings::VERSION) {
+            hw_.SaveSettings();
+        }
+        LoadData();
+
+        // Check for calibration mode: both switches right + button held
+        hw_.ProcessControls();
+        if (hw_.ReadSwitch(0) == SwitchPosition::RIGHT &&
+            hw_.ReadSwitch(1) == SwitchPosition::RIGHT && hw_.TapRaw()) {
+            DoCalibration();
+        }
+
+        loadMonitor_.Init(sampleRate_, hw_.ClockRate());
+
+        uint32_t now = hw_.Now();
+        controlTimer_.Init(CONTROL_RATE, hw_.ClockRate(), now);
+        ledTimer_.Init(LED_RATE, hw_.ClockRate(), now);
+        // V/Oct is filtered as raw readings, a cent being a hundredth
+        // of the narrowest calibrated semitone
+        knobFilters_[0].Init(PITCH_SMOOTHING,
+                             calibration_.GetMinCodesPerVolt() * PITCH_THRESHOLD,
+                             calibration_.Code(0));
+        for (int k = 1; k < NUM_PANEL_KNOBS; ++k) {
+            knobFilters_[k].Init(KNOB_SMOOTHING, KNOB_THRESHOLD, panel_.knobs[k]);
+        }
+        ApplyPanel(panel_, pitchRatio_, params_);
+    }
+
+    // The audio callback: hard sync on in[0] rising zero-crossings,
+    // ring modulation and capture from in[1]. Output level is applied
+    // by the engine amplitude.
+    void ProcessAudio(const float* const* in, float** out, size_t size) {
+        loadMonitor_.BeginBlock();
+#if PULSAR_STEREO && !PULSAR_CONVOLUTION
+        // Pulsars spread between OUT_L and OUT_R, rendered straight
+        // into them, all ring modulated by IN_R
+        pulsar_.ProcessBlock(in[0], in[1], PulsarOutput::Planar(out, 2), size);
+#else
+        // Pulsar on OUT_L, and ring modulation by IN_R on OUT_R
+        pulsar_.ProcessBlock(in[0], in[1], out[0], out[1], size);
+#endif
+#if PULSAR_CONVOLUTION
+        // OUT_L convolved once an impulse response is captured
+        if (convolver_.GetPartitionCount() > 0) {
+            convolver_.Process(out[0], out[0], size);
+        }
+#endif
+
+        // Copy after processing, so the main loop only ever swaps the
+        // sample between blocks
+        size_t fill = captureFill_;
+        if (fill < CAPTURE_SAMPLES) {
+            float* buffer = captureBuffers_[captureSlot_];
+            for (size_t i = 0; i < size && fill < CAPTURE_SAMPLES; ++i) {
+                buffer[fill++] = in[1][i];
+            }
+            captureFill_ = fill;
+        }
+        loadMonitor_.EndBlock(size);
+    }
+
+    // One pass of the main loop: run whichever tasks are due
+    void Poll() {
+        uint32_t now = hw_.Now();
+        if (controlTimer_.Due(now)) {
+            ControlTask();
+        }
+        if (ledTimer_.Due(now) && !inCalibration_) {
+            LedTask();
+        }
+    }
+
+    PulsarEngine& GetEngine() { return pulsar_; }
+    LoadMonitor<typename Hardware::Clock>& GetLoadMonitor() { return loadMonitor_; }
+    const PanelState& GetPanel() const { return panel_; }
+    bool IsShowingLoad() const { return showLoad_; }
+
+    const VoctCalibration& GetCalibration() const { return calibration_; }
+
+    // Task counts since Init, for the simulator
+    uint32_t GetControlTicks() const { return controlTicks_; }
+    uint32_t GetLedTicks() const { return ledTicks_; }
+    uint32_t GetPublishCount() const { return publishCount_; }
+    uint32_t GetCaptureCount() const { return captureCount_; }
+
+private:
+    void SaveData(const float* codes) {
+        Settings& settings = hw_.GetSettings();
+        settings.version = Settings::VERSION;
+        for (int v = 0; v < VoctCalibration::POINTS; ++v) {
+            settings.calibrationCodes[v] = codes[v];
+        }
+        hw_.SaveSettings();
+    }
+
+    void LoadData() { calibration_.Init(hw_.GetSettings().calibrationCodes); }
+
+    // Press and release, debounced at 1 kHz
+    void WaitForButton() {
+        while (!hw_.TapRisingEdge()) {
+            hw_.DelayMs(1);
+            hw_.DebounceTap();
+        }
+        while (!hw_.TapFallingEdge()) {
+            hw_.DelayMs(1);
+            hw_.DebounceTap();
+        }
+        hw_.DelayMs(200);
+    }
+
+    float AverageCv() {
+        const int NUM_SAMPLES = 10;
+        float total = 0;
+        for (int x = 0; x < NUM_SAMPLES; ++x) {
+            total += hw_.CvRaw();
+        }
+        return total / NUM_SAMPLES;
+    }
+
+    // Calibration steps on the LEDs: 0 V to 3 V light one to four LEDs
+    // green, 4 V and 5 V one and two LEDs blue
+    void ShowCalibrationStep(int v) {
+        for (int led = 0; led < 4; ++led) {
+            float lit = (led <= v % 4) ? 1.0f : 0.0f;
+            hw_.SetLed(led, 0, (v < 4) ? lit : 0.0f, (v < 4) ? 0.0f : lit);
+        }
+        hw_.UpdateLeds();
+    }
+
+    void DoCalibration() {
+        inCalibration_ = true;
+
+        // Step 0: Release button
+        hw_.DebounceTap();
+        hw_.SetLed(0, 1, 1, 1);
+        hw_.SetLed(1, 1, 1, 1);
+        hw_.SetLed(2, 1, 1, 1);
+        hw_.SetLed(3, 1, 1, 1);
+        hw_.UpdateLeds();
+
+        while (hw_.TapRaw()) {
+            hw_.DelayMs(1);
+            hw_.DebounceTap();
+        }
+
+        // Each reference voltage in turn, confirmed with the button
+        float codes[VoctCalibration::POINTS];
+        for (int v = 0; v < VoctCalibration::POINTS; ++v) {
+            ShowCalibrationStep(v);
+            WaitForButton();
+            codes[v] = AverageCv();
+        }
+        if (codes[0] > CALIBRATION_THRESH) {
+            codes[0] = 2.0f * codes[1] - codes[2];
+        }
+
+        // Save, or keep the old calibration if a step was skipped or
+        // the wrong voltage applied
+        if (VoctCalibration::IsValid(codes)) {
+            SaveData(codes);
+            LoadData();
+        }
+
+        inCalibration_ = false;
+    }
+
+    // Whether a capture rises above the floor anywhere
+    static bool Audible(const float* buffer, size_t size) {
+        float peak = 0.0f;
+        for (size_t i = 0; i < size; ++i) {
+            peak = fmaxf(peak, fabsf(buffer[i]));
+        }
+        return peak >= CAPTURE_MIN_PEAK;
+    }
+
+    // Read the panel, and publish parameters if anything moved
+    void ControlTask() {
+        controlTicks_++;
+        hw_.ProcessControls();
+
+        // Top switch: masking mode, bottom switch: frequency range
+        SwitchPosition maskSwitch = hw_.ReadSwitch(0);
+        SwitchPosition rangeSwitch = hw_.ReadSwitch(1);
+        bool changed = maskSwitch != panel_.maskSwitch || rangeSwitch != panel_.rangeSwitch;
+        panel_.maskSwitch = maskSwitch;
+        panel_.rangeSwitch = rangeSwitch;
+
+        // KNOB_0: V/oct pitch, through the calibration table; KNOB_1
+        // to KNOB_6 as mapped in PulsarControls.hpp
+        if (knobFilters_[0].Process(hw_.CvRaw())) {
+            float code = knobFilters_[0].Value();
+            panel_.knobs[0] = calibration_.Volts(code);
+            pitchRatio_ = calibration_.Ratio(code);
+            changed = true;
+        }
+        for (int k = 1; k < NUM_PANEL_KNOBS; ++k) {
+            if (knobFilters_[k].Process(hw_.KnobValue(k))) {
+                panel_.knobs[k] = knobFilters_[k].Value();
+                changed = true;
+            }
+        }
+        if (changed) {
+            ApplyPanel(panel_, pitchRatio_, params_);
+            paramsDirty_ = true;
+        }
+
+        // Button or Gate: Reset phase
+        bool gate = hw_.Gate();
+        if (hw_.TapRisingEdge() || (gate && !prevGate_)) {
+            params_.resetCount++;
+            paramsDirty_ = true;
+        }
+        prevGate_ = gate;
+
+        // Long press: toggle the load display, counting from scratch
+        float heldMs = hw_.TapHeldMs();
+        bool held = hw_.TapPressed() && heldMs > LOAD_DISPLAY_HOLD_MS;
+        if (held && !prevHeld_) {
+            showLoad_ = !showLoad_;
+            loadMonitor_.Reset();
+        }
+        prevHeld_ = held;
+
+        // A shorter hold captures a pulsaret from IN_R on release, into
+        // the slot the engine is not playing. A capture outlasts many
+        // blocks, so the engine has let go of the other slot before it
+        // can be reused.
+        bool release = hw_.TapFallingEdge();
+        if (release && tapHeldMs_ >= CAPTURE_HOLD_MS && tapHeldMs_ <= LOAD_DISPLAY_HOLD_MS &&
+            !capturePending_) {
+            captureSlot_ = (params_.sample == &captured_[0]) ? 1 : 0;
+            capturePending_ = true;
+            captureFill_ = 0;
+        }
+        tapHeldMs_ = hw_.TapPressed() ? heldMs : 0.0f;
+        if (capturePending_ && captureFill_ >= CAPTURE_SAMPLES) {
+            capturePending_ = false;
+            const float* buffer = captureBuffers_[captureSlot_];
+            if (Audible(buffer, CAPTURE_SAMPLES)) {
+#if PULSAR_CONVOLUTION
+                convolver_.SetImpulseResponse(
+                    buffer, CAPTURE_SAMPLES, Convolver::NormalizingGain(buffer, CAPTURE_SAMPLES));
+                captureCount_++;
+#else
+                SampledPulsaret& sample = captured_[captureSlot_];
+                if (sample.Init(buffer, CAPTURE_SAMPLES, captureMipmaps_[captureSlot_],
+                                SampledPulsaret::MipmapSize(CAPTURE_SAMPLES))) {
+                    params_.sample = &sample;
+                    captureKnob_ = panel_.knobs[2];
+                    paramsDirty_ = true;
+                    captureCount_++;
+                }
+#endif
+            }
+        }
+        if (params_.sample != nullptr &&
+            fabsf(panel_.knobs[2] - captureKnob_) > CAPTURE_RELEASE_MOVE) {
+            params_.sample = nullptr;
+            paramsDirty_ = true;
+        }
+
+        // Hand the whole set to the audio callback at once
+        if (paramsDirty_) {
+            pulsar_.Publish(params_);
+            paramsDirty_ = false;
+            publishCount_++;
+        }
+    }
+
+    // Show the engine state and panel on the LEDs
+    void LedTask() {
+        ledTicks_++;
+        if (showLoad_) {
+            // LED_0: Callback load, green through yellow to red,
+            // flashing full red on a missed deadline
+            const LoadStats& stats = loadMonitor_.GetStats();
+            uint32_t now = hw_.Millis();
+            if (stats.misses != shownMisses_) {
+                shownMisses_ = stats.misses;
+                missFlashUntil_ = now + LOAD_MISS_FLASH_MS;
+            }
+            float load = fminf(1.0f, stats.load);
+            if (static_cast<int32_t>(missFlashUntil_ - now) > 0) {
+                hw_.SetLed(0, 1, 0, 0);
+            } else {
+                hw_.SetLed(0, load, 1.0f - load, 0);
+            }
+        } else {
+            // LED_0: Phase indicator (cyan pulse)
+            float ledPhase = pulsar_.IsInPulsaret() ? 0.8f : 0.1f;
+            hw_.SetLed(0, 0, ledPhase * 0.5f, ledPhase * 0.5f);
+        }
+
+        // LED_1: Formant (green)
+        float ledFormant = panel_.knobs[1];
+        hw_.SetLed(1, 0, ledFormant, 0);
+
+        // LED_2: Shape (orange)
+        float ledShape = panel_.knobs[2];
+        hw_.SetLed(2, ledShape, ledShape * 0.5f, 0);
+
+        // LED_3: Output level (white/magenta based on mode)
+        float outputLevel = panel_.knobs[6];
+        if (params_.maskingMode == MaskingMode::OFF) {
+            hw_.SetLed(3, outputLevel, outputLevel, outputLevel);
+        } else {
+            hw_.SetLed(3, outputLevel, 0, outputLevel * 0.7f);
+        }
+
+        hw_.UpdateLeds();
+    }
+
+    Hardware& hw_;
+    PulsarEngine pulsar_;
+    LoadMonitor<typename Hardware::Clock> loadMonitor_;
+    float sampleRate_ = 0.0f;
+
+    // Panel state and the parameters mapped from it, published to the
+    // audio callback when they change
+    PanelState panel_;
+    PulsarParams params_;
+    bool paramsDirty_ = true;
+
+    RateTimer controlTimer_;
+    RateTimer ledTimer_;
+    KnobFilter knobFilters_[NUM_PANEL_KNOBS];
+
+    // Gate state for edge detection
+    bool prevGate_ = false;
+
+    bool showLoad_ = false;
+    bool prevHeld_ = false;
+    uint32_t shownMisses_ = 0;
+    uint32_t missFlashUntil_ = 0;
+
+    float captureBuffers_[2][CAPTURE_SAMPLES];
+    float captureMipmaps_[2][SampledPulsaret::MipmapSize(CAPTURE_SAMPLES)];
+    SampledPulsaret captured_[2];
+    volatile size_t captureFill_ = CAPTURE_SAMPLES;
+    int captureSlot_ = 0;
+    bool capturePending_ = false;
+    float captureKnob_ = 0.0f;
+    float tapHeldMs_ = 0.0f;  // As of the last tick the button was down
+
+#if PULSAR_CONVOLUTION
+    Convolver convolver_;
+    float convolverMemory_[Convolver::MemorySize(CONVOLUTION_PARTITION, CONVOLUTION_PARTITIONS)];
+#endif
+
+    // Calibration state, and the V/Oct input as a frequency ratio
+    bool inCalibration_ = false;
+    VoctCalibration calibration_;
+    float pitchRatio_ = 1.0f;
+
+    uint32_t controlTicks_ = 0;
+    uint32_t ledTicks_ = 0;
+    uint32_t publishCount_ = 0;
+    uint32_t captureCount_ = 0;
+};
+
+#endif // PULSAR_FIRMWARE_HPP
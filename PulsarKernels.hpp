@@ -0,0 +1,157 @@
+#pragma once
+#ifndef PULSAR_KERNELS_HPP
+#define PULSAR_KERNELS_HPP
+
+#include "PulsarEngine.hpp"
+#include "PulsaretShapes.hpp"
+#include "PulsaretTables.hpp"
+
+// Shape evaluators for PulsarEngine's specialized render kernels.
+//
+// A kernel renders the common case (one formant, naive edges, no
+// audio-rate modulation, no NOISE) with its waveform and envelope
+// fixed at compile time, so the shape pass has no per-sample choice
+// between tables and functions or between morphing and not. Kernels
+// are picked from a dispatch table once per run; anything without a
+// kernel goes through the general renderer.
+//
+// Which kernels are built:
+//   PULSAR_KERNELS  0  none, always the general renderer
+//                   1  table kernels only (8: morph x morph x fold);
+//                      the firmware default, to spare -Os flash
+//                   2  table kernels plus computed-shape kernels, one
+//                      per waveform/envelope pair and morph/fold
+//                      setting (host default)
+//   PULSAR_KERNEL_WAVEFORMS, PULSAR_KERNEL_ENVELOPES
+//                   bitmasks (bit n = shape n in enum order) limiting
+//                   the computed kernels to some shapes
+#ifndef PULSAR_KERNELS
+#if defined(__arm__)
+#define PULSAR_KERNELS 1
+#else
+#define PULSAR_KERNELS 2
+#endif
+#endif
+
+#ifndef PULSAR_KERNEL_WAVEFORMS
+#define PULSAR_KERNEL_WAVEFORMS 0x3F  // All but NOISE, which never has one
+#endif
+
+#ifndef PULSAR_KERNEL_ENVELOPES
+#define PULSAR_KERNEL_ENVELOPES 0x7F
+#endif
+
+namespace kernel {
+
+// Samples per timeline/shape pass
+static constexpr size_t CHUNK = 32;
+
+// Waveform from its table, morphing into the next one if MORPH
+template <bool MORPH>
+struct TableWave {
+    const float* tableA;
+    const float* tableB;
+    float morph;
+
+    TableWave(PulsaretWaveform a, PulsaretWaveform b, float m)
+        : tableA(PulsaretTables::Waveform(a)),
+          tableB(MORPH ? PulsaretTables::Waveform(b) : nullptr),
+          morph(m) {}
+
+    float operator()(float phase) const {
+        float sample = PulsaretTables::Lookup(tableA, phase);
+        if (MORPH) {
+            float next = PulsaretTables::Lookup(tableB, phase);
+            sample += (next - sample) * morph;
+        }
+        return sample;
+    }
+};
+
+template <bool MORPH>
+struct TableEnv {
+    const float* tableA;
+    const float* tableB;
+    float morph;
+
+    TableEnv(PulsaretEnvelope a, PulsaretEnvelope b, float m)
+        : tableA(PulsaretTables::Envelope(a)),
+          tableB(MORPH ? PulsaretTables::Envelope(b) : nullptr),
+          morph(m) {}
+
+    float operator()(float phase) const {
+        float env = PulsaretTables::Lookup(tableA, phase);
+        if (MORPH) {
+            float next = PulsaretTables::Lookup(tableB, phase);
+            env += (next - env) * morph;
+        }
+        return env;
+    }
+};
+
+// Reference shapes, resolved at compile time
+template <int W>
+inline float ComputeWave(float phase) {
+    const float noise = 0.0f;  // NOISE has no kernel
+    switch (static_cast<PulsaretWaveform>(W)) {
+        case PulsaretWaveform::SINE:      return pulsaret::WaveSine(phase, noise);
+        case PulsaretWaveform::TRIANGLE:  return pulsaret::WaveTriangle(phase, noise);
+        case PulsaretWaveform::SAW_UP:    return pulsaret::WaveSawUp(phase, noise);
+        case PulsaretWaveform::SAW_DOWN:  return pulsaret::WaveSawDown(phase, noise);
+        case PulsaretWaveform::SQUARE:    return pulsaret::WaveSquare(phase, noise);
+        case PulsaretWaveform::PULSE:     return pulsaret::WavePulse(phase, noise);
+        case PulsaretWaveform::NOISE:     break;
+    }
+    return 0.0f;
+}
+
+template <int E>
+inline float ComputeEnv(float phase) {
+    switch (static_cast<PulsaretEnvelope>(E)) {
+        case PulsaretEnvelope::RECTANGULAR:   return pulsaret::EnvRectangular(phase);
+        case PulsaretEnvelope::GAUSSIAN:      return pulsaret::EnvGaussian(phase);
+        case PulsaretEnvelope::EXPODEC:       return pulsaret::EnvExpoDec(phase);
+        case PulsaretEnvelope::LINEAR_DECAY:  return pulsaret::EnvLinearDecay(phase);
+        case PulsaretEnvelope::LINEAR_ATTACK: return pulsaret::EnvLinearAttack(phase);
+        case PulsaretEnvelope::EXPO_ATTACK:   return pulsaret::EnvExpoAttack(phase);
+        case PulsaretEnvelope::FOF:           return pulsaret::EnvFof(phase);
+    }
+    return 0.0f;
+}
+
+// Computed waveform W, morphing into W + 1 if MORPH
+template <int W, bool MORPH>
+struct ComputedWave {
+    float morph;
+
+    ComputedWave(PulsaretWaveform, PulsaretWaveform, float m) : morph(m) {}
+
+    float operator()(float phase) const {
+        float sample = ComputeWave<W>(phase);
+        if (MORPH) {
+            float next = ComputeWave<(W < 6) ? W + 1 : 6>(phase);
+            sample += (next - sample) * morph;
+        }
+        return sample;
+    }
+};
+
+template <int E, bool MORPH>
+struct ComputedEnv {
+    float morph;
+
+    ComputedEnv(PulsaretEnvelope, PulsaretEnvelope, float m) : morph(m) {}
+
+    float operator()(float phase) const {
+        float env = ComputeEnv<E>(phase);
+        if (MORPH) {
+            float next = ComputeEnv<(E < 6) ? E + 1 : 6>(phase);
+            env += (next - env) * morph;
+        }
+        return env;
+    }
+};
+
+}  // namespace kernel
+
+#endif // PULSAR_KERNELS_HPP
@@ -0,0 +1,200 @@
+#pragma once
+#ifndef PULSAR_SIMD_HPP
+#define PULSAR_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(PULSAR_SIMD_PORTABLE)
+// Forced portable backend
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Minimal fixed-width float/int vectors for the multi-voice kernels.
+//
+// One backend is selected at compile time:
+//   AVX2      8 lanes (host, -mavx2 or -march=native)
+//   SSE2      4 lanes (any x86-64 host)
+//   portable  4 lanes of plain scalar code. The Cortex-M7 has no float
+//             SIMD (its DSP extensions are 8/16-bit integer only), so on
+//             the module this unrolls into independent FPU operations
+//             that keep the dual-issue pipeline busy. Define
+//             PULSAR_SIMD_PORTABLE to force it on any target.
+//
+// Lane masks use all-ones/all-zeros per lane, and selection is a blend
+// rather than a branch.
+
+namespace simd {
+
+#if defined(__AVX2__) && !defined(PULSAR_SIMD_PORTABLE)
+
+static constexpr size_t WIDTH = 8;
+static constexpr const char* BACKEND = "avx2";
+
+struct Float { __m256 v; };
+struct Int { __m256i v; };
+struct Mask { __m256 v; };
+
+inline Float Set1(float x) { return Float{_mm256_set1_ps(x)}; }
+inline Float Load(const float* p) { return Float{_mm256_load_ps(p)}; }
+inline Float LoadUnaligned(const float* p) { return Float{_mm256_loadu_ps(p)}; }
+inline void Store(float* p, Float a) { _mm256_store_ps(p, a.v); }
+inline Float operator+(Float a, Float b) { return Float{_mm256_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return Float{_mm256_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return Float{_mm256_mul_ps(a.v, b.v)}; }
+inline Float Min(Float a, Float b) { return Float{_mm256_min_ps(a.v, b.v)}; }
+inline Float Max(Float a, Float b) { return Float{_mm256_max_ps(a.v, b.v)}; }
+inline Mask operator<(Float a, Float b) { return Mask{_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; }
+inline Mask operator>=(Float a, Float b) { return Mask{_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)}; }
+inline Mask operator&(Mask a, Mask b) { return Mask{_mm256_and_ps(a.v, b.v)}; }
+inline Float Select(Mask m, Float a, Float b) { return Float{_mm256_blendv_ps(b.v, a.v, m.v)}; }
+inline int Bits(Mask m) { return _mm256_movemask_ps(m.v); }
+
+inline float HorizontalSum(Float a) {
+    __m128 lo = _mm256_castps256_ps128(a.v);
+    __m128 hi = _mm256_extractf128_ps(a.v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    return _mm_cvtss_f32(lo);
+}
+
+inline Int LoadInt(const uint32_t* p) { return Int{_mm256_load_si256(reinterpret_cast<const __m256i*>(p))}; }
+inline void StoreInt(uint32_t* p, Int a) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v); }
+inline Int Set1Int(uint32_t x) { return Int{_mm256_set1_epi32(static_cast<int>(x))}; }
+inline Int operator+(Int a, Int b) { return Int{_mm256_add_epi32(a.v, b.v)}; }
+inline Int operator*(Int a, Int b) { return Int{_mm256_mullo_epi32(a.v, b.v)}; }
+inline Int operator^(Int a, Int b) { return Int{_mm256_xor_si256(a.v, b.v)}; }
+inline Int operator&(Int a, Int b) { return Int{_mm256_and_si256(a.v, b.v)}; }
+template <int N> inline Int ShiftLeft(Int a) { return Int{_mm256_slli_epi32(a.v, N)}; }
+template <int N> inline Int ShiftRight(Int a) { return Int{_mm256_srli_epi32(a.v, N)}; }
+inline Int Truncate(Float a) { return Int{_mm256_cvttps_epi32(a.v)}; }
+inline Float ToFloat(Int a) { return Float{_mm256_cvtepi32_ps(a.v)}; }
+inline Int AsInt(Float a) { return Int{_mm256_castps_si256(a.v)}; }
+inline Float AsFloat(Int a) { return Float{_mm256_castsi256_ps(a.v)}; }
+inline Float Gather(const float* base, Int index) { return Float{_mm256_i32gather_ps(base, index.v, 4)}; }
+
+#elif defined(__SSE2__) && !defined(PULSAR_SIMD_PORTABLE)
+
+static constexpr size_t WIDTH = 4;
+static constexpr const char* BACKEND = "sse2";
+
+struct Float { __m128 v; };
+struct Int { __m128i v; };
+struct Mask { __m128 v; };
+
+inline Float Set1(float x) { return Float{_mm_set1_ps(x)}; }
+inline Float Load(const float* p) { return Float{_mm_load_ps(p)}; }
+inline Float LoadUnaligned(const float* p) { return Float{_mm_loadu_ps(p)}; }
+inline void Store(float* p, Float a) { _mm_store_ps(p, a.v); }
+inline Float operator+(Float a, Float b) { return Float{_mm_add_ps(a.v, b.v)}; }
+inline Float operator-(Float a, Float b) { return Float{_mm_sub_ps(a.v, b.v)}; }
+inline Float operator*(Float a, Float b) { return Float{_mm_mul_ps(a.v, b.v)}; }
+inline Float Min(Float a, Float b) { return Float{_mm_min_ps(a.v, b.v)}; }
+inline Float Max(Float a, Float b) { return Float{_mm_max_ps(a.v, b.v)}; }
+inline Mask operator<(Float a, Float b) { return Mask{_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask operator>=(Float a, Float b) { return Mask{_mm_cmpge_ps(a.v, b.v)}; }
+inline Mask operator&(Mask a, Mask b) { return Mask{_mm_and_ps(a.v, b.v)}; }
+inline Float Select(Mask m, Float a, Float b) {
+    return Float{_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+}
+inline int Bits(Mask m) { return _mm_movemask_ps(m.v); }
+
+inline float HorizontalSum(Float a) {
+    __m128 s = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+inline Int LoadInt(const uint32_t* p) { return Int{_mm_load_si128(reinterpret_cast<const __m128i*>(p))}; }
+inline void StoreInt(uint32_t* p, Int a) { _mm_store_si128(reinterpret_cast<__m128i*>(p), a.v); }
+inline Int Set1Int(uint32_t x) { return Int{_mm_set1_epi32(static_cast<int>(x))}; }
+inline Int operator+(Int a, Int b) { return Int{_mm_add_epi32(a.v, b.v)}; }
+inline Int operator*(Int a, Int b) {
+    // SSE2 has only the 32x32->64 multiply of even lanes; do the odd
+    // lanes shifted down and interleave the low halves
+    __m128i even = _mm_mul_epu32(a.v, b.v);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+    return Int{_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+}
+inline Int operator^(Int a, Int b) { return Int{_mm_xor_si128(a.v, b.v)}; }
+inline Int operator&(Int a, Int b) { return Int{_mm_and_si128(a.v, b.v)}; }
+template <int N> inline Int ShiftLeft(Int a) { return Int{_mm_slli_epi32(a.v, N)}; }
+template <int N> inline Int ShiftRight(Int a) { return Int{_mm_srli_epi32(a.v, N)}; }
+inline Int Truncate(Float a) { return Int{_mm_cvttps_epi32(a.v)}; }
+inline Float ToFloat(Int a) { return Float{_mm_cvtepi32_ps(a.v)}; }
+inline Int AsInt(Float a) { return Int{_mm_castps_si128(a.v)}; }
+inline Float AsFloat(Int a) { return Float{_mm_castsi128_ps(a.v)}; }
+
+inline Float Gather(const float* base, Int index) {
+    alignas(16) int32_t i[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(i), index.v);
+    return Float{_mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]])};
+}
+
+#else
+
+static constexpr size_t WIDTH = 4;
+static constexpr const char* BACKEND = "portable";
+
+struct Float { float v[WIDTH]; };
+struct Int { uint32_t v[WIDTH]; };
+struct Mask { bool v[WIDTH]; };
+
+#define SIMD_LANES for (size_t l = 0; l < WIDTH; ++l)
+
+inline Float Set1(float x) { Float r; SIMD_LANES r.v[l] = x; return r; }
+inline Float Load(const float* p) { Float r; SIMD_LANES r.v[l] = p[l]; return r; }
+inline Float LoadUnaligned(const float* p) { return Load(p); }
+inline void Store(float* p, Float a) { SIMD_LANES p[l] = a.v[l]; }
+inline Float operator+(Float a, Float b) { SIMD_LANES a.v[l] += b.v[l]; return a; }
+inline Float operator-(Float a, Float b) { SIMD_LANES a.v[l] -= b.v[l]; return a; }
+inline Float operator*(Float a, Float b) { SIMD_LANES a.v[l] *= b.v[l]; return a; }
+inline Float Min(Float a, Float b) { SIMD_LANES a.v[l] = (b.v[l] < a.v[l]) ? b.v[l] : a.v[l]; return a; }
+inline Float Max(Float a, Float b) { SIMD_LANES a.v[l] = (b.v[l] > a.v[l]) ? b.v[l] : a.v[l]; return a; }
+inline Mask operator<(Float a, Float b) { Mask m; SIMD_LANES m.v[l] = a.v[l] < b.v[l]; return m; }
+inline Mask operator>=(Float a, Float b) { Mask m; SIMD_LANES m.v[l] = a.v[l] >= b.v[l]; return m; }
+inline Mask operator&(Mask a, Mask b) { SIMD_LANES a.v[l] = a.v[l] && b.v[l]; return a; }
+inline Float Select(Mask m, Float a, Float b) { SIMD_LANES a.v[l] = m.v[l] ? a.v[l] : b.v[l]; return a; }
+inline int Bits(Mask m) { int bits = 0; SIMD_LANES bits |= m.v[l] ? (1 << l) : 0; return bits; }
+inline float HorizontalSum(Float a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+
+inline Int LoadInt(const uint32_t* p) { Int r; SIMD_LANES r.v[l] = p[l]; return r; }
+inline void StoreInt(uint32_t* p, Int a) { SIMD_LANES p[l] = a.v[l]; }
+inline Int Set1Int(uint32_t x) { Int r; SIMD_LANES r.v[l] = x; return r; }
+inline Int operator+(Int a, Int b) { SIMD_LANES a.v[l] += b.v[l]; return a; }
+inline Int operator*(Int a, Int b) { SIMD_LANES a.v[l] *= b.v[l]; return a; }
+inline Int operator^(Int a, Int b) { SIMD_LANES a.v[l] ^= b.v[l]; return a; }
+inline Int operator&(Int a, Int b) { SIMD_LANES a.v[l] &= b.v[l]; return a; }
+template <int N> inline Int ShiftLeft(Int a) { SIMD_LANES a.v[l] <<= N; return a; }
+template <int N> inline Int ShiftRight(Int a) { SIMD_LANES a.v[l] >>= N; return a; }
+inline Int Truncate(Float a) {
+    Int r;
+    SIMD_LANES r.v[l] = static_cast<uint32_t>(static_cast<int32_t>(a.v[l]));
+    return r;
+}
+inline Float ToFloat(Int a) {
+    Float r;
+    SIMD_LANES r.v[l] = static_cast<float>(static_cast<int32_t>(a.v[l]));
+    return r;
+}
+inline Int AsInt(Float a) { Int r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline Float AsFloat(Int a) { Float r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline Float Gather(const float* base, Int index) {
+    Float r;
+    SIMD_LANES r.v[l] = base[static_cast<int32_t>(index.v[l])];
+    return r;
+}
+
+#undef SIMD_LANES
+
+#endif
+
+}  // namespace simd
+
+#endif // PULSAR_SIMD_HPP
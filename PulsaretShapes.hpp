@@ -0,0 +1,122 @@
+#pragma once
+#ifndef PULSARET_SHAPES_HPP
+#define PULSARET_SHAPES_HPP
+
+#include <cstdint>
+#include <cmath>
+#include "FastMath.hpp"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+// Reference pulsaret waveform and envelope shapes, evaluated at a
+// pulsaret phase of 0.0 to 1.0. The engine's computed path and the
+// precomputed tables are both built from these.
+
+namespace pulsaret {
+
+static constexpr float TWO_PI = 2.0f * M_PI;
+
+// Pulsaret waveforms, in PulsaretWaveform order. NOISE plays the
+// caller's noise draw (-1.0 to 1.0); the other shapes ignore it.
+inline float WaveSine(float phase, float) {
+    return fastmath::Sin2Pi(phase);
+}
+
+inline float WaveTriangle(float phase, float) {
+    if (phase < 0.25f) {
+        return phase * 4.0f;
+    } else if (phase < 0.75f) {
+        return 1.0f - (phase - 0.25f) * 4.0f;
+    }
+    return (phase - 0.75f) * 4.0f - 1.0f;
+}
+
+inline float WaveSawUp(float phase, float) {
+    return 2.0f * phase - 1.0f;
+}
+
+inline float WaveSawDown(float phase, float) {
+    return 1.0f - 2.0f * phase;
+}
+
+inline float WaveSquare(float phase, float) {
+    return (phase < 0.5f) ? 1.0f : -1.0f;
+}
+
+inline float WavePulse(float phase, float) {
+    // Narrow pulse (25% duty)
+    return (phase < 0.25f) ? 1.0f : -0.33f;
+}
+
+inline float WaveNoise(float, float noise) {
+    return noise;
+}
+
+// Pulsaret envelopes, in PulsaretEnvelope order
+inline float EnvRectangular(float) {
+    return 1.0f;
+}
+
+inline float EnvGaussian(float phase) {
+    // Gaussian centered at 0.5
+    float x = (phase - 0.5f) * 3.0f;
+    return fastmath::Exp(-x * x);
+}
+
+inline float EnvExpoDec(float phase) {
+    // Exponential decay
+    float decay = 4.0f;
+    return fastmath::Exp(-phase * decay);
+}
+
+inline float EnvLinearDecay(float phase) {
+    return 1.0f - phase;
+}
+
+inline float EnvLinearAttack(float phase) {
+    return phase;
+}
+
+inline float EnvExpoAttack(float phase) {
+    // Exponential attack
+    float attack = 4.0f;
+    return 1.0f - fastmath::Exp(-phase * attack);
+}
+
+inline float EnvFof(float phase) {
+    // FOF-style: sharp attack, exponential decay
+    float attackTime = 0.1f;
+    if (phase < attackTime) {
+        return phase / attackTime;
+    }
+    float decay = 3.0f;
+    return fastmath::Exp(-(phase - attackTime) * decay);
+}
+
+// Two-sample polynomial residuals for band-limiting a discontinuity,
+// evaluated at x, the signed distance from the edge in samples
+// (-1 < x < 1). PolyBlep is for a unit step in value, PolyBlamp for a
+// unit step in slope (per sample). Add height * residual to the naive
+// signal.
+inline float PolyBlep(float x) {
+    if (x < 0.0f) {
+        float t = 1.0f + x;
+        return 0.5f * t * t;
+    }
+    float t = 1.0f - x;
+    return -0.5f * t * t;
+}
+
+inline float PolyBlamp(float x) {
+    float t = (x < 0.0f) ? 1.0f + x : 1.0f - x;
+    return t * t * t * (1.0f / 6.0f);
+}
+
+typedef float (*WaveformFn)(float phase, float noise);
+typedef float (*EnvelopeFn)(float phase);
+
+}  // namespace pulsaret
+
+#endif // PULSARET_SHAPES_HPP
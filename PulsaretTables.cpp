@@ -0,0 +1,35 @@
+#include "PulsaretTables.hpp"
+#include "PulsaretShapes.hpp"
+
+alignas(32) float PulsaretTables::waveforms_[NUM_WAVEFORMS][TABLE_STRIDE];
+alignas(32) float PulsaretTables::envelopes_[NUM_ENVELOPES][TABLE_STRIDE];
+bool PulsaretTables::initialized_ = false;
+
+void PulsaretTables::Init() {
+    if (initialized_) {
+        return;
+    }
+
+    using namespace pulsaret;
+    const WaveformFn waveformFns[NUM_WAVEFORMS - 1] = {
+        WaveSine, WaveTriangle, WaveSawUp, WaveSawDown, WaveSquare, WavePulse
+    };
+    const EnvelopeFn envelopeFns[NUM_ENVELOPES] = {
+        EnvRectangular, EnvGaussian, EnvExpoDec, EnvLinearDecay,
+        EnvLinearAttack, EnvExpoAttack, EnvFof
+    };
+
+    for (int i = 0; i < TABLE_STRIDE; ++i) {
+        float phase = static_cast<float>(i) / static_cast<float>(WAVETABLE_SIZE);
+        for (int w = 0; w < NUM_WAVEFORMS - 1; ++w) {
+            waveforms_[w][i] = waveformFns[w](phase, 0.0f);
+        }
+        // NOISE is generated at run time
+        waveforms_[NUM_WAVEFORMS - 1][i] = 0.0f;
+        for (int e = 0; e < NUM_ENVELOPES; ++e) {
+            envelopes_[e][i] = envelopeFns[e](phase);
+        }
+    }
+
+    initialized_ = true;
+}
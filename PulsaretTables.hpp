@@ -0,0 +1,48 @@
+#pragma once
+#ifndef PULSARET_TABLES_HPP
+#define PULSARET_TABLES_HPP
+
+#include "PulsarEngine.hpp"
+
+// Precomputed pulsaret waveform and envelope tables.
+//
+// Each shape is sampled at WAVETABLE_SIZE points over one pulsaret plus
+// a guard point at phase 1.0, and read with linear interpolation. The
+// tables are shared by all engines and built once on the first Init().
+// Interpolation error is below 1e-4 for the smooth shapes; the hard
+// edges of SQUARE, PULSE and FOF's attack knee are smeared across one
+// table cell. NOISE cannot be tabulated: its row is all zeros and
+// callers add the generator output instead.
+class PulsaretTables {
+public:
+    static constexpr int NUM_WAVEFORMS = 7;
+    static constexpr int NUM_ENVELOPES = 7;
+    static constexpr int TABLE_STRIDE = WAVETABLE_SIZE + 1;
+
+    // Build the tables (no-op after the first call)
+    static void Init();
+
+    static const float* Waveform(PulsaretWaveform waveform) {
+        return waveforms_[static_cast<int>(waveform)];
+    }
+
+    static const float* Envelope(PulsaretEnvelope envelope) {
+        return envelopes_[static_cast<int>(envelope)];
+    }
+
+    // Interpolated read at phase 0.0 to 1.0
+    static float Lookup(const float* table, float phase) {
+        float index = phase * static_cast<float>(WAVETABLE_SIZE);
+        int i = static_cast<int>(index);
+        i = (i < WAVETABLE_SIZE) ? i : WAVETABLE_SIZE - 1;
+        float frac = index - static_cast<float>(i);
+        return table[i] + (table[i + 1] - table[i]) * frac;
+    }
+
+private:
+    alignas(32) static float waveforms_[NUM_WAVEFORMS][TABLE_STRIDE];
+    alignas(32) static float envelopes_[NUM_ENVELOPES][TABLE_STRIDE];
+    static bool initialized_;
+};
+
+#endif // PULSARET_TABLES_HPP
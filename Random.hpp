@@ -0,0 +1,149 @@
+#pragma once
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "PulsarSimd.hpp"
+
+// Counter-based random streams for noise, stochastic masking and jitter.
+//
+// Draw n of a stream is a hash of n and the stream's key, so there is
+// no chained state: a block can be filled simd::WIDTH draws at a time,
+// a stream can jump ahead by any count in constant time, and streams
+// with different keys are independent of one another. The hash is a
+// Weyl step (n times the golden ratio) xored with the key, finished
+// with the two-multiply lowbias32 integer mixer; each stream has a
+// period of 2^32 draws.
+//
+// Keys come from a seed and a stream id, so one seed gives every user
+// its own stream, and changing the seed changes them all.
+
+namespace rng {
+
+// 2^32 / golden ratio, odd
+static constexpr uint32_t GAMMA = 0x9E3779B9u;
+
+// Stream ids; per-voice streams add the voice number shifted by
+// VOICE_SHIFT to the kind
+static constexpr uint32_t NOISE = 1;
+static constexpr uint32_t MASKING = 2;
+static constexpr uint32_t JITTER = 3;
+static constexpr uint32_t SCATTER = 4;
+static constexpr int VOICE_SHIFT = 8;
+
+static constexpr uint32_t DEFAULT_SEED = 12345;
+
+// lowbias32 (Wellons): a bijection on 32 bits with full avalanche
+inline uint32_t Mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline simd::Int Mix(simd::Int x) {
+    using namespace simd;
+    x = x ^ ShiftRight<16>(x);
+    x = x * Set1Int(0x7FEB352Du);
+    x = x ^ ShiftRight<15>(x);
+    x = x * Set1Int(0x846CA68Bu);
+    x = x ^ ShiftRight<16>(x);
+    return x;
+}
+
+// Key of one stream under a seed
+inline uint32_t Key(uint32_t seed, uint32_t stream) {
+    return Mix(Mix(seed) ^ (stream * GAMMA));
+}
+
+// Top 24 bits as 0.0 to 1.0 (exclusive) and as -1.0 to 1.0, exact
+inline float ToUnit(uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+inline float ToBipolar(uint32_t bits) {
+    return static_cast<float>(bits >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+inline simd::Float ToBipolar(simd::Int bits) {
+    using namespace simd;
+    return ToFloat(ShiftRight<8>(bits)) * Set1(2.0f / 16777216.0f) - Set1(1.0f);
+}
+
+// Draw position of the stream with key
+inline uint32_t Bits(uint32_t key, uint32_t position) {
+    return Mix((position * GAMMA) ^ key);
+}
+
+// Weyl steps of WIDTH consecutive draws starting at position; add
+// Set1Int(WIDTH * GAMMA) to move on by WIDTH draws
+inline simd::Int Counters(uint32_t position) {
+    alignas(32) uint32_t lanes[simd::WIDTH];
+    for (size_t l = 0; l < simd::WIDTH; ++l) {
+        lanes[l] = (position + static_cast<uint32_t>(l)) * GAMMA;
+    }
+    return simd::LoadInt(lanes);
+}
+
+}  // namespace rng
+
+// One stream: a key and the position of the next draw
+class RandomStream {
+public:
+    RandomStream() { Seed(rng::DEFAULT_SEED, 0); }
+
+    // Select the stream under seed and start it from the beginning
+    void Seed(uint32_t seed, uint32_t stream) {
+        key_ = rng::Key(seed, stream);
+        position_ = 0;
+    }
+
+    uint32_t NextBits() { return rng::Bits(key_, position_++); }
+
+    // 0.0 to 1.0 (exclusive)
+    float Next() { return rng::ToUnit(NextBits()); }
+
+    // -1.0 to 1.0
+    float NextBipolar() { return rng::ToBipolar(NextBits()); }
+
+    // Draw from count positions ahead without moving the stream
+    float PeekBipolar(uint32_t ahead) const {
+        return rng::ToBipolar(rng::Bits(key_, position_ + ahead));
+    }
+
+    // The next size draws of NextBipolar, simd::WIDTH at a time
+    void FillBipolar(float* out, size_t size) {
+        using namespace simd;
+        const Int key = Set1Int(key_);
+        const Int stride = Set1Int(static_cast<uint32_t>(WIDTH) * rng::GAMMA);
+        Int counter = rng::Counters(position_);
+        alignas(32) float block[WIDTH];
+        size_t i = 0;
+        for (; i + WIDTH <= size; i += WIDTH) {
+            Store(block, rng::ToBipolar(rng::Mix(counter ^ key)));
+            for (size_t l = 0; l < WIDTH; ++l) {
+                out[i + l] = block[l];
+            }
+            counter = counter + stride;
+        }
+        position_ += static_cast<uint32_t>(i);
+        for (; i < size; ++i) {
+            out[i] = NextBipolar();
+        }
+    }
+
+    // Move on by count draws, as if they had been taken
+    void Skip(uint32_t count) { position_ += count; }
+
+    uint32_t GetPosition() const { return position_; }
+    void SetPosition(uint32_t position) { position_ = position; }
+
+private:
+    uint32_t key_;
+    uint32_t position_;
+};
+
+#endif // RANDOM_HPP
@@ -0,0 +1,92 @@
+#include "SampledPulsaret.hpp"
+#include "Oversampler.hpp"
+#include <cmath>
+
+namespace {
+
+// Half-band taps either side of the centre; 31 taps in all, the same
+// filter as the oversampler's first stage
+static constexpr int HALF_LENGTH = HalfBand::MAX_HALF_LENGTH;
+
+// Halve in to out through the half-band filter, centred so that out[j]
+// lines up with in[2j]. The pulsaret is silent outside the source, which
+// the last output may run one sample past.
+void Decimate(const float* in, size_t inLength, float* out, size_t outLength,
+              const float* branch) {
+    for (size_t j = 0; j < outLength; ++j) {
+        const long center = static_cast<long>(2 * j);
+        float sum = (center < static_cast<long>(inLength)) ? 0.5f * in[center] : 0.0f;
+        for (int i = 0; i < HALF_LENGTH; ++i) {
+            const long d = 2 * i + 1;
+            float h = branch[HALF_LENGTH - 1 - i];
+            float before = (center - d >= 0) ? in[center - d] : 0.0f;
+            float after = (center + d < static_cast<long>(inLength)) ? in[center + d] : 0.0f;
+            sum += h * (before + after);
+        }
+        out[j] = sum;
+    }
+}
+
+}  // namespace
+
+bool SampledPulsaret::Init(const float* source, size_t length, float* mipmaps,
+                           size_t mipmapSize) {
+    Clear();
+    if (source == nullptr || length < MIN_LENGTH || mipmapSize < MipmapSize(length)) {
+        return false;
+    }
+
+    float branch[2 * HALF_LENGTH];
+    HalfBand::Design(HALF_LENGTH, branch);
+
+    levels_[0] = source;
+    lengths_[0] = length;
+    scales_[0] = static_cast<float>(length - 1);
+    int count = 1;
+    while (count < MAX_LEVELS && lengths_[count - 1] > MIN_LEVEL_LENGTH) {
+        // Enough samples to reach the parent's last at half the scale
+        size_t inLength = lengths_[count - 1];
+        size_t outLength = inLength / 2 + 1;
+        Decimate(levels_[count - 1], inLength, mipmaps, outLength, branch);
+        levels_[count] = mipmaps;
+        lengths_[count] = outLength;
+        scales_[count] = 0.5f * scales_[count - 1];
+        mipmaps += outLength;
+        ++count;
+    }
+    levelCount_ = count;
+    return true;
+}
+
+void SampledPulsaret::Clear() {
+    for (int level = 0; level < MAX_LEVELS; ++level) {
+        levels_[level] = nullptr;
+        lengths_[level] = 0;
+        scales_[level] = 0.0f;
+    }
+    levelCount_ = 0;
+}
+
+SampledPulsaret::Reader SampledPulsaret::Select(float phaseStep) const {
+    // Octaves above one level-0 sample per output sample; each level
+    // above that halves the step
+    float samplesPerStep = phaseStep * static_cast<float>(lengths_[0] - 1);
+    float octaves = (samplesPerStep > 1.0f) ? log2f(samplesPerStep) : 0.0f;
+    int level = static_cast<int>(octaves);
+    float blend = octaves - static_cast<float>(level);
+    if (level >= levelCount_ - 1) {
+        level = levelCount_ - 1;
+        blend = 0.0f;
+    }
+    int next = (blend > 0.0f) ? level + 1 : level;
+
+    Reader reader;
+    reader.levelA = levels_[level];
+    reader.levelB = levels_[next];
+    reader.scaleA = scales_[level];
+    reader.scaleB = scales_[next];
+    reader.lastA = lengths_[level] - 2;
+    reader.lastB = lengths_[next] - 2;
+    reader.blend = blend;
+    return reader;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef SAMPLED_PULSARET_HPP
+#define SAMPLED_PULSARET_HPP
+
+#include <cstddef>
+
+// User-sampled pulsaret waveform with a mipmap of band-limited copies.
+//
+// The source samples span one pulsaret, phase 0.0 to 1.0, and are used
+// in place as level 0. Each further level halves the previous one
+// through a half-band filter (see HalfBand::Design), so level k holds
+// only what can be played back k octaves faster without aliasing.
+// Sample j of level k lines up with source sample j * 2^k, and each
+// level runs on to cover the source's last sample, so every level
+// plays the same span at the same phase. A Reader picks the pair of
+// levels for the rate the pulsaret is played at, which the formant
+// ratio sets, and crossfades between them, so reads stay close to one
+// sample apart and walk the level in order.
+//
+// Nothing is allocated or copied: the caller provides the source and
+// the storage for the levels above it, and both must outlive the
+// pulsaret and any engine playing it.
+class SampledPulsaret {
+public:
+    static constexpr int MAX_LEVELS = 12;
+
+    // Levels stop halving at this many samples
+    static constexpr size_t MIN_LEVEL_LENGTH = 8;
+
+    // Shortest usable source
+    static constexpr size_t MIN_LENGTH = 2;
+
+    // Floats of mipmap storage Init needs for a source of length samples
+    static constexpr size_t MipmapSize(size_t length) {
+        size_t total = 0;
+        for (int level = 1; level < MAX_LEVELS && length > MIN_LEVEL_LENGTH; ++level) {
+            length = length / 2 + 1;
+            total += length;
+        }
+        return total;
+    }
+
+    // Interpolated reads for one playback rate
+    struct Reader {
+        const float* levelA;
+        const float* levelB;
+        float scaleA;  // Pulsaret phase to sample position
+        float scaleB;
+        size_t lastA;  // Index of the last interpolation start
+        size_t lastB;
+        float blend;   // Share of levelB
+
+        // Sample at pulsaret phase 0.0 to 1.0
+        float operator()(float phase) const {
+            float a = Read(levelA, scaleA, lastA, phase);
+            if (blend <= 0.0f) {
+                return a;
+            }
+            return a + (Read(levelB, scaleB, lastB, phase) - a) * blend;
+        }
+
+    private:
+        static float Read(const float* level, float scale, size_t last, float phase) {
+            float position = phase * scale;
+            size_t i = static_cast<size_t>(position);
+            i = (i < last) ? i : last;
+            float frac = position - static_cast<float>(i);
+            return level[i] + (level[i + 1] - level[i]) * frac;
+        }
+    };
+
+    SampledPulsaret() { Clear(); }
+
+    // Use length samples at source as level 0 and build the other levels
+    // into mipmaps, which holds mipmapSize floats. Returns false, and
+    // leaves the pulsaret empty, if the source is shorter than
+    // MIN_LENGTH or the storage is smaller than MipmapSize(length).
+    bool Init(const float* source, size_t length, float* mipmaps, size_t mipmapSize);
+
+    // Forget the source; an empty pulsaret reads as silence
+    void Clear();
+
+    bool IsEmpty() const { return levelCount_ == 0; }
+    int GetLevelCount() const { return levelCount_; }
+    size_t GetLength(int level) const { return lengths_[level]; }
+    const float* GetLevel(int level) const { return levels_[level]; }
+
+    // Reader for playback that advances the pulsaret phase by phaseStep
+    // per sample. Must not be empty.
+    Reader Select(float phaseStep) const;
+
+private:
+    const float* levels_[MAX_LEVELS];
+    size_t lengths_[MAX_LEVELS];
+    float scales_[MAX_LEVELS];  // Pulsaret phase to position in the level
+    int levelCount_;
+};
+
+#endif // SAMPLED_PULSARET_HPP
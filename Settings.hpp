@@ -0,0 +1,44 @@
+#pragma once
+#ifndef SETTINGS_HPP
+#define SETTINGS_HPP
+
+#include "VoctCalibration.hpp"
+#include <cstdint>
+#include <cstring>
+
+// Settings kept in flash across power cycles, through the hardware's
+// persistent storage. Bump VERSION when the layout changes.
+struct Settings {
+    static constexpr uint32_t VERSION = 2;
+
+    uint32_t version;
+    // Raw V/Oct reading at 0, 1, ... 5 V
+    float calibrationCodes[VoctCalibration::POINTS];
+
+    bool operator!=(const Settings& a) const {
+        return a.version != version ||
+               std::memcmp(a.calibrationCodes, calibrationCodes, sizeof(calibrationCodes)) != 0;
+    }
+};
+
+// Bring settings read from flash up to VERSION. Version 1 held only
+// {float offset, float unitsPerVolt}, where version and the first code
+// now lie; its line becomes the points. Returns false for anything
+// unrecognized or implausible.
+inline bool UpgradeSettings(Settings& settings) {
+    if (settings.version != Settings::VERSION) {
+        float offset;
+        std::memcpy(&offset, &settings.version, sizeof(offset));
+        float unitsPerVolt = settings.calibrationCodes[0];
+        if (!(offset > 0.0f && offset <= 65535.0f &&
+              unitsPerVolt >= VoctCalibration::MIN_CODES_PER_VOLT &&
+              unitsPerVolt <= VoctCalibration::MAX_CODES_PER_VOLT)) {
+            return false;
+        }
+        settings.version = Settings::VERSION;
+        VoctCalibration::Linear(offset, unitsPerVolt, settings.calibrationCodes);
+    }
+    return VoctCalibration::IsValid(settings.calibrationCodes);
+}
+
+#endif // SETTINGS_HPP
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer snapshot handoff.
+//
+// Three copies of T rotate between the writer, the reader and a shared
+// slot. Publish fills the writer's copy and swaps it into the shared
+// slot; Acquire swaps the shared slot with the reader's copy if it holds
+// something new. Each side does one atomic exchange and never waits, so
+// the reader can run in an interrupt that preempts the writer at any
+// point (a seqlock reader would spin forever there on a single core).
+// The reader always sees a complete snapshot, possibly skipping
+// intermediate ones.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : writeIndex_(0), readIndex_(1), shared_(2) {}
+
+    // Set all three copies; not safe while the reader is running
+    void Init(const T& value) {
+        for (int i = 0; i < 3; ++i) {
+            buffers_[i] = value;
+        }
+        writeIndex_ = 0;
+        readIndex_ = 1;
+        shared_.store(2, std::memory_order_relaxed);
+    }
+
+    // Writer side: copy value in and make it the latest snapshot
+    void Publish(const T& value) {
+        buffers_[writeIndex_] = value;
+        uint8_t previous = shared_.exchange(writeIndex_ | FRESH, std::memory_order_acq_rel);
+        writeIndex_ = previous & INDEX_MASK;
+    }
+
+    // Reader side: take the latest snapshot if there is a new one.
+    // Returns false, keeping the current one, otherwise.
+    bool Acquire() {
+        if ((shared_.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        uint8_t previous = shared_.exchange(readIndex_, std::memory_order_acq_rel);
+        readIndex_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Reader side: the snapshot taken by the last Acquire
+    const T& Read() const { return buffers_[readIndex_]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    T buffers_[3];
+    uint8_t writeIndex_;
+    uint8_t readIndex_;
+    std::atomic<uint8_t> shared_;
+};
+
+#endif // TRIPLE_BUFFER_HPP
@@ -0,0 +1,109 @@
+#pragma once
+#ifndef VOCT_CALIBRATION_HPP
+#define VOCT_CALIBRATION_HPP
+
+#include "FastMath.hpp"
+#include <cstdint>
+
+// V/Oct input calibration: the raw ADC reading measured at each whole
+// volt from 0 to 5 V, joined piecewise linearly so the input tracks
+// across its range rather than along one line fitted to a few volts.
+//
+// Init also tabulates the pitch ratio 2^volts every TABLE_STEP codes,
+// so the control loop turns a reading into a frequency multiplier with
+// one interpolated lookup and no exponential. A step is about a
+// fiftieth of a volt, over which linear interpolation of the
+// exponential, and of the bend where one segment meets the next, stays
+// within a tenth of a cent while the segments' codes per volt agree to
+// within 1%.
+class VoctCalibration {
+public:
+    static constexpr int POINTS = 6;  // 0 V to 5 V
+    static constexpr int TABLE_SHIFT = 8;
+    static constexpr float TABLE_STEP = 1 << TABLE_SHIFT;
+    static constexpr int TABLE_SIZE = (65536 >> TABLE_SHIFT) + 1;
+
+    // Readings fall as the voltage rises, by a plausible amount per volt
+    static constexpr float MIN_CODES_PER_VOLT = 400.0f;
+    static constexpr float MAX_CODES_PER_VOLT = 20000.0f;
+
+    // Points on a straight line through offset at 0 V
+    static void Linear(float offset, float codesPerVolt, float* codes) {
+        for (int v = 0; v < POINTS; ++v) {
+            codes[v] = offset - codesPerVolt * v;
+        }
+    }
+
+    static bool IsValid(const float* codes) {
+        for (int v = 0; v < POINTS; ++v) {
+            if (!(codes[v] >= 0.0f && codes[v] <= 65535.0f)) {
+                return false;
+            }
+            float span = (v > 0) ? codes[v - 1] - codes[v] : MIN_CODES_PER_VOLT;
+            if (!(span >= MIN_CODES_PER_VOLT && span <= MAX_CODES_PER_VOLT)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // codes[v] is the reading at v volts; they must pass IsValid
+    void Init(const float* codes) {
+        minSpan_ = MAX_CODES_PER_VOLT;
+        for (int v = 0; v < POINTS; ++v) {
+            codes_[v] = codes[v];
+            if (v > 0) {
+                float span = codes[v - 1] - codes[v];
+                voltsPerCode_[v - 1] = 1.0f / span;
+                minSpan_ = (span < minSpan_) ? span : minSpan_;
+            }
+        }
+        // The end segments run on past 0 V and 5 V, so the entries
+        // either side of an end agree with the clamped lookup
+        for (int i = 0; i < TABLE_SIZE; ++i) {
+            float code = i * TABLE_STEP;
+            float volts = (code >= codes_[0]) ? (codes_[0] - code) * voltsPerCode_[0]
+                        : (code <= codes_[POINTS - 1])
+                            ? (POINTS - 1) + (codes_[POINTS - 1] - code) * voltsPerCode_[POINTS - 2]
+                            : Volts(code);
+            ratios_[i] = fastmath::Exp2(volts);
+        }
+    }
+
+    // Reading at v volts
+    float Code(int v) const { return codes_[v]; }
+
+    // Volts for a reading, held at 0 V and 5 V beyond the ends
+    float Volts(float code) const {
+        if (code >= codes_[0]) {
+            return 0.0f;
+        }
+        for (int v = 0; v < POINTS - 1; ++v) {
+            if (code > codes_[v + 1]) {
+                return v + (codes_[v] - code) * voltsPerCode_[v];
+            }
+        }
+        return static_cast<float>(POINTS - 1);
+    }
+
+    // 2^Volts(code)
+    float Ratio(float code) const {
+        code = (code > codes_[POINTS - 1]) ? code : codes_[POINTS - 1];
+        code = (code < codes_[0]) ? code : codes_[0];
+        float position = code * (1.0f / TABLE_STEP);
+        int i = static_cast<int>(position);
+        float frac = position - i;
+        return ratios_[i] + (ratios_[i + 1] - ratios_[i]) * frac;
+    }
+
+    // Fewest codes per volt of any segment
+    float GetMinCodesPerVolt() const { return minSpan_; }
+
+private:
+    float codes_[POINTS] = {};
+    float voltsPerCode_[POINTS - 1] = {};
+    float minSpan_ = MAX_CODES_PER_VOLT;
+    float ratios_[TABLE_SIZE] = {};
+};
+
+#endif // VOCT_CALIBRATION_HPP
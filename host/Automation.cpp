@@ -0,0 +1,173 @@
+#include "Automation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Switch position names accepted for each switch, by position
+const char* const POSITION_NAMES[] = {"left", "center", "right"};
+const char* const MASK_NAMES[] = {"off", "burst", "stochastic"};
+const char* const RANGE_NAMES[] = {"low", "mid", "high"};
+const char* const TAP_NAMES[] = {"release", "press"};
+
+bool ParseNumber(const std::string& text, float& value) {
+    char* end = nullptr;
+    value = std::strtof(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0';
+}
+
+bool ParseSwitch(const std::string& text, const char* const* aliases, float& value) {
+    for (int p = 0; p < 3; ++p) {
+        if (text == POSITION_NAMES[p] || text == aliases[p]) {
+            value = static_cast<float>(p);
+            return true;
+        }
+    }
+    return ParseNumber(text, value) && (value == 0.0f || value == 1.0f || value == 2.0f);
+}
+
+bool ParseTap(const std::string& text, float& value) {
+    for (int p = 0; p < 2; ++p) {
+        if (text == TAP_NAMES[p]) {
+            value = static_cast<float>(p);
+            return true;
+        }
+    }
+    return ParseNumber(text, value) && (value == 0.0f || value == 1.0f);
+}
+
+}  // namespace
+
+bool ParseControl(const std::string& name, ControlId& control) {
+    if (name == "mask") {
+        control.kind = ControlId::Kind::MASK_SWITCH;
+    } else if (name == "range") {
+        control.kind = ControlId::Kind::RANGE_SWITCH;
+    } else if (name == "reset") {
+        control.kind = ControlId::Kind::RESET;
+    } else if (name == "tap") {
+        control.kind = ControlId::Kind::TAP;
+    } else if (name.size() == 5 && name.compare(0, 4, "knob") == 0 &&
+               name[4] >= '0' && name[4] < '0' + NUM_PANEL_KNOBS) {
+        control.kind = ControlId::Kind::KNOB;
+        control.knob = name[4] - '0';
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseControlValue(const ControlId& control, const std::string& text, float& value) {
+    switch (control.kind) {
+        case ControlId::Kind::KNOB:
+            return ParseNumber(text, value);
+        case ControlId::Kind::MASK_SWITCH:
+            return ParseSwitch(text, MASK_NAMES, value);
+        case ControlId::Kind::RANGE_SWITCH:
+            return ParseSwitch(text, RANGE_NAMES, value);
+        case ControlId::Kind::RESET:
+            value = 0.0f;
+            return true;
+        case ControlId::Kind::TAP:
+            return ParseTap(text, value);
+    }
+    return false;
+}
+
+std::string ControlName(const ControlId& control) {
+    switch (control.kind) {
+        case ControlId::Kind::KNOB:
+            return "knob" + std::to_string(control.knob);
+        case ControlId::Kind::MASK_SWITCH:
+            return "mask";
+        case ControlId::Kind::RANGE_SWITCH:
+            return "range";
+        case ControlId::Kind::RESET:
+            return "reset";
+        case ControlId::Kind::TAP:
+            return "tap";
+    }
+    return "";
+}
+
+void ApplyControl(const ControlId& control, float value, PanelState& panel,
+                  PulsarParams& params) {
+    switch (control.kind) {
+        case ControlId::Kind::KNOB:
+            panel.knobs[control.knob] = value;
+            break;
+        case ControlId::Kind::MASK_SWITCH:
+            panel.maskSwitch = static_cast<SwitchPosition>(static_cast<int>(value));
+            break;
+        case ControlId::Kind::RANGE_SWITCH:
+            panel.rangeSwitch = static_cast<SwitchPosition>(static_cast<int>(value));
+            break;
+        case ControlId::Kind::RESET:
+            params.resetCount++;
+            break;
+        case ControlId::Kind::TAP:
+            params.resetCount += (value > 0.5f) ? 1 : 0;
+            break;
+    }
+}
+
+bool LoadAutomation(const std::string& path, Automation& automation, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    automation.events.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        std::string timeText;
+        std::string name;
+        std::string valueText;
+        std::string extra;
+        if (!(fields >> timeText)) {
+            continue;
+        }
+        fields >> name >> valueText >> extra;
+
+        const std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+        AutomationEvent event;
+        float time;
+        if (!ParseNumber(timeText, time) || time < 0.0f) {
+            error = where + "bad time '" + timeText + "'";
+            return false;
+        }
+        event.time = time;
+        if (!ParseControl(name, event.control)) {
+            error = where + "unknown control '" + name + "'";
+            return false;
+        }
+        bool needsValue = event.control.kind != ControlId::Kind::RESET;
+        if (needsValue == valueText.empty() || !extra.empty()) {
+            error = where + (needsValue ? "expected one value" : "reset takes no value");
+            return false;
+        }
+        if (!ParseControlValue(event.control, valueText, event.value)) {
+            error = where + "bad value '" + valueText + "' for " + name;
+            return false;
+        }
+        automation.events.push_back(event);
+    }
+
+    std::stable_sort(automation.events.begin(), automation.events.end(),
+                     [](const AutomationEvent& a, const AutomationEvent& b) {
+                         return a.time < b.time;
+                     });
+    return true;
+}
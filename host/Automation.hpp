@@ -0,0 +1,80 @@
+#pragma once
+#ifndef AUTOMATION_HPP
+#define AUTOMATION_HPP
+
+#include "PulsarControls.hpp"
+
+#include <string>
+#include <vector>
+
+// Timestamped panel changes for offline renders.
+//
+// Text format, one change per line, '#' starts a comment:
+//
+//     # seconds  control  value
+//     0          range    mid
+//     0          knob1    0.25
+//     2.5        knob2    0.75
+//     3          reset
+//
+// Controls mirror the Versio panel as PulsarVersio.cpp reads it:
+//   knob0          V/Oct input in calibrated volts (0 to 5)
+//   knob1..knob6   knobs, 0 to 1 (see ApplyPanel for their meaning)
+//   mask           top switch: left|center|right or off|burst|stochastic
+//   range          bottom switch: left|center|right or low|mid|high
+//   reset          gate input, no value
+//   tap            button: press|release or 1|0; a press resets as the
+//                  gate does
+// Lines may come in any order; changes at the same time apply in file
+// order.
+
+// Panel control addressed by an automation line or sweep
+struct ControlId {
+    enum class Kind {
+        KNOB = 0,
+        MASK_SWITCH,
+        RANGE_SWITCH,
+        RESET,
+        TAP
+    };
+
+    Kind kind = Kind::KNOB;
+    int knob = 0;  // For KNOB
+
+    bool operator==(const ControlId& other) const {
+        return kind == other.kind && (kind != Kind::KNOB || knob == other.knob);
+    }
+};
+
+struct AutomationEvent {
+    double time;
+    ControlId control;
+    float value;  // Knob value, switch position as 0, 1, 2, or tap 1 when pressed
+};
+
+struct Automation {
+    std::vector<AutomationEvent> events;  // Sorted by time
+
+    // Time of the last event, 0 if there are none
+    double Length() const { return events.empty() ? 0.0 : events.back().time; }
+};
+
+// Parse a control name ("knob3", "mask", ...)
+bool ParseControl(const std::string& name, ControlId& control);
+
+// Parse a value for control: a number, or a switch position name
+bool ParseControlValue(const ControlId& control, const std::string& text, float& value);
+
+// Printable control name, as accepted by ParseControl
+std::string ControlName(const ControlId& control);
+
+// Set one control on the panel; RESET and a TAP press bump
+// params.resetCount instead
+void ApplyControl(const ControlId& control, float value, PanelState& panel,
+                  PulsarParams& params);
+
+// Load and sort an automation file. On failure error names the file
+// and line.
+bool LoadAutomation(const std::string& path, Automation& automation, std::string& error);
+
+#endif // AUTOMATION_HPP
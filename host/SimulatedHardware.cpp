@@ -0,0 +1,191 @@
+#include "SimulatedHardware.hpp"
+#include "PulsarFirmware.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+void SimulatedHardware::Init(float sampleRate) {
+    sampleRate_ = sampleRate;
+    timeNs_ = 0;
+    nextEvent_ = 0;
+    panel_ = PanelState();
+    gateUntil_ = 0;
+    tapDown_ = false;
+    tapState_ = false;
+    prevTapState_ = false;
+    ledUpdates_ = 0;
+}
+
+void SimulatedHardware::SetAutomation(const Automation& automation) {
+    automation_ = &automation;
+    nextEvent_ = 0;
+}
+
+void SimulatedHardware::SetCvModel(float offset, float unitsPerVolt, float bow) {
+    cvOffset_ = offset;
+    cvUnitsPerVolt_ = unitsPerVolt;
+    cvBow_ = bow;
+}
+
+void SimulatedHardware::Advance(uint64_t ns) {
+    timeNs_ += ns;
+    if (automation_ == nullptr) {
+        return;
+    }
+    const std::vector<AutomationEvent>& events = automation_->events;
+    while (nextEvent_ < events.size() &&
+           static_cast<uint64_t>(events[nextEvent_].time * 1e9) <= timeNs_) {
+        Apply(events[nextEvent_++]);
+    }
+}
+
+void SimulatedHardware::Apply(const AutomationEvent& event) {
+    switch (event.control.kind) {
+        case ControlId::Kind::KNOB:
+            panel_.knobs[event.control.knob] = event.value;
+            break;
+        case ControlId::Kind::MASK_SWITCH:
+            panel_.maskSwitch = static_cast<SwitchPosition>(static_cast<int>(event.value));
+            break;
+        case ControlId::Kind::RANGE_SWITCH:
+            panel_.rangeSwitch = static_cast<SwitchPosition>(static_cast<int>(event.value));
+            break;
+        case ControlId::Kind::RESET:
+            gateUntil_ = timeNs_ + GATE_PULSE_NS;
+            break;
+        case ControlId::Kind::TAP:
+            tapDown_ = event.value > 0.5f;
+            break;
+    }
+}
+
+float SimulatedHardware::CvCode(float volts) const {
+    float bow = cvBow_ * volts * (5.0f - volts) / 6.25f;
+    float raw = std::round(cvOffset_ - volts * cvUnitsPerVolt_ + bow);
+    return std::fmin(std::fmax(raw, 0.0f), 65535.0f);
+}
+
+void SimulatedHardware::DebounceTap() {
+    prevTapState_ = tapState_;
+    tapState_ = tapDown_;
+    if (tapState_ && !prevTapState_) {
+        tapPressedAt_ = timeNs_;
+    }
+}
+
+float SimulatedHardware::TapHeldMs() const {
+    return tapState_ ? static_cast<float>(timeNs_ - tapPressedAt_) * 1e-6f : 0.0f;
+}
+
+void SimulatedHardware::SetLed(int led, float r, float g, float b) {
+    pendingLeds_[led][0] = r;
+    pendingLeds_[led][1] = g;
+    pendingLeds_[led][2] = b;
+}
+
+void SimulatedHardware::UpdateLeds() {
+    for (int led = 0; led < NUM_LEDS; ++led) {
+        for (int c = 0; c < 3; ++c) {
+            leds_[led][c] = pendingLeds_[led][c];
+        }
+    }
+    ledUpdates_++;
+}
+
+void SimulatedHardware::InitSettings(const Settings& defaults) {
+    defaults_ = defaults;
+    if (!stored_) {
+        settings_ = defaults;
+    }
+}
+
+void SimulatedHardware::SaveSettings() {
+    stored_ = true;
+    saves_++;
+}
+
+void Simulate(PulsarFirmware<SimulatedHardware>& firmware, SimulatedHardware& hardware,
+              const SimulationOptions& options, SimulationReport& report,
+              std::vector<float>* output) {
+    const size_t size = options.blockSize;
+    const double blockNs = static_cast<double>(size) * 1e9 / hardware.AudioSampleRate();
+    const uint64_t blockCount = static_cast<uint64_t>(
+        options.duration * hardware.AudioSampleRate() / static_cast<double>(size));
+
+    std::vector<float> inputs(2 * size, 0.0f);
+    std::vector<float> outputs(2 * size, 0.0f);
+    const float* in[2] = {inputs.data(), inputs.data() + size};
+    float* out[2] = {outputs.data(), outputs.data() + size};
+    if (output != nullptr) {
+        output->assign(2 * size * blockCount, 0.0f);
+    }
+
+    HostClock clock;
+    const uint64_t start = hardware.GetTimeNs();
+    const auto wallStart = std::chrono::steady_clock::now();
+    double syncPhase = 0.0;
+    const double syncIncrement = options.syncFrequency / hardware.AudioSampleRate();
+    double ringPhase = 0.0;
+    const double ringIncrement = options.ringFrequency / hardware.AudioSampleRate();
+
+    report = SimulationReport();
+    while (report.blocks < blockCount) {
+        if (options.realtime) {
+            // Virtual time never runs ahead of the wall clock, and
+            // catches up when a sleep or the host overshoots
+            std::this_thread::sleep_until(
+                wallStart + std::chrono::nanoseconds(hardware.GetTimeNs() - start));
+            uint64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - wallStart).count();
+            if (start + wall > hardware.GetTimeNs()) {
+                hardware.Advance(start + wall - hardware.GetTimeNs());
+            }
+        }
+
+        const double due = static_cast<double>(start) + report.blocks * blockNs;
+        if (static_cast<double>(hardware.GetTimeNs()) >= due) {
+            if (static_cast<double>(hardware.GetTimeNs()) > due + blockNs) {
+                report.lateBlocks++;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                inputs[i] = static_cast<float>(std::sin(2.0 * M_PI * syncPhase));
+                syncPhase += syncIncrement;
+                syncPhase -= std::floor(syncPhase);
+                inputs[size + i] = static_cast<float>(std::sin(2.0 * M_PI * ringPhase));
+                ringPhase += ringIncrement;
+                ringPhase -= std::floor(ringPhase);
+            }
+
+            uint32_t begin = clock.Now();
+            firmware.ProcessAudio(in, out, size);
+            uint32_t elapsed = clock.Now() - begin;
+
+            if (output != nullptr) {
+                float* frames = output->data() + 2 * size * report.blocks;
+                for (size_t i = 0; i < size; ++i) {
+                    frames[2 * i] = out[0][i];
+                    frames[2 * i + 1] = out[1][i];
+                }
+            }
+            report.blocks++;
+            hardware.Advance(elapsed);
+        } else {
+            uint32_t ticks = firmware.GetControlTicks();
+            uint32_t begin = clock.Now();
+            firmware.Poll();
+            uint32_t elapsed = clock.Now() - begin;
+
+            if (firmware.GetControlTicks() != ticks) {
+                report.controlPasses++;
+                report.controlNs += elapsed;
+                report.maxControlNs = (elapsed > report.maxControlNs) ? elapsed
+                                                                      : report.maxControlNs;
+            }
+            hardware.Advance((elapsed > options.pollNs) ? elapsed : options.pollNs);
+        }
+    }
+
+    report.wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
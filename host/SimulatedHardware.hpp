@@ -0,0 +1,168 @@
+#pragma once
+#ifndef SIMULATED_HARDWARE_HPP
+#define SIMULATED_HARDWARE_HPP
+
+#include "Automation.hpp"
+#include "LoadMonitor.hpp"
+#include "PulsarControls.hpp"
+#include "Settings.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename Hardware>
+class PulsarFirmware;
+
+// A Versio in software, as the Hardware of PulsarFirmware (see
+// PulsarFirmware.hpp), so the firmware runs unchanged on the host.
+//
+// Time is virtual, in nanoseconds, and only moves when Advance is
+// called (or the firmware calls DelayMs); the owner decides how long
+// each callback and main loop pass takes. The panel follows an
+// Automation script as time passes: knob0 is the V/Oct input in volts,
+// read back through a model of the CV ADC, a reset pulses the gate
+// input and tap presses and releases the button. Settings are kept in
+// memory and the LEDs as last updated.
+//
+// The load monitor times the firmware's callback with HostClock, in
+// real nanoseconds, against a budget from the virtual clock rate, so
+// its deadline misses are those of the host running the callback.
+class SimulatedHardware {
+public:
+    typedef HostClock Clock;
+
+    static constexpr uint32_t CLOCK_RATE = 1000000000u;
+
+    // How long a reset event holds the gate high, so a control tick
+    // sees it
+    static constexpr uint64_t GATE_PULSE_NS = 5000000u;
+
+    void Init(float sampleRate);
+
+    // Play automation from time zero; events already passed are applied
+    // at the next Advance
+    void SetAutomation(const Automation& automation);
+
+    // Raw reading of the CV ADC at 0 V and its fall per volt, and how
+    // far it bows above that line at 2.5 V (a parabola, meeting the
+    // line again at 0 V and 5 V)
+    void SetCvModel(float offset, float unitsPerVolt, float bow = 0.0f);
+
+    // Raw reading at volts under the model, 16-bit whole units
+    float CvCode(float volts) const;
+
+    uint64_t GetTimeNs() const { return timeNs_; }
+
+    // Move time on by ns, applying the script's events up to then
+    void Advance(uint64_t ns);
+
+    // Number of SaveSettings calls; settings survive Init, as in flash
+    int GetSaveCount() const { return saves_; }
+
+    // LED components as of the last UpdateLeds
+    const float* GetLed(int led) const { return leds_[led]; }
+    int GetLedUpdates() const { return ledUpdates_; }
+
+    // Hardware interface
+    float AudioSampleRate() const { return sampleRate_; }
+    uint32_t ClockRate() const { return CLOCK_RATE; }
+    uint32_t Now() const { return static_cast<uint32_t>(timeNs_); }
+    uint32_t Millis() const { return static_cast<uint32_t>(timeNs_ / 1000000u); }
+    void DelayMs(uint32_t ms) { Advance(static_cast<uint64_t>(ms) * 1000000u); }
+
+    void ProcessControls() { DebounceTap(); }
+    float KnobValue(int k) const { return panel_.knobs[k]; }
+    float CvRaw() const { return CvCode(panel_.knobs[0]); }
+    SwitchPosition ReadSwitch(int index) const {
+        return index == 0 ? panel_.maskSwitch : panel_.rangeSwitch;
+    }
+    bool Gate() const { return timeNs_ < gateUntil_; }
+
+    void DebounceTap();
+    bool TapRisingEdge() const { return tapState_ && !prevTapState_; }
+    bool TapFallingEdge() const { return !tapState_ && prevTapState_; }
+    bool TapPressed() const { return tapState_; }
+    bool TapRaw() const { return tapDown_; }
+    float TapHeldMs() const;
+
+    void SetLed(int led, float r, float g, float b);
+    void UpdateLeds();
+
+    void InitSettings(const Settings& defaults);
+    Settings& GetSettings() { return settings_; }
+    void SaveSettings();
+    void RestoreDefaultSettings() { settings_ = defaults_; }
+
+private:
+    static constexpr int NUM_LEDS = 4;
+
+    void Apply(const AutomationEvent& event);
+
+    float sampleRate_ = 96000.0f;
+    uint64_t timeNs_ = 0;
+
+    const Automation* automation_ = nullptr;
+    size_t nextEvent_ = 0;
+
+    // knobs[0] is the V/Oct input in volts
+    PanelState panel_;
+    float cvOffset_ = 64262.0f;
+    float cvUnitsPerVolt_ = 12826.0f;
+    float cvBow_ = 0.0f;
+    uint64_t gateUntil_ = 0;
+
+    bool tapDown_ = false;
+    bool tapState_ = false;
+    bool prevTapState_ = false;
+    uint64_t tapPressedAt_ = 0;
+
+    float pendingLeds_[NUM_LEDS][3] = {};
+    float leds_[NUM_LEDS][3] = {};
+    int ledUpdates_ = 0;
+
+    Settings defaults_ = {};
+    Settings settings_ = {};
+    bool stored_ = false;
+    int saves_ = 0;
+};
+
+// How Simulate drives the firmware
+struct SimulationOptions {
+    size_t blockSize = 48;
+    double duration = 1.0;  // Seconds of audio
+    // Pace the run to the wall clock rather than running flat out
+    bool realtime = false;
+    // Sine on the sync input (IN_L), 0 for none
+    float syncFrequency = 0.0f;
+
+    // Sine on IN_R, which captures read, 0 for none
+    float ringFrequency = 0.0f;
+    // Least virtual time a main loop pass takes
+    uint64_t pollNs = 1000;
+};
+
+// What happened during Simulate; the load monitor has the callback
+// timing and deadline misses
+struct SimulationReport {
+    uint32_t blocks = 0;
+    // Realtime runs: blocks that started more than a block late, so
+    // the output would have run dry
+    uint32_t lateBlocks = 0;
+    uint32_t controlPasses = 0;  // Main loop passes that ran the control task
+    uint64_t controlNs = 0;      // Their total and longest real time
+    uint64_t maxControlNs = 0;
+    double wallSeconds = 0.0;
+};
+
+// Run an initialized firmware for options.duration from the hardware's
+// current time, as the module would: an audio callback every blockSize
+// samples and main loop passes in between. Each step advances virtual
+// time by as long as it really took, so a slow callback delays the
+// control loop as it does on the module. Output, when given, receives
+// the interleaved stereo output.
+void Simulate(PulsarFirmware<SimulatedHardware>& firmware, SimulatedHardware& hardware,
+              const SimulationOptions& options, SimulationReport& report,
+              std::vector<float>* output = nullptr);
+
+#endif // SIMULATED_HARDWARE_HPP
@@ -0,0 +1,90 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads)
+    : queues_(threads > 0 ? threads
+                          : (std::thread::hardware_concurrency() > 0
+                                 ? std::thread::hardware_concurrency() : 1)),
+      nextQueue_(0),
+      pending_(0),
+      queued_(0),
+      stopping_(false) {
+    workers_.reserve(queues_.size());
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    Queue& queue = queues_[nextQueue_.fetch_add(1) % queues_.size()];
+    {
+        // Count before the task is visible, so a worker that takes it
+        // straight away never decrements below zero
+        std::lock_guard<std::mutex> state(stateMutex_);
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        ++pending_;
+        ++queued_;
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    allDone_.wait(lock, [this] { return pending_ == 0; });
+}
+
+bool ThreadPool::TakeTask(size_t self, Task& task) {
+    const size_t count = queues_.size();
+    for (size_t i = 0; i < count; ++i) {
+        Queue& queue = queues_[(self + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        // Newest from our own queue, oldest from a victim's
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t self) {
+    for (;;) {
+        Task task;
+        if (TakeTask(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex_);
+                --queued_;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            if (--pending_ == 0) {
+                allDone_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex_);
+        workAvailable_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for coarse host jobs (whole renders).
+//
+// Each worker owns a deque. Submit deals tasks round-robin onto the
+// deques; a worker takes from the back of its own and, when that is
+// empty, steals from the front of the others, so a worker that drew
+// short jobs keeps busy with the leftovers of one that drew long ones.
+// Tasks may submit further tasks.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads = 0 uses every hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const { return workers_.size(); }
+
+    void Submit(Task task);
+
+    // Block until every submitted task has finished
+    void Wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(size_t self);
+    bool TakeTask(size_t self, Task& task);
+
+    std::vector<std::thread> workers_;
+    std::vector<Queue> queues_;
+    std::atomic<size_t> nextQueue_;
+
+    // Submitted but not finished, and whether tasks may be waiting in
+    // a queue; both guarded by stateMutex_ for the sleeps
+    std::mutex stateMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+    size_t pending_;
+    size_t queued_;
+    bool stopping_;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,260 @@
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void PutU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void PutTag(std::vector<uint8_t>& out, const char* tag) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+int32_t Quantize(float sample, float scale, int32_t max) {
+    float clipped = std::fmax(-1.0f, std::fmin(1.0f, sample));
+    int32_t value = static_cast<int32_t>(std::lrint(clipped * scale));
+    return (value > max) ? max : value;
+}
+
+uint16_t GetU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool LittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+}  // namespace
+
+bool ParseWavFormat(const char* name, WavFormat& format) {
+    if (!std::strcmp(name, "s16")) {
+        format = WavFormat::PCM16;
+    } else if (!std::strcmp(name, "s24")) {
+        format = WavFormat::PCM24;
+    } else if (!std::strcmp(name, "f32")) {
+        format = WavFormat::FLOAT32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool WriteWav(const std::string& path, const float* interleaved, size_t frames,
+              int channels, int sampleRate, WavFormat format, std::string& error) {
+    const uint16_t bytesPerSample =
+        (format == WavFormat::PCM16) ? 2 : ((format == WavFormat::PCM24) ? 3 : 4);
+    const uint16_t formatTag = (format == WavFormat::FLOAT32) ? 3 : 1;
+    const size_t samples = frames * static_cast<size_t>(channels);
+    const uint64_t dataBytes = static_cast<uint64_t>(samples) * bytesPerSample;
+    if (dataBytes > 0xFFFFFFFFull - 64) {
+        error = path + ": too long for a WAV file";
+        return false;
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(64 + static_cast<size_t>(dataBytes));
+
+    // Float data needs the fact chunk
+    const bool fact = (format == WavFormat::FLOAT32);
+    const uint32_t headerBytes = 4 + (8 + 16) + (fact ? 12 : 0) + 8;
+
+    PutTag(bytes, "RIFF");
+    PutU32(bytes, headerBytes + static_cast<uint32_t>(dataBytes));
+    PutTag(bytes, "WAVE");
+
+    PutTag(bytes, "fmt ");
+    PutU32(bytes, 16);
+    PutU16(bytes, formatTag);
+    PutU16(bytes, static_cast<uint16_t>(channels));
+    PutU32(bytes, static_cast<uint32_t>(sampleRate));
+    PutU32(bytes, static_cast<uint32_t>(sampleRate) * channels * bytesPerSample);
+    PutU16(bytes, static_cast<uint16_t>(channels * bytesPerSample));
+    PutU16(bytes, static_cast<uint16_t>(8 * bytesPerSample));
+
+    if (fact) {
+        PutTag(bytes, "fact");
+        PutU32(bytes, 4);
+        PutU32(bytes, static_cast<uint32_t>(frames));
+    }
+
+    PutTag(bytes, "data");
+    PutU32(bytes, static_cast<uint32_t>(dataBytes));
+
+    for (size_t i = 0; i < samples; ++i) {
+        float sample = interleaved[i];
+        switch (format) {
+            case WavFormat::PCM16: {
+                int32_t v = Quantize(sample, 32768.0f, 32767);
+                PutU16(bytes, static_cast<uint16_t>(v));
+                break;
+            }
+            case WavFormat::PCM24: {
+                int32_t v = Quantize(sample, 8388608.0f, 8388607);
+                bytes.push_back(static_cast<uint8_t>(v));
+                bytes.push_back(static_cast<uint8_t>(v >> 8));
+                bytes.push_back(static_cast<uint8_t>(v >> 16));
+                break;
+            }
+            case WavFormat::FLOAT32: {
+                uint32_t bits;
+                std::memcpy(&bits, &sample, sizeof(bits));
+                PutU32(bytes, bits);
+                break;
+            }
+        }
+    }
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        error = "cannot write " + path;
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        error = "error writing " + path;
+    }
+    return ok;
+}
+
+bool MappedWav::Open(const std::string& path, std::string& error) {
+    Close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot read " + path;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 12) {
+        ::close(fd);
+        error = path + ": not a WAV file";
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                           MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    mapping_ = mapping;
+    mappingSize_ = static_cast<size_t>(st.st_size);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping_);
+    const size_t size = mappingSize_;
+    if (std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+        Close();
+        error = path + ": not a WAV file";
+        return false;
+    }
+
+    // Walk the chunks for fmt and data; chunks are padded to even sizes
+    uint16_t formatTag = 0;
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    const uint8_t* data = nullptr;
+    size_t dataBytes = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = bytes + pos;
+        size_t chunkBytes = GetU32(chunk + 4);
+        size_t body = pos + 8;
+        size_t available = std::min(chunkBytes, size - body);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            formatTag = GetU16(chunk + 8);
+            channels = GetU16(chunk + 10);
+            sampleRate_ = static_cast<int>(GetU32(chunk + 12));
+            bits = GetU16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real tag in its subformat
+            if (formatTag == 0xFFFE && available >= 26) {
+                formatTag = GetU16(chunk + 32);
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            dataBytes = available;
+        }
+        pos = body + chunkBytes + (chunkBytes & 1);
+    }
+
+    const bool isFloat = (formatTag == 3 && bits == 32);
+    const bool isPcm = (formatTag == 1 && (bits == 16 || bits == 24));
+    if (data == nullptr || channels == 0 || (!isFloat && !isPcm)) {
+        Close();
+        error = path + ": needs PCM16, PCM24 or float32 data";
+        return false;
+    }
+
+    const size_t bytesPerSample = bits / 8;
+    const size_t frameBytes = bytesPerSample * channels;
+    length_ = dataBytes / frameBytes;
+    const bool aligned = (reinterpret_cast<uintptr_t>(data) % alignof(float)) == 0;
+    if (isFloat && channels == 1 && aligned && LittleEndian()) {
+        samples_ = reinterpret_cast<const float*>(data);
+        return true;
+    }
+
+    converted_.resize(length_);
+    for (size_t i = 0; i < length_; ++i) {
+        const uint8_t* p = data + i * frameBytes;
+        float sample;
+        if (isFloat) {
+            uint32_t v = GetU32(p);
+            std::memcpy(&sample, &v, sizeof(sample));
+        } else if (bits == 16) {
+            sample = static_cast<int16_t>(GetU16(p)) / 32768.0f;
+        } else {
+            // Sign-extend from the top of a 32-bit word
+            int32_t v = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                             (static_cast<uint32_t>(p[1]) << 16) |
+                                             (static_cast<uint32_t>(p[2]) << 24));
+            sample = static_cast<float>(v >> 8) / 8388608.0f;
+        }
+        converted_[i] = sample;
+    }
+    samples_ = converted_.data();
+
+    // Nothing left to read from the file
+    ::munmap(mapping_, mappingSize_);
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    return true;
+}
+
+void MappedWav::Close() {
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mappingSize_);
+    }
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    samples_ = nullptr;
+    length_ = 0;
+    sampleRate_ = 0;
+    converted_.clear();
+}
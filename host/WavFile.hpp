@@ -0,0 +1,60 @@
+#pragma once
+#ifndef WAV_FILE_HPP
+#define WAV_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Sample encodings for WriteWav
+enum class WavFormat {
+    PCM16 = 0,
+    PCM24,
+    FLOAT32
+};
+
+// Parse "s16", "s24" or "f32"; returns false for anything else
+bool ParseWavFormat(const char* name, WavFormat& format);
+
+// Write interleaved float frames (nominally -1.0 to 1.0) as a RIFF/WAVE
+// file. PCM formats are clipped and rounded. Returns false and fills
+// error if the file cannot be written.
+bool WriteWav(const std::string& path, const float* interleaved, size_t frames,
+              int channels, int sampleRate, WavFormat format, std::string& error);
+
+// Read-only view of a WAV file's first channel as float samples.
+//
+// The file is memory-mapped. Mono 32-bit float data is used where it
+// lies in the mapping, without a copy; PCM16, PCM24 and multichannel
+// files have their first channel converted into an owned buffer.
+class MappedWav {
+public:
+    MappedWav() = default;
+    ~MappedWav() { Close(); }
+    MappedWav(const MappedWav&) = delete;
+    MappedWav& operator=(const MappedWav&) = delete;
+
+    // Map path; returns false and fills error if it cannot be read as
+    // a PCM16, PCM24 or float32 WAV file
+    bool Open(const std::string& path, std::string& error);
+
+    // Unmap the file; the samples are no longer valid
+    void Close();
+
+    const float* GetSamples() const { return samples_; }
+    size_t GetLength() const { return length_; }
+    int GetSampleRate() const { return sampleRate_; }
+
+    // True when the samples are read in place from the mapping
+    bool IsInPlace() const { return samples_ != nullptr && converted_.empty(); }
+
+private:
+    void* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+    const float* samples_ = nullptr;
+    size_t length_ = 0;
+    int sampleRate_ = 0;
+    std::vector<float> converted_;
+};
+
+#endif // WAV_FILE_HPP
@@ -0,0 +1,714 @@
+/**
+ * Host benchmark for PulsarEngine
+ *
+ * Renders a grid of engine settings through ProcessBlock and reports
+ * ns/sample, samples/second and the share of the Versio's 96 kHz
+ * real-time budget, aggregated per parameter axis.
+ */
+
+#include "Convolver.hpp"
+#include "PulsarBank.hpp"
+#include "PulsarCloud.hpp"
+#include "PulsarControls.hpp"
+#include "PulsarEngine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr float SAMPLE_RATE = 96000.0f;
+constexpr double BUDGET_NS_PER_SAMPLE = 1.0e9 / SAMPLE_RATE;
+
+struct Range {
+    const char* name;
+    float baseFreq;
+};
+
+const Range RANGES[] = {
+    {"low", BASE_FREQ_LOW},
+    {"mid", BASE_FREQ_MID},
+    {"high", BASE_FREQ_HIGH},
+};
+
+const char* MASKING_NAMES[] = {"off", "burst", "stochastic"};
+const char* EDGE_NAMES[] = {"smoothed", "bandlimited"};
+
+// Fold axis value: off, or oversampling factor plus mode
+std::string FoldName(int fold, FoldMode mode) {
+    if (fold == 0) {
+        return "off";
+    }
+    return std::to_string(fold) + (mode == FoldMode::ADAA ? "x-adaa" : "x");
+}
+
+struct Options {
+    size_t samples = 4096;
+    size_t blockSize = 48;
+    int repeats = 3;
+    bool quick = false;
+    bool runGrid = true;
+    bool runBank = true;
+    bool runCloud = true;
+    bool runConvolution = true;
+    bool runFormant = true;
+    bool runModulation = true;
+    const char* csvPath = nullptr;
+};
+
+struct Config {
+    int range;
+    float octave;
+    float formantRatio;
+    float waveformMorph;
+    float envelopeMorph;
+    int fold;  // 0 = off, otherwise the fold oversampling factor
+    FoldMode foldMode;
+    MaskingMode masking;
+    ShapeLookup lookup;
+    EdgeMode edges;
+};
+
+struct Result {
+    Config config;
+    double nsPerSample;
+};
+
+// Running statistics for one value of one axis
+struct AxisStats {
+    std::string axis;
+    std::string value;
+    double sum = 0.0;
+    double worst = 0.0;
+    size_t count = 0;
+};
+
+class AxisTable {
+public:
+    void Add(const std::string& axis, const std::string& value, double ns) {
+        AxisStats* stats = nullptr;
+        for (auto& s : stats_) {
+            if (s.axis == axis && s.value == value) {
+                stats = &s;
+                break;
+            }
+        }
+        if (stats == nullptr) {
+            stats_.push_back(AxisStats{axis, value});
+            stats = &stats_.back();
+        }
+        stats->sum += ns;
+        stats->worst = std::max(stats->worst, ns);
+        stats->count++;
+    }
+
+    void Print() const {
+        std::printf("%-10s %-12s %10s %10s %12s %8s %8s\n",
+                    "axis", "value", "ns/sample", "worst", "Msamples/s",
+                    "%RT", "%RT max");
+        // Axes in first-seen order, values grouped under each axis
+        std::vector<std::string> axes;
+        for (const auto& s : stats_) {
+            if (std::find(axes.begin(), axes.end(), s.axis) == axes.end()) {
+                axes.push_back(s.axis);
+            }
+        }
+        for (size_t a = 0; a < axes.size(); ++a) {
+            if (a > 0) {
+                std::printf("\n");
+            }
+            for (const auto& s : stats_) {
+                if (s.axis == axes[a]) {
+                    PrintRow(s);
+                }
+            }
+        }
+    }
+
+private:
+    static void PrintRow(const AxisStats& s) {
+        double mean = s.sum / static_cast<double>(s.count);
+        std::printf("%-10s %-12s %10.2f %10.2f %12.2f %7.3f%% %7.3f%%\n",
+                    s.axis.c_str(), s.value.c_str(), mean, s.worst,
+                    1.0e3 / mean,
+                    100.0 * mean / BUDGET_NS_PER_SAMPLE,
+                    100.0 * s.worst / BUDGET_NS_PER_SAMPLE);
+    }
+
+    std::vector<AxisStats> stats_;
+};
+
+std::string Format(float value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(value));
+    return buf;
+}
+
+void ApplyConfig(PulsarEngine& engine, const Config& c) {
+    engine.Init(SAMPLE_RATE);
+    engine.SetShapeLookup(c.lookup);
+    engine.SetEdgeMode(c.edges);
+    engine.SetFrequency(RANGES[c.range].baseFreq * std::exp2(c.octave));
+    engine.SetFormantRatio(c.formantRatio);
+    engine.SetWaveformMorph(c.waveformMorph);
+    engine.SetEnvelopeMorph(c.envelopeMorph);
+    engine.SetFold(c.fold > 0 ? 0.6f : 0.0f);
+    engine.SetFoldOversampling(c.fold > 0 ? c.fold : 1);
+    engine.SetFoldMode(c.foldMode);
+    engine.SetMaskingMode(c.masking);
+    engine.SetBurstRatio(3, 2);
+    engine.SetMaskingProbability(0.5f);
+}
+
+// Returns ns/sample for one configuration, best of options.repeats runs
+double Measure(const Config& config, const Options& options,
+               std::vector<float>& buffer, double& checksum) {
+    double best = 0.0;
+    for (int run = 0; run < options.repeats; ++run) {
+        PulsarEngine engine;
+        ApplyConfig(engine, config);
+
+        // Warm up caches and branch predictors on one block
+        engine.ProcessBlock(buffer.data(), options.blockSize);
+
+        auto start = std::chrono::steady_clock::now();
+        size_t remaining = options.samples;
+        while (remaining > 0) {
+            size_t n = std::min(remaining, options.blockSize);
+            engine.ProcessBlock(buffer.data(), n);
+            remaining -= n;
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        // Keep the render from being optimized away
+        checksum += buffer[0];
+
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        if (run == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best / static_cast<double>(options.samples);
+}
+
+std::vector<Config> BuildGrid(const Options& options) {
+    const float morphStep = options.quick ? 1.0f : 0.5f;
+    const float octaves[] = {0.0f, 5.0f};
+    const float formantRatios[] = {0.05f, 0.3f, 1.0f};
+    const MaskingMode maskings[] = {
+        MaskingMode::OFF, MaskingMode::BURST, MaskingMode::STOCHASTIC};
+    const ShapeLookup lookups[] = {ShapeLookup::TABLE, ShapeLookup::COMPUTED};
+    const EdgeMode edgeModes[] = {EdgeMode::SMOOTHED, EdgeMode::BAND_LIMITED};
+    struct FoldSetting {
+        int factor;
+        FoldMode mode;
+    };
+    const FoldSetting folds[] = {
+        {0, FoldMode::DIRECT}, {1, FoldMode::DIRECT}, {1, FoldMode::ADAA},
+        {2, FoldMode::DIRECT}, {2, FoldMode::ADAA}, {4, FoldMode::DIRECT}};
+
+    std::vector<Config> grid;
+    for (int range = 0; range < 3; ++range)
+    for (float octave : octaves)
+    for (float ratio : formantRatios)
+    for (float wave = 0.0f; wave <= 6.0f; wave += morphStep)
+    for (float env = 0.0f; env <= 6.0f; env += morphStep)
+    for (const FoldSetting& fold : folds)
+    for (MaskingMode masking : maskings)
+    for (ShapeLookup lookup : lookups)
+    for (EdgeMode edges : edgeModes) {
+        grid.push_back(Config{range, octave, ratio, wave, env, fold.factor,
+                              fold.mode, masking, lookup, edges});
+    }
+    return grid;
+}
+
+// Configure voice v of a bank and its scalar twin identically
+void SetupVoice(PulsarBank& bank, PulsarEngine& engine, size_t v) {
+    float freq = BASE_FREQ_MID * std::exp2(0.37f * static_cast<float>(v % 13));
+    float ratio = 0.1f + 0.05f * static_cast<float>(v % 17);
+    float wave = 0.25f * static_cast<float>(v % 25);
+    float env = 0.5f * static_cast<float>(v % 13);
+
+    bank.SetFrequency(v, freq);
+    bank.SetFormantRatio(v, ratio);
+    bank.SetWaveformMorph(v, wave);
+    bank.SetEnvelopeMorph(v, env);
+    bank.SetAmplitude(v, 0.1f);
+
+    engine.Init(SAMPLE_RATE);
+    engine.SetFrequency(freq);
+    engine.SetFormantRatio(ratio);
+    engine.SetWaveformMorph(wave);
+    engine.SetEnvelopeMorph(env);
+    engine.SetAmplitude(0.1f);
+}
+
+// PulsarBank voice-count scaling against the same voices rendered by
+// separate scalar engines
+void RunBankSuite(const Options& options) {
+    const size_t voiceCounts[] = {1, 4, 8, 16, 32};
+    std::vector<float> buffer(options.blockSize);
+    std::vector<float> scratch(options.blockSize);
+    double checksum = 0.0;
+
+    std::printf("\nPulsarBank scaling (%s backend, %zu lanes)\n",
+                simd::BACKEND, simd::WIDTH);
+    std::printf("%-8s %12s %14s %14s %10s %8s\n", "voices", "ns/sample",
+                "ns/voice-smp", "scalar ns/smp", "speedup", "%RT");
+
+    for (size_t voices : voiceCounts) {
+        double bankBest = 0.0;
+        double scalarBest = 0.0;
+        for (int run = 0; run < options.repeats; ++run) {
+            PulsarBank bank;
+            bank.Init(SAMPLE_RATE, voices);
+            std::vector<PulsarEngine> engines(voices);
+            for (size_t v = 0; v < voices; ++v) {
+                SetupVoice(bank, engines[v], v);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                bank.Process(buffer.data(), options.blockSize);
+            }
+            auto mid = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                for (auto& engine : engines) {
+                    engine.ProcessBlock(scratch.data(), options.blockSize);
+                }
+            }
+            auto stop = std::chrono::steady_clock::now();
+            checksum += buffer[0] + scratch[0];
+
+            double bankNs = std::chrono::duration<double, std::nano>(mid - start).count();
+            double scalarNs = std::chrono::duration<double, std::nano>(stop - mid).count();
+            if (run == 0 || bankNs < bankBest) bankBest = bankNs;
+            if (run == 0 || scalarNs < scalarBest) scalarBest = scalarNs;
+        }
+
+        double perSample = bankBest / static_cast<double>(options.samples);
+        double scalarPerSample = scalarBest / static_cast<double>(options.samples);
+        std::printf("%-8zu %12.2f %14.2f %14.2f %9.2fx %7.3f%%\n", voices,
+                    perSample, perSample / static_cast<double>(voices),
+                    scalarPerSample, scalarPerSample / perSample,
+                    100.0 * perSample / BUDGET_NS_PER_SAMPLE);
+    }
+    std::printf("(checksum %g)\n", checksum);
+}
+
+// PulsarCloud cost against the number of overlapping pulsarets, with
+// the pool at full capacity
+void RunCloudSuite(const Options& options) {
+    const size_t overlaps[] = {1, 4, 8, 16, 32};
+    std::vector<float> buffer(options.blockSize);
+    double checksum = 0.0;
+
+    std::printf("\nPulsarCloud overlap (%s backend, %zu lanes, capacity %zu)\n",
+                simd::BACKEND, simd::WIDTH, PulsarCloud::MAX_PULSARETS);
+    std::printf("%-8s %12s %16s %8s\n", "overlap", "ns/sample", "ns/pulsaret-smp", "%RT");
+
+    for (size_t overlap : overlaps) {
+        double best = 0.0;
+        for (int run = 0; run < options.repeats; ++run) {
+            PulsarCloud cloud;
+            cloud.Init(SAMPLE_RATE, PulsarCloud::MAX_PULSARETS);
+            float length = static_cast<float>(overlap) / (BASE_FREQ_MID * 4.0f);
+            cloud.SetFrequency(BASE_FREQ_MID * 4.0f);
+            cloud.SetFormantFrequency(1.0f / length);
+            cloud.SetWaveformMorph(1.5f);
+            cloud.SetAmplitude(0.1f);
+
+            // Untimed until the pool has filled
+            size_t warmup = static_cast<size_t>(length * SAMPLE_RATE);
+            for (size_t done = 0; done < warmup; done += options.blockSize) {
+                cloud.Process(buffer.data(), options.blockSize);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                cloud.Process(buffer.data(), options.blockSize);
+            }
+            auto stop = std::chrono::steady_clock::now();
+            checksum += buffer[0];
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            if (run == 0 || ns < best) best = ns;
+        }
+
+        double perSample = best / static_cast<double>(options.samples);
+        std::printf("%-8zu %12.2f %16.2f %7.3f%%\n", overlap, perSample,
+                    perSample / static_cast<double>(overlap),
+                    100.0 * perSample / BUDGET_NS_PER_SAMPLE);
+    }
+    std::printf("(checksum %g)\n", checksum);
+}
+
+// Convolver cost of a one-second impulse response (and a two-second
+// one at the largest partition) against the partition size, which is
+// also the latency
+void RunConvolutionSuite(const Options& options) {
+    const size_t partitionSizes[] = {64, 128, 256, 512, 1024};
+    const size_t irSamples = static_cast<size_t>(SAMPLE_RATE);
+    std::vector<float> buffer(options.blockSize);
+    double checksum = 0.0;
+
+    std::printf("\nConvolver (%s backend, %zu lanes)\n", simd::BACKEND, simd::WIDTH);
+    std::printf("%-10s %6s %10s %12s %10s %8s\n", "partition", "ir s", "partitions",
+                "ns/sample", "latency ms", "%RT");
+
+    std::vector<float> ir(2 * irSamples);
+    for (size_t i = 0; i < ir.size(); ++i) {
+        ir[i] = std::exp(-3.0f * static_cast<float>(i) / SAMPLE_RATE) *
+                std::sin(0.37f * static_cast<float>(i));
+    }
+
+    for (size_t size : partitionSizes) {
+        for (size_t length : {irSamples, 2 * irSamples}) {
+            if (length > irSamples && size != partitionSizes[4]) {
+                continue;
+            }
+            size_t partitions = (length + size - 1) / size;
+            std::vector<float> memory(Convolver::MemorySize(size, partitions));
+            Convolver convolver;
+            convolver.Init(size, partitions, memory.data(), memory.size());
+            convolver.SetImpulseResponse(ir.data(), length);
+
+            double best = 0.0;
+            for (int run = 0; run < options.repeats; ++run) {
+                convolver.Reset();
+                auto start = std::chrono::steady_clock::now();
+                for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                    std::fill(buffer.begin(), buffer.end(), 0.0f);
+                    buffer[0] = 1.0f;
+                    convolver.Process(buffer.data(), buffer.data(), options.blockSize);
+                }
+                auto stop = std::chrono::steady_clock::now();
+                checksum += buffer[0];
+
+                double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+                if (run == 0 || ns < best) best = ns;
+            }
+
+            double perSample = best / static_cast<double>(options.samples);
+            std::printf("%-10zu %6.1f %10zu %12.2f %10.2f %7.3f%%\n", size,
+                        static_cast<double>(length) / SAMPLE_RATE,
+                        convolver.GetPartitionCount(), perSample,
+                        1000.0 * static_cast<double>(size) / SAMPLE_RATE,
+                        100.0 * perSample / BUDGET_NS_PER_SAMPLE);
+        }
+    }
+    std::printf("(checksum %g)\n", checksum);
+}
+
+// Multi-formant mode against one engine per formant
+void RunFormantSuite(const Options& options) {
+    const float ratios[] = {0.6f, 0.25f, 0.12f, 0.07f};
+    const float waves[] = {0.0f, 1.0f, 0.5f, 4.0f};
+    const float gains[] = {1.0f, 0.6f, 0.4f, 0.3f};
+    std::vector<float> buffer(options.blockSize);
+    double checksum = 0.0;
+
+    std::printf("\nMulti-formant (one shared phase vs. one engine per formant)\n");
+    std::printf("%-9s %12s %16s %10s %8s\n", "formants", "ns/sample",
+                "engines ns/smp", "speedup", "%RT");
+
+    for (int count = 1; count <= PulsarEngine::MAX_FORMANTS; ++count) {
+        double sharedBest = 0.0;
+        double separateBest = 0.0;
+        for (int run = 0; run < options.repeats; ++run) {
+            PulsarEngine shared;
+            shared.Init(SAMPLE_RATE);
+            shared.SetFrequency(BASE_FREQ_MID * 2.0f);
+            shared.SetFormantCount(count);
+            std::vector<PulsarEngine> separate(count);
+            for (int k = 0; k < count; ++k) {
+                shared.SetFormant(k, ratios[k], waves[k], gains[k]);
+                separate[k].Init(SAMPLE_RATE);
+                separate[k].SetFrequency(BASE_FREQ_MID * 2.0f);
+                separate[k].SetFormantRatio(ratios[k]);
+                separate[k].SetWaveformMorph(waves[k]);
+                separate[k].SetAmplitude(gains[k]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                shared.ProcessBlock(buffer.data(), options.blockSize);
+            }
+            auto mid = std::chrono::steady_clock::now();
+            for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                for (auto& engine : separate) {
+                    engine.ProcessBlock(buffer.data(), options.blockSize);
+                }
+            }
+            auto stop = std::chrono::steady_clock::now();
+            checksum += buffer[0];
+
+            double sharedNs = std::chrono::duration<double, std::nano>(mid - start).count();
+            double separateNs = std::chrono::duration<double, std::nano>(stop - mid).count();
+            if (run == 0 || sharedNs < sharedBest) sharedBest = sharedNs;
+            if (run == 0 || separateNs < separateBest) separateBest = separateNs;
+        }
+
+        double perSample = sharedBest / static_cast<double>(options.samples);
+        double separatePerSample = separateBest / static_cast<double>(options.samples);
+        std::printf("%-9d %12.2f %16.2f %9.2fx %7.3f%%\n", count, perSample,
+                    separatePerSample, separatePerSample / perSample,
+                    100.0 * perSample / BUDGET_NS_PER_SAMPLE);
+    }
+    std::printf("(checksum %g)\n", checksum);
+}
+
+// Audio-rate modulation: per-sample setter calls around Process() vs.
+// modulation buffers through ProcessBlock
+void RunModulationSuite(const Options& options) {
+    const char* targets[] = {"pitch", "formant", "waveform", "envelope", "all"};
+    const EdgeMode edgeModes[] = {EdgeMode::SMOOTHED, EdgeMode::BAND_LIMITED};
+    const float baseFreq = BASE_FREQ_MID * 2.0f;
+    const float baseRatio = 0.3f;
+    const float baseWave = 2.5f;
+    const float baseEnv = 1.5f;
+
+    // One 500 Hz modulator, scaled per target
+    std::vector<float> lfo(options.samples);
+    for (size_t i = 0; i < options.samples; ++i) {
+        lfo[i] = std::sin(6.2831853f * 500.0f * static_cast<float>(i) / SAMPLE_RATE);
+    }
+    std::vector<float> pitch(options.samples);
+    std::vector<float> formant(options.samples);
+    std::vector<float> morph(options.samples);
+    for (size_t i = 0; i < options.samples; ++i) {
+        pitch[i] = 0.5f * lfo[i];
+        formant[i] = 0.2f * lfo[i];
+        morph[i] = lfo[i];
+    }
+
+    std::vector<float> buffer(options.blockSize);
+    double checksum = 0.0;
+
+    std::printf("\nAudio-rate modulation (per-sample setters vs. modulation buffers)\n");
+    std::printf("%-9s %-12s %14s %14s %10s %8s\n", "target", "edges",
+                "setters ns/smp", "buffers ns/smp", "speedup", "%RT");
+
+    for (int t = 0; t < 5; ++t) {
+        const bool all = (t == 4);
+        for (EdgeMode edges : edgeModes) {
+            double settersBest = 0.0;
+            double buffersBest = 0.0;
+            for (int run = 0; run < options.repeats; ++run) {
+                PulsarEngine setters;
+                PulsarEngine buffers;
+                for (PulsarEngine* e : {&setters, &buffers}) {
+                    e->Init(SAMPLE_RATE);
+                    e->SetEdgeMode(edges);
+                    e->SetFrequency(baseFreq);
+                    e->SetFormantRatio(baseRatio);
+                    e->SetWaveformMorph(baseWave);
+                    e->SetEnvelopeMorph(baseEnv);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < options.samples; ++i) {
+                    if (t == 0 || all) setters.SetFrequency(baseFreq * std::exp2(pitch[i]));
+                    if (t == 1 || all) setters.SetFormantRatio(baseRatio + formant[i]);
+                    if (t == 2 || all) setters.SetWaveformMorph(baseWave + morph[i]);
+                    if (t == 3 || all) setters.SetEnvelopeMorph(baseEnv + morph[i]);
+                    buffer[i % options.blockSize] = setters.Process();
+                }
+                auto mid = std::chrono::steady_clock::now();
+                for (size_t done = 0; done < options.samples; done += options.blockSize) {
+                    size_t n = std::min(options.blockSize, options.samples - done);
+                    PulsarModulation mod;
+                    if (t == 0 || all) mod.pitch = pitch.data() + done;
+                    if (t == 1 || all) mod.formantRatio = formant.data() + done;
+                    if (t == 2 || all) mod.waveformMorph = morph.data() + done;
+                    if (t == 3 || all) mod.envelopeMorph = morph.data() + done;
+                    buffers.ProcessBlock(mod, buffer.data(), n);
+                }
+                auto stop = std::chrono::steady_clock::now();
+                checksum += buffer[0];
+
+                double settersNs = std::chrono::duration<double, std::nano>(mid - start).count();
+                double buffersNs = std::chrono::duration<double, std::nano>(stop - mid).count();
+                if (run == 0 || settersNs < settersBest) settersBest = settersNs;
+                if (run == 0 || buffersNs < buffersBest) buffersBest = buffersNs;
+            }
+
+            double settersPerSample = settersBest / static_cast<double>(options.samples);
+            double perSample = buffersBest / static_cast<double>(options.samples);
+            std::printf("%-9s %-12s %14.2f %14.2f %9.2fx %7.3f%%\n", targets[t],
+                        EDGE_NAMES[static_cast<int>(edges)], settersPerSample,
+                        perSample, settersPerSample / perSample,
+                        100.0 * perSample / BUDGET_NS_PER_SAMPLE);
+        }
+    }
+    std::printf("(checksum %g)\n", checksum);
+}
+
+void PrintUsage(const char* argv0) {
+    std::printf("usage: %s [--suite grid|bank|cloud|conv|formant|mod] [--samples N] [--block N]"
+                " [--repeat N] [--quick] [--csv FILE]\n"
+                "  --suite S    run only one suite (default: all)\n"
+                "  --samples N  samples rendered per configuration (default 4096)\n"
+                "  --block N    ProcessBlock size (default 48)\n"
+                "  --repeat N   runs per configuration, fastest is kept (default 3)\n"
+                "  --quick      integer morph positions only\n"
+                "  --csv FILE   write every configuration's result to FILE\n",
+                argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--suite") && i + 1 < argc) {
+            const char* suite = argv[++i];
+            options.runGrid = !std::strcmp(suite, "grid");
+            options.runBank = !std::strcmp(suite, "bank");
+            options.runCloud = !std::strcmp(suite, "cloud");
+            options.runConvolution = !std::strcmp(suite, "conv");
+            options.runFormant = !std::strcmp(suite, "formant");
+            options.runModulation = !std::strcmp(suite, "mod");
+            if (!options.runGrid && !options.runBank && !options.runCloud &&
+                !options.runConvolution && !options.runFormant &&
+                !options.runModulation) {
+                PrintUsage(argv[0]);
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "--samples") && i + 1 < argc) {
+            options.samples = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--block") && i + 1 < argc) {
+            options.blockSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            options.repeats = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--quick")) {
+            options.quick = true;
+        } else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc) {
+            options.csvPath = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (options.samples == 0 || options.blockSize == 0 || options.repeats < 1) {
+        PrintUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+void WriteCsv(const char* path, const std::vector<Result>& results) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) {
+        std::fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    std::fprintf(f, "range,octave,formant,waveform,envelope,fold,masking,"
+                    "lookup,edges,ns_per_sample,rt_percent\n");
+    for (const auto& r : results) {
+        const Config& c = r.config;
+        std::fprintf(f, "%s,%g,%g,%g,%g,%s,%s,%s,%s,%.3f,%.4f\n",
+                     RANGES[c.range].name, c.octave, c.formantRatio,
+                     c.waveformMorph, c.envelopeMorph,
+                     FoldName(c.fold, c.foldMode).c_str(),
+                     MASKING_NAMES[static_cast<int>(c.masking)],
+                     c.lookup == ShapeLookup::TABLE ? "table" : "computed",
+                     EDGE_NAMES[static_cast<int>(c.edges)],
+                     r.nsPerSample,
+                     100.0 * r.nsPerSample / BUDGET_NS_PER_SAMPLE);
+    }
+    std::fclose(f);
+}
+
+// Full parameter grid through PulsarEngine::ProcessBlock
+void RunGridSuite(const Options& options) {
+    std::vector<Config> grid = BuildGrid(options);
+    std::vector<float> buffer(options.blockSize);
+    std::vector<Result> results;
+    results.reserve(grid.size());
+
+    AxisTable table;
+    double checksum = 0.0;
+    double total = 0.0;
+    Result worst{grid.front(), 0.0};
+
+    for (const Config& c : grid) {
+        double ns = Measure(c, options, buffer, checksum);
+        results.push_back(Result{c, ns});
+        total += ns;
+        if (ns > worst.nsPerSample) {
+            worst = results.back();
+        }
+
+        table.Add("range", RANGES[c.range].name, ns);
+        table.Add("octave", Format(c.octave), ns);
+        table.Add("formant", Format(c.formantRatio), ns);
+        table.Add("waveform", Format(c.waveformMorph), ns);
+        table.Add("envelope", Format(c.envelopeMorph), ns);
+        table.Add("fold", FoldName(c.fold, c.foldMode), ns);
+        table.Add("masking", MASKING_NAMES[static_cast<int>(c.masking)], ns);
+        table.Add("lookup", c.lookup == ShapeLookup::TABLE ? "table" : "computed", ns);
+        table.Add("edges", EDGE_NAMES[static_cast<int>(c.edges)], ns);
+    }
+
+    std::printf("PulsarEngine grid: %zu configurations, %zu samples each, "
+                "block %zu\n", grid.size(), options.samples,
+                options.blockSize);
+    table.Print();
+
+    double mean = total / static_cast<double>(grid.size());
+    const Config& w = worst.config;
+    std::printf("\noverall    %10.2f ns/sample  %8.2f Msamples/s  %7.3f%% RT\n",
+                mean, 1.0e3 / mean, 100.0 * mean / BUDGET_NS_PER_SAMPLE);
+    std::printf("worst      %10.2f ns/sample  (%s, octave %g, formant %g, "
+                "waveform %g, envelope %g, fold %s, %s, %s, %s)\n",
+                worst.nsPerSample, RANGES[w.range].name, w.octave,
+                w.formantRatio, w.waveformMorph, w.envelopeMorph,
+                FoldName(w.fold, w.foldMode).c_str(),
+                MASKING_NAMES[static_cast<int>(w.masking)],
+                w.lookup == ShapeLookup::TABLE ? "table" : "computed",
+                EDGE_NAMES[static_cast<int>(w.edges)]);
+    std::printf("(checksum %g)\n", checksum);
+
+    if (options.csvPath != nullptr) {
+        WriteCsv(options.csvPath, results);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::printf("PulsarEngine host benchmark\n");
+    std::printf("Real-time budget at %.0f Hz: %.1f ns/sample\n\n",
+                static_cast<double>(SAMPLE_RATE), BUDGET_NS_PER_SAMPLE);
+
+    if (options.runGrid) {
+        RunGridSuite(options);
+    }
+    if (options.runBank) {
+        RunBankSuite(options);
+    }
+    if (options.runCloud) {
+        RunCloudSuite(options);
+    }
+    if (options.runConvolution) {
+        RunConvolutionSuite(options);
+    }
+    if (options.runFormant) {
+        RunFormantSuite(options);
+    }
+    if (options.runModulation) {
+        RunModulationSuite(options);
+    }
+    return 0;
+}
@@ -0,0 +1,397 @@
+/**
+ * Offline renderer for PulsarEngine
+ *
+ * Plays automation files (timestamped panel changes, see Automation.hpp)
+ * through the engine exactly as the firmware's control loop would and
+ * writes each result to a WAV file. Many files, and sweeps of any panel
+ * control over them, render in parallel on a work-stealing pool; the
+ * run ends with its throughput in renders per minute.
+ */
+
+#include "Automation.hpp"
+#include "Convolver.hpp"
+#include "PulsarControls.hpp"
+#include "PulsaretTables.hpp"
+#include "SampledPulsaret.hpp"
+#include "ThreadPool.hpp"
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One swept control: steps values from start to end inclusive
+struct Sweep {
+    ControlId control;
+    float start;
+    float end;
+    int steps;
+
+    float Value(int step) const {
+        if (steps < 2) {
+            return start;
+        }
+        return start + (end - start) * static_cast<float>(step) /
+                           static_cast<float>(steps - 1);
+    }
+};
+
+// Fixed value for one control, held for the whole render
+struct Override {
+    ControlId control;
+    float value;
+};
+
+struct Options {
+    std::vector<const char*> automationPaths;
+    std::vector<Sweep> sweeps;
+    const char* outDir = ".";
+    int sampleRate = 96000;
+    size_t blockSize = 48;
+    double duration = 0.0;  // 0: last event plus TAIL_SECONDS
+    WavFormat format = WavFormat::FLOAT32;
+    size_t threads = 0;
+    bool quiet = false;
+    const char* samplePath = nullptr;
+    const SampledPulsaret* sample = nullptr;  // Shared by every job
+    const char* irPath = nullptr;
+    const MappedWav* ir = nullptr;
+    size_t channels = 1;
+};
+
+// Convolution partition size, and so latency, for --ir; the renderer
+// removes the latency
+constexpr size_t IR_PARTITION = 256;
+
+// Rendered after the last event when no duration is given
+constexpr double TAIL_SECONDS = 1.0;
+
+struct Job {
+    const Automation* automation;
+    std::vector<Override> overrides;
+    std::string outputPath;
+};
+
+bool IsOverridden(const Job& job, const ControlId& control) {
+    for (const Override& o : job.overrides) {
+        if (o.control == control) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Render one job and write its file; returns frames rendered, 0 on error
+size_t RenderJob(const Job& job, const Options& options, std::string& error) {
+    const std::vector<AutomationEvent>& events = job.automation->events;
+    double duration = options.duration > 0.0
+                          ? options.duration
+                          : job.automation->Length() + TAIL_SECONDS;
+    size_t frames = static_cast<size_t>(duration * options.sampleRate + 0.5);
+
+    // Convolution delays the output by its latency, so render that much
+    // longer and drop the start
+    Convolver convolver;
+    std::vector<float> convolverMemory;
+    size_t latency = 0;
+    if (options.ir != nullptr) {
+        const size_t length = options.ir->GetLength();
+        const size_t partitions = (length + IR_PARTITION - 1) / IR_PARTITION;
+        convolverMemory.resize(Convolver::MemorySize(IR_PARTITION, partitions));
+        convolver.Init(IR_PARTITION, partitions, convolverMemory.data(),
+                       convolverMemory.size());
+        convolver.SetImpulseResponse(
+            options.ir->GetSamples(), length,
+            Convolver::NormalizingGain(options.ir->GetSamples(), length));
+        latency = convolver.GetLatency();
+    }
+    const size_t channels = options.channels;
+    std::vector<float> audio((frames + latency) * channels);
+
+    PulsarEngine engine;
+    engine.Init(static_cast<float>(options.sampleRate));
+    ConfigureEngine(engine);
+
+    PanelState panel;
+    PulsarParams params;
+    params.sample = options.sample;
+    for (const Override& o : job.overrides) {
+        ApplyControl(o.control, o.value, panel, params);
+    }
+
+    // Events land on the first block that starts at or after them, as
+    // the firmware's control loop picks up panel changes between blocks
+    size_t next = 0;
+    for (size_t start = 0; start < frames + latency; start += options.blockSize) {
+        double now = static_cast<double>(start) / options.sampleRate;
+        while (next < events.size() && events[next].time <= now) {
+            const AutomationEvent& e = events[next++];
+            if (!IsOverridden(job, e.control)) {
+                ApplyControl(e.control, e.value, panel, params);
+            }
+        }
+        ApplyPanel(panel, params);
+        engine.Publish(params);
+
+        size_t n = std::min(options.blockSize, frames + latency - start);
+        engine.ProcessBlock(nullptr, nullptr,
+                            PulsarOutput::Interleaved(audio.data() + start * channels, channels),
+                            n);
+        if (latency > 0) {
+            convolver.Process(audio.data() + start, audio.data() + start, n);
+        }
+    }
+
+    if (!WriteWav(job.outputPath, audio.data() + latency * channels, frames,
+                  static_cast<int>(channels), options.sampleRate, options.format, error)) {
+        return 0;
+    }
+    return frames;
+}
+
+// File name without directory or extension
+std::string Stem(const std::string& path) {
+    std::string::size_type slash = path.find_last_of('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    std::string::size_type dot = name.find_last_of('.');
+    return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+// Every combination of sweep steps, for every automation file
+std::vector<Job> BuildJobs(const Options& options,
+                           const std::vector<Automation>& automations) {
+    size_t combinations = 1;
+    for (const Sweep& s : options.sweeps) {
+        combinations *= static_cast<size_t>(s.steps);
+    }
+
+    std::vector<Job> jobs;
+    jobs.reserve(automations.size() * combinations);
+    for (size_t a = 0; a < automations.size(); ++a) {
+        std::string stem = Stem(options.automationPaths[a]);
+        for (size_t c = 0; c < combinations; ++c) {
+            Job job;
+            job.automation = &automations[a];
+            std::string name = stem;
+            size_t index = c;
+            for (const Sweep& s : options.sweeps) {
+                float value = s.Value(static_cast<int>(index % s.steps));
+                index /= s.steps;
+                job.overrides.push_back(Override{s.control, value});
+
+                char label[32];
+                std::snprintf(label, sizeof(label), "_%s-%g",
+                              ControlName(s.control).c_str(),
+                              static_cast<double>(value));
+                name += label;
+            }
+            job.outputPath = std::string(options.outDir) + "/" + name + ".wav";
+            jobs.push_back(std::move(job));
+        }
+    }
+    return jobs;
+}
+
+// control=start:end:steps, or control=value for a single render
+bool ParseSweep(const char* text, Sweep& sweep) {
+    const char* equals = std::strchr(text, '=');
+    if (equals == nullptr ||
+        !ParseControl(std::string(text, equals), sweep.control) ||
+        sweep.control.kind == ControlId::Kind::RESET ||
+        sweep.control.kind == ControlId::Kind::TAP) {
+        return false;
+    }
+
+    std::vector<std::string> fields;
+    std::string rest(equals + 1);
+    std::string::size_type begin = 0;
+    for (;;) {
+        std::string::size_type colon = rest.find(':', begin);
+        fields.push_back(rest.substr(begin, colon - begin));
+        if (colon == std::string::npos) {
+            break;
+        }
+        begin = colon + 1;
+    }
+
+    if (fields.size() == 1) {
+        sweep.steps = 1;
+        return ParseControlValue(sweep.control, fields[0], sweep.start);
+    }
+    if (fields.size() != 3 ||
+        !ParseControlValue(sweep.control, fields[0], sweep.start) ||
+        !ParseControlValue(sweep.control, fields[1], sweep.end)) {
+        return false;
+    }
+    sweep.steps = std::atoi(fields[2].c_str());
+    return sweep.steps >= 1;
+}
+
+void PrintUsage(const char* argv0) {
+    std::printf("usage: %s [options] AUTOMATION...\n"
+                "  --out DIR          directory for the WAV files (default .)\n"
+                "  --duration S       seconds per render (default: last event + %gs)\n"
+                "  --rate HZ          sample rate (default 96000)\n"
+                "  --block N          ProcessBlock size (default 48)\n"
+                "  --format F         s16, s24 or f32 (default f32)\n"
+                "  --jobs N           worker threads (default: all cores)\n"
+                "  --sweep C=A:B:N    render control C at N values from A to B,\n"
+                "                     replacing its automation; repeat to sweep\n"
+                "                     several controls over every combination\n"
+                "  --sample FILE      play the first channel of a WAV file as\n"
+                "                     the pulsaret (one pulsaret long)\n"
+                "  --channels N       interleaved output channels, pulsars spread\n"
+                "                     between them by the panel (default 1)\n"
+                "  --ir FILE          convolve with the first channel of a WAV\n"
+                "                     file, normalized to unit energy\n"
+                "  --quiet            only print the summary\n",
+                argv0, TAIL_SECONDS);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+            options.outDir = argv[++i];
+        } else if (!std::strcmp(argv[i], "--duration") && i + 1 < argc) {
+            options.duration = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc) {
+            options.sampleRate = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--block") && i + 1 < argc) {
+            options.blockSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            if (!ParseWavFormat(argv[++i], options.format)) {
+                PrintUsage(argv[0]);
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "--jobs") && i + 1 < argc) {
+            options.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--sweep") && i + 1 < argc) {
+            Sweep sweep;
+            if (!ParseSweep(argv[++i], sweep)) {
+                std::fprintf(stderr, "bad sweep '%s'\n", argv[i]);
+                return false;
+            }
+            options.sweeps.push_back(sweep);
+        } else if (!std::strcmp(argv[i], "--sample") && i + 1 < argc) {
+            options.samplePath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--channels") && i + 1 < argc) {
+            options.channels = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--ir") && i + 1 < argc) {
+            options.irPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--quiet")) {
+            options.quiet = true;
+        } else if (argv[i][0] != '-') {
+            options.automationPaths.push_back(argv[i]);
+        } else {
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (options.automationPaths.empty() || options.sampleRate <= 0 ||
+        options.blockSize == 0 || options.duration < 0.0 || options.channels < 1 ||
+        options.channels > PulsarOutput::MAX_CHANNELS ||
+        (options.irPath != nullptr && options.channels != 1)) {
+        PrintUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Automation> automations(options.automationPaths.size());
+    for (size_t a = 0; a < automations.size(); ++a) {
+        std::string error;
+        if (!LoadAutomation(options.automationPaths[a], automations[a], error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    std::vector<Job> jobs = BuildJobs(options, automations);
+
+    // The sample is mapped, and its mipmap built, once for all jobs
+    MappedWav sampleFile;
+    std::vector<float> sampleMipmaps;
+    SampledPulsaret sample;
+    if (options.samplePath != nullptr) {
+        std::string error;
+        if (!sampleFile.Open(options.samplePath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        sampleMipmaps.resize(SampledPulsaret::MipmapSize(sampleFile.GetLength()));
+        if (!sample.Init(sampleFile.GetSamples(), sampleFile.GetLength(),
+                         sampleMipmaps.data(), sampleMipmaps.size())) {
+            std::fprintf(stderr, "%s: too short for a pulsaret\n", options.samplePath);
+            return 1;
+        }
+        options.sample = &sample;
+    }
+    MappedWav irFile;
+    if (options.irPath != nullptr) {
+        std::string error;
+        if (!irFile.Open(options.irPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (irFile.GetLength() == 0) {
+            std::fprintf(stderr, "%s: empty impulse response\n", options.irPath);
+            return 1;
+        }
+        options.ir = &irFile;
+    }
+
+    // Shared tables are built lazily by the first engine; do it here,
+    // before any worker can race on them
+    PulsaretTables::Init();
+
+    std::atomic<size_t> framesRendered(0);
+    std::atomic<size_t> failures(0);
+    std::mutex printMutex;
+
+    auto begin = std::chrono::steady_clock::now();
+    size_t threadCount;
+    {
+        ThreadPool pool(options.threads);
+        threadCount = pool.GetThreadCount();
+        for (const Job& job : jobs) {
+            pool.Submit([&, job] {
+                std::string error;
+                size_t frames = RenderJob(job, options, error);
+                framesRendered += frames;
+                std::lock_guard<std::mutex> lock(printMutex);
+                if (frames == 0) {
+                    failures++;
+                    std::fprintf(stderr, "%s\n", error.c_str());
+                } else if (!options.quiet) {
+                    std::printf("%s\n", job.outputPath.c_str());
+                }
+            });
+        }
+        pool.Wait();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin).count();
+
+    size_t rendered = jobs.size() - failures;
+    double audioSeconds = static_cast<double>(framesRendered) / options.sampleRate;
+    std::printf("%zu renders on %zu threads in %.2f s: %.1f renders/min, "
+                "%.1fx real time\n", rendered, threadCount, seconds,
+                60.0 * static_cast<double>(rendered) / seconds,
+                audioSeconds / seconds);
+    return failures == 0 ? 0 : 1;
+}
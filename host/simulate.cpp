@@ -0,0 +1,162 @@
+/**
+ * Real-time simulator for the PulsarVersio firmware
+ *
+ * Runs the firmware (PulsarFirmware.hpp) on SimulatedHardware: audio
+ * callbacks of the module's block size at the module's rate with the
+ * control loop polled between them, the panel driven by an automation
+ * file (see Automation.hpp). Reports the callback load and deadline
+ * misses the load monitor saw and what the control loop did.
+ */
+
+#include "Automation.hpp"
+#include "PulsarFirmware.hpp"
+#include "SimulatedHardware.hpp"
+#include "WavFile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Audio after the last event when no duration is given
+constexpr double TAIL_SECONDS = 1.0;
+
+struct Options {
+    const char* automationPath = nullptr;
+    const char* outPath = nullptr;
+    int sampleRate = 96000;
+    SimulationOptions simulation;
+    bool durationSet = false;
+};
+
+void PrintUsage(const char* argv0) {
+    std::printf("usage: %s [options] [AUTOMATION]\n"
+                "  --block N          audio callback size (default 48)\n"
+                "  --rate HZ          sample rate (default 96000)\n"
+                "  --duration S       seconds of audio (default: last event + %gs)\n"
+                "  --realtime         pace the run to the wall clock\n"
+                "  --sync HZ          sine on the sync input (default none)\n"
+                "  --ring HZ          sine on IN R, for captures (default none)\n"
+                "  --out FILE         write the stereo output as a WAV file\n",
+                argv0, TAIL_SECONDS);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--block") && i + 1 < argc) {
+            options.simulation.blockSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc) {
+            options.sampleRate = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--duration") && i + 1 < argc) {
+            options.simulation.duration = std::atof(argv[++i]);
+            options.durationSet = true;
+        } else if (!std::strcmp(argv[i], "--realtime")) {
+            options.simulation.realtime = true;
+        } else if (!std::strcmp(argv[i], "--sync") && i + 1 < argc) {
+            options.simulation.syncFrequency = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--ring") && i + 1 < argc) {
+            options.simulation.ringFrequency = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+            options.outPath = argv[++i];
+        } else if (argv[i][0] != '-' && options.automationPath == nullptr) {
+            options.automationPath = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (options.sampleRate <= 0 || options.simulation.blockSize == 0 ||
+        options.simulation.duration <= 0.0 || options.simulation.syncFrequency < 0.0f ||
+        options.simulation.ringFrequency < 0.0f) {
+        PrintUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    Automation automation;
+    if (options.automationPath != nullptr) {
+        std::string error;
+        if (!LoadAutomation(options.automationPath, automation, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    if (!options.durationSet) {
+        options.simulation.duration = automation.Length() + TAIL_SECONDS;
+    }
+
+    // Boot as the module does, calibration included if the script holds
+    // the button with both switches right
+    SimulatedHardware hardware;
+    hardware.Init(static_cast<float>(options.sampleRate));
+    hardware.SetAutomation(automation);
+    hardware.Advance(0);
+    std::unique_ptr<PulsarFirmware<SimulatedHardware>> firmware(
+        new PulsarFirmware<SimulatedHardware>(hardware));
+    firmware->Init();
+    double bootSeconds = hardware.GetTimeNs() * 1e-9;
+
+    std::vector<float> output;
+    SimulationReport report;
+    Simulate(*firmware, hardware, options.simulation, report,
+             options.outPath != nullptr ? &output : nullptr);
+
+    const LoadStats& stats = firmware->GetLoadMonitor().GetStats();
+    const double budgetNs = options.simulation.blockSize * 1e9 / options.sampleRate;
+    double simulated = report.blocks * budgetNs * 1e-9;
+    std::printf("%u blocks of %zu at %d Hz: %.2f s simulated in %.2f s (%.1fx real time)\n",
+                report.blocks, options.simulation.blockSize, options.sampleRate, simulated,
+                report.wallSeconds, simulated / report.wallSeconds);
+    if (bootSeconds > 0.0) {
+        const VoctCalibration& calibration = firmware->GetCalibration();
+        std::printf("boot and calibration: %.2f s, V/Oct codes", bootSeconds);
+        for (int v = 0; v < VoctCalibration::POINTS; ++v) {
+            std::printf(" %.0f", calibration.Code(v));
+        }
+        std::printf("\n");
+    }
+    std::printf("callback: avg %.2f us (%.1f%%), max %.2f us (%.1f%%) of %.2f us\n",
+                stats.AverageCycles() * 1e-3, stats.AverageLoad() * 100.0,
+                stats.maxCycles * 1e-3, stats.maxCycles / budgetNs * 100.0, budgetNs * 1e-3);
+    std::printf("deadline misses: %u", stats.misses);
+    if (options.simulation.realtime) {
+        std::printf(", late starts: %u", report.lateBlocks);
+    }
+    std::printf("\nload histogram:");
+    for (int bin = 0; bin < LoadStats::HISTOGRAM_BINS - 1; ++bin) {
+        std::printf(" %d%%:%u", bin * 10, stats.histogram[bin]);
+    }
+    std::printf(" miss:%u\n", stats.histogram[LoadStats::HISTOGRAM_BINS - 1]);
+    std::printf("control: %u ticks (%.0f/s), %u publishes, %u captures, pass avg %.0f ns, "
+                "max %llu ns\n",
+                firmware->GetControlTicks(), firmware->GetControlTicks() / simulated,
+                firmware->GetPublishCount(), firmware->GetCaptureCount(),
+                report.controlPasses > 0
+                    ? static_cast<double>(report.controlNs) / report.controlPasses : 0.0,
+                static_cast<unsigned long long>(report.maxControlNs));
+    std::printf("leds: %u updates (%.0f/s)\n", firmware->GetLedTicks(),
+                firmware->GetLedTicks() / simulated);
+
+    if (options.outPath != nullptr) {
+        std::string error;
+        if (!WriteWav(options.outPath, output.data(), output.size() / 2, 2,
+                      options.sampleRate, WavFormat::FLOAT32, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    return stats.misses > 0 ? 2 : 0;
+}
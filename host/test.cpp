@@ -0,0 +1,1930 @@
+/**
+ * Regression tests for PulsarEngine
+ *
+ * Renders a fixed set of deterministic scenarios (every waveform and
+ * envelope, masking, sub-sample sync, folding, modulation, the bank,
+ * the cloud, a sampled pulsaret and convolution) and checks each against
+ * tests/golden.txt, then times each against the ns/sample
+ * baselines in tests/perf_baseline.txt.
+ *
+ * A golden entry holds a hash of the exact output bits and a coarse
+ * fingerprint (RMS of SEGMENTS equal segments). A matching hash passes
+ * outright; otherwise the fingerprint must agree within
+ * FINGERPRINT_TOLERANCE, which absorbs libm and compiler rounding
+ * differences between machines but not a change in behaviour. --exact
+ * requires the hash.
+ *
+ * The engine has no unseeded state, so every scenario renders the same
+ * output on every run.
+ *
+ * The Oversampler's bypass delay is checked against its filters,
+ * LoadMonitor's bookkeeping separately on a simulated clock,
+ * the firmware's boot calibration and control loop on simulated hardware,
+ * PulsarCloud's pool against its capacity and steal policies,
+ * SampledPulsaret's mipmap and MappedWav's loading, Convolver against
+ * direct convolution, multichannel output layouts and pulsar placement,
+ * the Random.hpp streams' skip-ahead and statistics, and the FastMath.hpp
+ * approximations against their documented error bounds across their
+ * whole input domains.
+ */
+
+#include "Automation.hpp"
+#include "ControlTask.hpp"
+#include "Convolver.hpp"
+#include "FastMath.hpp"
+#include "LoadMonitor.hpp"
+#include "Oversampler.hpp"
+#include "PulsarBank.hpp"
+#include "PulsarCloud.hpp"
+#include "PulsarEngine.hpp"
+#include "PulsarFirmware.hpp"
+#include "PulsarSimd.hpp"
+#include "Random.hpp"
+#include "SampledPulsaret.hpp"
+#include "SimulatedHardware.hpp"
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr float SAMPLE_RATE = 96000.0f;
+constexpr size_t BLOCK_SIZE = 48;
+
+// 100 ms per golden render, one second per timing run
+constexpr size_t GOLDEN_SAMPLES = 9600;
+constexpr size_t PERF_SAMPLES = 96000;
+
+constexpr int SEGMENTS = 16;
+constexpr double FINGERPRINT_TOLERANCE = 2.0e-4;
+
+// Slack on top of the relative threshold, so that scenarios of a few
+// ns/sample do not fail on timer noise
+constexpr double PERF_SLACK_NS = 0.5;
+
+const char* WAVEFORM_NAMES[] = {"sine", "triangle", "saw-up", "saw-down",
+                                "square", "pulse", "noise"};
+const char* ENVELOPE_NAMES[] = {"rectangular", "gaussian", "expodec",
+                                "linear-decay", "linear-attack", "expo-attack",
+                                "fof"};
+
+using RenderFn = std::function<void(float* out, size_t size)>;
+
+struct Scenario {
+    std::string name;
+    RenderFn render;
+};
+
+struct Golden {
+    uint64_t hash;
+    double fingerprint[SEGMENTS];
+};
+
+struct Options {
+    const char* goldenPath = "tests/golden.txt";
+    const char* perfPath = "tests/perf_baseline.txt";
+    const char* filter = nullptr;
+    double threshold = 0.25;
+    int repeats = 7;
+    bool updateGolden = false;
+    bool updatePerf = false;
+    bool runPerf = true;
+    bool exact = false;
+};
+
+// Engine with the settings every scenario starts from
+void InitEngine(PulsarEngine& engine) {
+    engine.Init(SAMPLE_RATE);
+    engine.SetFrequency(220.0f);
+    engine.SetFormantRatio(0.4f);
+    engine.SetWaveformMorph(0.0f);
+    engine.SetEnvelopeMorph(1.0f);
+}
+
+void RenderBlocks(PulsarEngine& engine, float* out, size_t size) {
+    for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+        engine.ProcessBlock(out + start, std::min(BLOCK_SIZE, size - start));
+    }
+}
+
+// Scenario that configures an engine and renders it block by block
+Scenario EngineScenario(const std::string& name,
+                        std::function<void(PulsarEngine&)> setup) {
+    return Scenario{name, [setup](float* out, size_t size) {
+                        PulsarEngine engine;
+                        InitEngine(engine);
+                        setup(engine);
+                        RenderBlocks(engine, out, size);
+                    }};
+}
+
+// Scenario that configures a cloud and renders it block by block
+Scenario CloudScenario(const std::string& name,
+                       std::function<void(PulsarCloud&)> setup) {
+    return Scenario{name, [setup](float* out, size_t size) {
+                        PulsarCloud cloud;
+                        cloud.Init(SAMPLE_RATE, PulsarCloud::MAX_PULSARETS);
+                        setup(cloud);
+                        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+                            cloud.Process(out + start, std::min(BLOCK_SIZE, size - start));
+                        }
+                    }};
+}
+
+std::vector<Scenario> BuildScenarios() {
+    std::vector<Scenario> scenarios;
+
+    for (int w = 0; w < 7; ++w) {
+        scenarios.push_back(EngineScenario(
+            std::string("waveform-") + WAVEFORM_NAMES[w],
+            [w](PulsarEngine& e) { e.SetWaveformMorph(static_cast<float>(w)); }));
+    }
+    for (int v = 0; v < 7; ++v) {
+        scenarios.push_back(EngineScenario(
+            std::string("envelope-") + ENVELOPE_NAMES[v],
+            [v](PulsarEngine& e) { e.SetEnvelopeMorph(static_cast<float>(v)); }));
+    }
+    scenarios.push_back(EngineScenario("morph-between", [](PulsarEngine& e) {
+        e.SetWaveformMorph(1.75f);
+        e.SetEnvelopeMorph(3.25f);
+    }));
+    scenarios.push_back(EngineScenario("lookup-computed", [](PulsarEngine& e) {
+        e.SetShapeLookup(ShapeLookup::COMPUTED);
+        e.SetWaveformMorph(1.5f);
+        e.SetEnvelopeMorph(6.0f);
+    }));
+    scenarios.push_back(EngineScenario("edges-bandlimited", [](PulsarEngine& e) {
+        e.SetEdgeMode(EdgeMode::BAND_LIMITED);
+        e.SetFrequency(1200.0f);
+        e.SetWaveformMorph(4.0f);
+        e.SetEnvelopeMorph(0.0f);
+    }));
+    scenarios.push_back(EngineScenario("formants-3", [](PulsarEngine& e) {
+        e.SetFormantCount(3);
+        e.SetFormant(1, 0.2f, 1.0f, 0.5f);
+        e.SetFormant(2, 0.08f, 4.0f, 0.25f);
+    }));
+
+    scenarios.push_back(EngineScenario("mask-burst", [](PulsarEngine& e) {
+        e.SetFrequency(880.0f);
+        e.SetMaskingMode(MaskingMode::BURST);
+        e.SetBurstRatio(3, 2);
+    }));
+    scenarios.push_back(EngineScenario("mask-stochastic", [](PulsarEngine& e) {
+        e.SetFrequency(880.0f);
+        e.SetMaskingMode(MaskingMode::STOCHASTIC);
+        e.SetMaskingProbability(0.5f);
+        e.SetWaveformMorph(6.0f);
+    }));
+
+    // Mostly silence: short pulsarets at LFO rates, and sparse masking
+    // on the general renderer and with inline folding
+    scenarios.push_back(EngineScenario("sparse-lfo", [](PulsarEngine& e) {
+        e.SetFrequency(20.0f);
+        e.SetFormantRatio(0.05f);
+    }));
+    scenarios.push_back(EngineScenario("sparse-burst-edges", [](PulsarEngine& e) {
+        e.SetFrequency(440.0f);
+        e.SetFormantRatio(0.2f);
+        e.SetEdgeMode(EdgeMode::BAND_LIMITED);
+        e.SetFormantCount(2);
+        e.SetFormant(1, 0.3f, 2.0f, 0.5f);
+        e.SetMaskingMode(MaskingMode::BURST);
+        e.SetBurstRatio(1, 7);
+    }));
+    scenarios.push_back(EngineScenario("sparse-stochastic-fold", [](PulsarEngine& e) {
+        e.SetFrequency(110.0f);
+        e.SetFormantRatio(0.1f);
+        e.SetMaskingMode(MaskingMode::STOCHASTIC);
+        e.SetMaskingProbability(0.25f);
+        e.SetFold(0.5f);
+    }));
+
+    // Hard sync and ring modulation from the audio inputs
+    scenarios.push_back(Scenario{"sync-ring", [](float* out, size_t size) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetWaveformMorph(2.0f);
+        float sync[BLOCK_SIZE];
+        float ring[BLOCK_SIZE];
+        float dry[BLOCK_SIZE];
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, size - start);
+            for (size_t i = 0; i < n; ++i) {
+                float t = static_cast<float>(start + i) / SAMPLE_RATE;
+                sync[i] = sinf(2.0f * static_cast<float>(M_PI) * 150.0f * t);
+                ring[i] = 0.5f * sinf(2.0f * static_cast<float>(M_PI) * 37.0f * t);
+            }
+            engine.ProcessBlock(sync, ring, dry, out + start, n);
+        }
+    }});
+
+    // Band-limited sync steps, between samples, through the module's fold
+    scenarios.push_back(Scenario{"sync-band-limited", [](float* out, size_t size) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFormantRatio(0.8f);
+        engine.SetEdgeMode(EdgeMode::BAND_LIMITED);
+        engine.SetFoldOversampling(2);
+        engine.SetFoldMode(FoldMode::ADAA);
+        engine.SetFold(0.3f);
+        float sync[BLOCK_SIZE];
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, size - start);
+            for (size_t i = 0; i < n; ++i) {
+                float t = static_cast<float>(start + i) / SAMPLE_RATE;
+                sync[i] = sinf(2.0f * static_cast<float>(M_PI) * 1234.5f * t);
+            }
+            engine.ProcessBlock(sync, nullptr, out + start, nullptr, n);
+        }
+    }});
+
+    struct FoldCase {
+        const char* name;
+        int factor;
+        FoldMode mode;
+    };
+    const FoldCase folds[] = {
+        {"fold-1x", 1, FoldMode::DIRECT},
+        {"fold-1x-adaa", 1, FoldMode::ADAA},
+        {"fold-2x", 2, FoldMode::DIRECT},
+        {"fold-2x-adaa", 2, FoldMode::ADAA},
+        {"fold-4x", 4, FoldMode::DIRECT},
+    };
+    for (const FoldCase& f : folds) {
+        scenarios.push_back(EngineScenario(f.name, [f](PulsarEngine& e) {
+            e.SetFoldOversampling(f.factor);
+            e.SetFoldMode(f.mode);
+            e.SetFold(0.7f);
+        }));
+    }
+
+    // Fold opening and closing through Publish, with a reset midway
+    scenarios.push_back(Scenario{"publish-fold-ramp", [](float* out, size_t size) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFoldOversampling(2);
+        engine.SetFoldMode(FoldMode::ADAA);
+        PulsarParams params;
+        params.envelopeMorph = 1.0f;
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            float t = static_cast<float>(start) / static_cast<float>(size);
+            params.fold = (t < 0.5f) ? 2.0f * t : 2.0f - 2.0f * t;
+            params.frequency = 110.0f + 330.0f * t;
+            if (start == size / 2 / BLOCK_SIZE * BLOCK_SIZE) {
+                params.resetCount++;
+            }
+            engine.Publish(params);
+            engine.ProcessBlock(out + start, std::min(BLOCK_SIZE, size - start));
+        }
+    }});
+
+    // Audio-rate pitch and formant modulation
+    scenarios.push_back(Scenario{"modulation", [](float* out, size_t size) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetEdgeMode(EdgeMode::BAND_LIMITED);
+        float pitch[BLOCK_SIZE];
+        float formant[BLOCK_SIZE];
+        PulsarModulation mod;
+        mod.pitch = pitch;
+        mod.formantRatio = formant;
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, size - start);
+            for (size_t i = 0; i < n; ++i) {
+                float t = static_cast<float>(start + i) / SAMPLE_RATE;
+                pitch[i] = sinf(2.0f * static_cast<float>(M_PI) * 5.0f * t);
+                formant[i] = 0.3f * sinf(2.0f * static_cast<float>(M_PI) * 3.0f * t);
+            }
+            engine.ProcessBlock(mod, out + start, n);
+        }
+    }});
+
+    scenarios.push_back(Scenario{"bank-8", [](float* out, size_t size) {
+        PulsarBank bank;
+        bank.Init(SAMPLE_RATE, 8);
+        bank.SetMaskingMode(MaskingMode::STOCHASTIC);
+        for (size_t v = 0; v < 8; ++v) {
+            float k = static_cast<float>(v);
+            bank.SetFrequency(v, 110.0f * (1.0f + 0.5f * k));
+            bank.SetFormantRatio(v, 0.1f + 0.1f * k);
+            bank.SetWaveformMorph(v, 0.75f * k);
+            bank.SetEnvelopeMorph(v, 6.0f - 0.75f * k);
+            bank.SetAmplitude(v, 0.125f);
+            bank.SetMaskingProbability(v, 0.8f);
+        }
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            bank.Process(out + start, std::min(BLOCK_SIZE, size - start));
+        }
+    }});
+
+    // Jittered overlapping pulsarets, and a pool too small for the
+    // overlap under each steal policy
+    scenarios.push_back(CloudScenario("cloud-overlap", [](PulsarCloud& c) {
+        c.SetFrequency(300.0f);
+        c.SetFormantFrequency(70.0f);
+        c.SetJitter(0.3f);
+        c.SetWaveformMorph(1.5f);
+        c.SetAmplitude(0.25f);
+    }));
+    scenarios.push_back(CloudScenario("cloud-steal-oldest", [](PulsarCloud& c) {
+        c.SetCapacity(4);
+        c.SetFrequency(1000.0f);
+        c.SetFormantFrequency(100.0f);
+        c.SetMaskingMode(MaskingMode::STOCHASTIC);
+        c.SetMaskingProbability(0.7f);
+    }));
+    scenarios.push_back(CloudScenario("cloud-steal-quietest", [](PulsarCloud& c) {
+        c.SetCapacity(4);
+        c.SetStealPolicy(StealPolicy::QUIETEST);
+        c.SetFrequency(1000.0f);
+        c.SetFormantFrequency(100.0f);
+        c.SetJitter(0.5f);
+        c.SetEnvelopeMorph(2.0f);
+    }));
+
+    // A bright sampled pulsaret played from high mipmap levels, the
+    // formant ratio swept so that the levels crossfade
+    scenarios.push_back(Scenario{"sampled-mipmap", [](float* out, size_t size) {
+        static std::vector<float> source;
+        static std::vector<float> mipmaps;
+        static SampledPulsaret sample;
+        if (source.empty()) {
+            source.resize(1024);
+            for (size_t i = 0; i < source.size(); ++i) {
+                float x = static_cast<float>(i) / static_cast<float>(source.size());
+                source[i] = 2.0f * x - 1.0f + 0.3f * std::sin(97.0f * 6.2831853f * x);
+            }
+            mipmaps.resize(SampledPulsaret::MipmapSize(source.size()));
+            sample.Init(source.data(), source.size(), mipmaps.data(), mipmaps.size());
+        }
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetSample(&sample);
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            float t = static_cast<float>(start) / static_cast<float>(size);
+            engine.SetFormantRatio(0.03f + 0.6f * t);
+            engine.ProcessBlock(out + start, std::min(BLOCK_SIZE, size - start));
+        }
+    }});
+
+    // The pulsar train through a 50 ms resonant impulse response
+    scenarios.push_back(Scenario{"convolve-train", [](float* out, size_t size) {
+        const size_t partition = 256;
+        const size_t length = 4800;
+        static std::vector<float> ir;
+        static std::vector<float> memory;
+        if (ir.empty()) {
+            ir.resize(length);
+            for (size_t i = 0; i < length; ++i) {
+                float t = static_cast<float>(i) / SAMPLE_RATE;
+                ir[i] = std::exp(-60.0f * t) * std::sin(6.2831853f * 1500.0f * t);
+            }
+            memory.resize(Convolver::MemorySize(partition, length / partition + 1));
+        }
+        Convolver convolver;
+        convolver.Init(partition, length / partition + 1, memory.data(), memory.size());
+        convolver.SetImpulseResponse(ir.data(), length,
+                                     Convolver::NormalizingGain(ir.data(), length));
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFormantRatio(0.2f);
+        for (size_t start = 0; start < size; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, size - start);
+            engine.ProcessBlock(out + start, n);
+            convolver.Process(out + start, out + start, n);
+        }
+    }});
+
+    // Pulsars scattered over an interleaved stereo pair, through the
+    // oversampled fold's delay; size counts samples of both channels
+    scenarios.push_back(Scenario{"spatial-scatter", [](float* out, size_t size) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFrequency(880.0f);
+        engine.SetFoldOversampling(2);
+        engine.SetFoldMode(FoldMode::ADAA);
+        engine.SetFold(0.3f);
+        engine.SetSpatialMode(SpatialMode::SCATTER);
+        engine.SetSpread(0.8f);
+        const size_t frames = size / 2;
+        for (size_t start = 0; start < frames; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, frames - start);
+            engine.ProcessBlock(nullptr, nullptr,
+                                PulsarOutput::Interleaved(out + 2 * start, 2), n);
+        }
+    }});
+
+    return scenarios;
+}
+
+// FNV-1a over the sample bits
+uint64_t HashSamples(const std::vector<float>& samples) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (float s : samples) {
+        uint32_t bits;
+        std::memcpy(&bits, &s, sizeof(bits));
+        for (int b = 0; b < 4; ++b) {
+            hash ^= (bits >> (8 * b)) & 0xFF;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return hash;
+}
+
+Golden Measure(const std::vector<float>& samples) {
+    Golden golden;
+    golden.hash = HashSamples(samples);
+    size_t length = samples.size() / SEGMENTS;
+    for (int s = 0; s < SEGMENTS; ++s) {
+        double sum = 0.0;
+        for (size_t i = 0; i < length; ++i) {
+            double x = samples[s * length + i];
+            sum += x * x;
+        }
+        golden.fingerprint[s] = std::sqrt(sum / static_cast<double>(length));
+    }
+    return golden;
+}
+
+// name hash rms...
+bool LoadGolden(const char* path, std::map<std::string, Golden>& goldens) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        std::string hash;
+        Golden golden;
+        fields >> name >> hash;
+        golden.hash = std::strtoull(hash.c_str(), nullptr, 16);
+        for (int s = 0; s < SEGMENTS; ++s) {
+            fields >> golden.fingerprint[s];
+        }
+        if (fields) {
+            goldens[name] = golden;
+        }
+    }
+    return true;
+}
+
+bool SaveGolden(const char* path, const std::vector<Scenario>& scenarios,
+                const std::map<std::string, Golden>& goldens) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) {
+        return false;
+    }
+    std::fprintf(f, "# PulsarEngine golden outputs: name, FNV-1a hash of the sample "
+                    "bits,\n# RMS of %d segments. Regenerate with "
+                    "pulsar_test --update-golden.\n", SEGMENTS);
+    for (const Scenario& scenario : scenarios) {
+        auto it = goldens.find(scenario.name);
+        if (it == goldens.end()) {
+            continue;
+        }
+        std::fprintf(f, "%s %016llx", scenario.name.c_str(),
+                     static_cast<unsigned long long>(it->second.hash));
+        for (int s = 0; s < SEGMENTS; ++s) {
+            std::fprintf(f, " %.7e", it->second.fingerprint[s]);
+        }
+        std::fprintf(f, "\n");
+    }
+    return std::fclose(f) == 0;
+}
+
+// name ns_per_sample
+bool LoadPerf(const char* path, std::map<std::string, double>& baselines) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        double ns;
+        if (fields >> name >> ns) {
+            baselines[name] = ns;
+        }
+    }
+    return true;
+}
+
+bool SavePerf(const char* path, const std::vector<Scenario>& scenarios,
+              const std::map<std::string, double>& baselines) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) {
+        return false;
+    }
+    std::fprintf(f, "# PulsarEngine ns/sample baselines, best of several runs. "
+                    "Machine specific:\n# regenerate with pulsar_test "
+                    "--update-perf on the machine that runs the tests.\n");
+    for (const Scenario& scenario : scenarios) {
+        auto it = baselines.find(scenario.name);
+        if (it != baselines.end()) {
+            std::fprintf(f, "%s %.3f\n", scenario.name.c_str(), it->second);
+        }
+    }
+    return std::fclose(f) == 0;
+}
+
+// Best ns/sample per scenario. Repeats are interleaved, one round over
+// every scenario at a time, so that a burst of load from elsewhere on
+// the machine slows one run of many scenarios rather than every run of
+// one.
+std::vector<double> TimeScenarios(const std::vector<Scenario>& scenarios, int repeats) {
+    std::vector<float> buffer(PERF_SAMPLES);
+    std::vector<double> best(scenarios.size(), 0.0);
+    for (int run = 0; run < repeats; ++run) {
+        for (size_t s = 0; s < scenarios.size(); ++s) {
+            auto start = std::chrono::steady_clock::now();
+            scenarios[s].render(buffer.data(), buffer.size());
+            auto stop = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count() /
+                        static_cast<double>(buffer.size());
+            if (run == 0 || ns < best[s]) {
+                best[s] = ns;
+            }
+        }
+    }
+    return best;
+}
+
+// Returns the number of failures
+int RunGolden(const Options& options, const std::vector<Scenario>& scenarios) {
+    std::map<std::string, Golden> goldens;
+    if (!LoadGolden(options.goldenPath, goldens) && !options.updateGolden) {
+        std::printf("cannot read %s\n", options.goldenPath);
+        return 1;
+    }
+
+    std::printf("Golden output (%zu samples at %.0f Hz)\n", GOLDEN_SAMPLES,
+                static_cast<double>(SAMPLE_RATE));
+    int failures = 0;
+    std::vector<float> buffer(GOLDEN_SAMPLES);
+    for (const Scenario& scenario : scenarios) {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        scenario.render(buffer.data(), buffer.size());
+        Golden actual = Measure(buffer);
+
+        if (options.updateGolden) {
+            goldens[scenario.name] = actual;
+            std::printf("  %-22s updated\n", scenario.name.c_str());
+            continue;
+        }
+
+        auto it = goldens.find(scenario.name);
+        if (it == goldens.end()) {
+            std::printf("  %-22s FAIL  no golden entry\n", scenario.name.c_str());
+            ++failures;
+            continue;
+        }
+        if (actual.hash == it->second.hash) {
+            std::printf("  %-22s ok    exact\n", scenario.name.c_str());
+            continue;
+        }
+
+        double worst = 0.0;
+        for (int s = 0; s < SEGMENTS; ++s) {
+            worst = std::max(worst, std::fabs(actual.fingerprint[s] -
+                                              it->second.fingerprint[s]));
+        }
+        if (worst <= FINGERPRINT_TOLERANCE && !options.exact) {
+            std::printf("  %-22s ok    within tolerance (%.2e)\n",
+                        scenario.name.c_str(), worst);
+        } else {
+            std::printf("  %-22s FAIL  hash %016llx, expected %016llx; "
+                        "fingerprint off by %.2e\n", scenario.name.c_str(),
+                        static_cast<unsigned long long>(actual.hash),
+                        static_cast<unsigned long long>(it->second.hash), worst);
+            ++failures;
+        }
+    }
+
+    if (options.updateGolden && !SaveGolden(options.goldenPath, scenarios, goldens)) {
+        std::printf("cannot write %s\n", options.goldenPath);
+        return 1;
+    }
+    return failures;
+}
+
+// Returns the number of regressions
+int RunPerf(const Options& options, const std::vector<Scenario>& scenarios) {
+    std::map<std::string, double> baselines;
+    if (!LoadPerf(options.perfPath, baselines) && !options.updatePerf) {
+        std::printf("cannot read %s\n", options.perfPath);
+        return 1;
+    }
+
+    std::printf("\nPerformance (ns/sample, best of %d, limit +%.0f%%)\n",
+                options.repeats, 100.0 * options.threshold);
+    int failures = 0;
+    std::vector<double> times = TimeScenarios(scenarios, options.repeats);
+    for (size_t s = 0; s < scenarios.size(); ++s) {
+        const Scenario& scenario = scenarios[s];
+        double ns = times[s];
+
+        if (options.updatePerf) {
+            baselines[scenario.name] = ns;
+            std::printf("  %-22s %8.2f  updated\n", scenario.name.c_str(), ns);
+            continue;
+        }
+
+        auto it = baselines.find(scenario.name);
+        if (it == baselines.end()) {
+            std::printf("  %-22s %8.2f  no baseline\n", scenario.name.c_str(), ns);
+            continue;
+        }
+        double limit = it->second * (1.0 + options.threshold) + PERF_SLACK_NS;
+        double change = 100.0 * (ns / it->second - 1.0);
+        if (ns <= limit) {
+            std::printf("  %-22s %8.2f  ok    (%+.1f%%)\n", scenario.name.c_str(),
+                        ns, change);
+        } else {
+            std::printf("  %-22s %8.2f  FAIL  (%+.1f%% against %.2f)\n",
+                        scenario.name.c_str(), ns, change, it->second);
+            ++failures;
+        }
+    }
+
+    if (options.updatePerf && !SavePerf(options.perfPath, scenarios, baselines)) {
+        std::printf("cannot write %s\n", options.perfPath);
+        return 1;
+    }
+    return failures;
+}
+
+// The firmware's control task pieces: RateTimer against a simulated
+// 480 MHz counter, KnobFilter hysteresis, and the engine applying only
+// what a snapshot changes. Returns the number of failures.
+int RunControlTask() {
+    std::printf("\nControl task\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // One second of a loop polling at an uneven pace, across the
+    // counter wrapping
+    const uint32_t CLOCK = 480000000u;
+    RateTimer timer;
+    uint32_t now = 0xFFFFFFFFu - 1000000u;
+    timer.Init(1500.0f, CLOCK, now);
+    int ticks = 0;
+    for (uint32_t elapsed = 0; elapsed < CLOCK; elapsed += 7919 + (elapsed % 3) * 1000) {
+        ticks += timer.Due(now + elapsed) ? 1 : 0;
+    }
+    check(ticks >= 1499 && ticks <= 1501, "ticks at the set rate");
+
+    // A 10 ms stall owes 15 ticks, but only one is taken
+    now += CLOCK;
+    while (!timer.Due(now)) {
+        now += 1000;
+    }
+    now += CLOCK / 100;
+    int burst = 0;
+    for (int i = 0; i < 100; ++i) {
+        burst += timer.Due(now + static_cast<uint32_t>(i)) ? 1 : 0;
+    }
+    check(burst == 1, "a stall drops the ticks it missed");
+
+    // Noise smaller than the threshold reports nothing; a sweep is
+    // followed to within the threshold
+    KnobFilter filter;
+    filter.Init(0.1f, 0.002f, 0.5f);
+    int changes = 0;
+    for (int i = 0; i < 1000; ++i) {
+        changes += filter.Process(0.5f + ((i % 2) ? 0.0015f : -0.0015f)) ? 1 : 0;
+    }
+    check(changes == 0, "a resting knob reports no change");
+    for (int i = 0; i <= 1500; ++i) {
+        changes += filter.Process(0.5f + 0.5f * static_cast<float>(i) / 1500.0f) ? 1 : 0;
+    }
+    for (int i = 0; i < 200; ++i) {
+        changes += filter.Process(1.0f) ? 1 : 0;
+    }
+    check(changes > 100 && std::fabs(filter.Value() - 1.0f) <= 0.002f,
+          "a moving knob is followed");
+
+    // Publishing only a new frequency renders as every setter would;
+    // the duty cycle follows the frequency
+    PulsarParams first;
+    first.frequency = 300.0f;
+    first.formantRatio = 0.3f;
+    first.waveformMorph = 1.5f;
+    first.fold = 0.4f;
+    first.maskingMode = MaskingMode::BURST;
+    first.burstCount = 3;
+    first.restCount = 1;
+    PulsarParams second = first;
+    second.frequency = 450.0f;
+    auto setters = [](PulsarEngine& e, const PulsarParams& p) {
+        e.SetFrequency(p.frequency);
+        e.SetFormantRatio(p.formantRatio);
+        e.SetWaveformMorph(p.waveformMorph);
+        e.SetEnvelopeMorph(p.envelopeMorph);
+        e.SetFold(p.fold);
+        e.SetAmplitude(p.amplitude);
+        e.SetMaskingMode(p.maskingMode);
+        e.SetBurstRatio(p.burstCount, p.restCount);
+        e.SetMaskingProbability(p.maskingProbability);
+        e.SetSpatialMode(p.spatialMode);
+        e.SetSpread(p.spread);
+        e.SetSample(p.sample);
+    };
+    PulsarEngine published;
+    PulsarEngine reference;
+    InitEngine(published);
+    InitEngine(reference);
+    const size_t FRAMES = 4800;
+    std::vector<float> a(FRAMES);
+    std::vector<float> b(FRAMES);
+    for (size_t start = 0; start < FRAMES; start += BLOCK_SIZE) {
+        const PulsarParams& p = (start < FRAMES / 2) ? first : second;
+        if (start == 0 || start == FRAMES / 2) {
+            published.Publish(p);
+            setters(reference, p);
+        }
+        published.ProcessBlock(a.data() + start, BLOCK_SIZE);
+        reference.ProcessBlock(b.data() + start, BLOCK_SIZE);
+    }
+    check(a == b, "snapshots apply only what changed");
+    return failures;
+}
+
+// The V/Oct calibration table and settings upgrade, then the whole
+// firmware on SimulatedHardware: a scripted boot calibration against a
+// bowed CV ADC unlike the defaults, then the control loop between audio
+// callbacks. Returns the number of failures.
+int RunFirmware() {
+    std::printf("\nFirmware simulation\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // Every code's ratio against the exponential of its volts
+    float codes[VoctCalibration::POINTS] = {64500.0f, 51680.0f, 38800.0f,
+                                            25960.0f, 13100.0f, 270.0f};
+    VoctCalibration table;
+    table.Init(codes);
+    double worstCents = 0.0;
+    for (int code = 0; code < 65536; ++code) {
+        double cents = 1200.0 * std::log2(table.Ratio(static_cast<float>(code))) -
+                       1200.0 * table.Volts(static_cast<float>(code));
+        worstCents = std::max(worstCents, std::fabs(cents));
+    }
+    check(worstCents < 0.1 && table.Volts(38800.0f) == 2.0f && table.Volts(65535.0f) == 0.0f &&
+              table.Volts(0.0f) == 5.0f,
+          "calibration table lookup");
+
+    // A version 1 blob keeps its line; anything else is refused
+    Settings settings;
+    float oldLayout[2] = {64262.0f, 12826.0f};
+    std::memcpy(&settings.version, &oldLayout[0], sizeof(float));
+    settings.calibrationCodes[0] = oldLayout[1];
+    bool upgraded = UpgradeSettings(settings) && settings.version == Settings::VERSION &&
+                    settings.calibrationCodes[0] == 64262.0f &&
+                    settings.calibrationCodes[5] == 64262.0f - 5.0f * 12826.0f;
+    settings.version = 7;
+    settings.calibrationCodes[0] = 0.0f;
+    check(upgraded && !UpgradeSettings(settings), "settings upgrade from version 1");
+
+    Automation script;
+    auto at = [&script](double time, const char* name, float value) {
+        AutomationEvent event;
+        event.time = time;
+        ParseControl(name, event.control);
+        event.value = value;
+        script.events.push_back(event);
+    };
+    // Boot holding the button with both switches right, then step
+    // through 0 V to 5 V, each read 200 ms after its tap
+    at(0.0, "mask", 2.0f);
+    at(0.0, "range", 2.0f);
+    at(0.0, "tap", 1.0f);
+    at(0.05, "tap", 0.0f);
+    for (int v = 0; v < VoctCalibration::POINTS; ++v) {
+        at(0.1 + 0.5 * v, "knob0", static_cast<float>(v));
+        at(0.2 + 0.5 * v, "tap", 1.0f);
+        at(0.3 + 0.5 * v, "tap", 0.0f);
+    }
+    // Play, rest, then move a knob and pulse the gate
+    at(3.1, "mask", 0.0f);
+    at(3.1, "range", 1.0f);
+    at(3.1, "knob0", 1.5f);
+    at(3.1, "knob1", 0.3f);
+    at(4.5, "knob1", 0.6f);
+    at(4.5, "reset", 0.0f);
+
+    SimulatedHardware hardware;
+    hardware.Init(SAMPLE_RATE);
+    hardware.SetCvModel(64000.0f, 12000.0f, 60.0f);
+    hardware.SetAutomation(script);
+    hardware.Advance(0);
+    std::unique_ptr<PulsarFirmware<SimulatedHardware>> firmware(
+        new PulsarFirmware<SimulatedHardware>(hardware));
+    firmware->Init();
+    const VoctCalibration& calibration = firmware->GetCalibration();
+    bool pointsRead = hardware.GetSaveCount() == 1;
+    for (int v = 0; v < VoctCalibration::POINTS; ++v) {
+        pointsRead = pointsRead && calibration.Code(v) == hardware.CvCode(static_cast<float>(v));
+    }
+    check(pointsRead, "boot calibration reads the CV ADC");
+    worstCents = 0.0;
+    for (int step = 0; step <= 500; ++step) {
+        float volts = step * 0.01f;
+        worstCents = std::max(worstCents,
+                              1200.0 * std::fabs(calibration.Volts(hardware.CvCode(volts)) - volts));
+    }
+    check(worstCents < 1.0, "a bowed input tracks to a cent");
+
+    const uint64_t start = hardware.GetTimeNs();
+    SimulationOptions options;
+    options.duration = 0.8;
+    SimulationReport report;
+    std::vector<float> output;
+    Simulate(*firmware, hardware, options, report, &output);
+    uint32_t blocks = report.blocks;
+    double rms = 0.0;
+    for (size_t i = output.size() / 2; i < output.size(); ++i) {
+        rms += output[i] * output[i];
+    }
+    rms = std::sqrt(rms / (output.size() - output.size() / 2));
+    check(rms > 0.01, "audible output");
+    check(std::fabs(firmware->GetPanel().knobs[0] - 1.5f) < 1.0f / 1200.0f,
+          "V/Oct through the calibration");
+
+    // Nothing moves from about 3.8 s to 4.3 s
+    uint32_t publishes = firmware->GetPublishCount();
+    options.duration = 0.5;
+    Simulate(*firmware, hardware, options, report);
+    blocks += report.blocks;
+    check(firmware->GetPublishCount() == publishes, "a resting panel publishes nothing");
+    Simulate(*firmware, hardware, options, report);
+    blocks += report.blocks;
+    check(firmware->GetPublishCount() > publishes &&
+              std::fabs(firmware->GetPanel().knobs[1] - 0.6f) <= 0.002f,
+          "a moving panel publishes");
+
+    const LoadStats& stats = firmware->GetLoadMonitor().GetStats();
+    double seconds = (hardware.GetTimeNs() - start) * 1e-9;
+    check(blocks == 3600 && stats.blocks == blocks, "every callback timed");
+    check(std::fabs(firmware->GetControlTicks() / seconds - CONTROL_RATE) < CONTROL_RATE * 0.01 &&
+              std::fabs(firmware->GetLedTicks() / seconds - LED_RATE) < LED_RATE * 0.02,
+          "tasks at their rates");
+
+    // A tap only resets, and a held press with IN_R unpatched captures
+    // nothing worth playing
+    double now = hardware.GetTimeNs() * 1e-9;
+    at(now + 0.05, "tap", 1.0f);
+    at(now + 0.15, "tap", 0.0f);
+    at(now + 0.3, "tap", 1.0f);
+    at(now + 1.1, "tap", 0.0f);
+    options.duration = 1.4;
+    Simulate(*firmware, hardware, options, report);
+    check(firmware->GetCaptureCount() == 0, "a tap or a silent capture keeps the sound");
+
+    // The same press with a signal on IN_R captures it
+    now = hardware.GetTimeNs() * 1e-9;
+    at(now + 0.05, "tap", 1.0f);
+    at(now + 0.85, "tap", 0.0f);
+    options.duration = 1.0;
+    options.ringFrequency = 200.0f;
+    Simulate(*firmware, hardware, options, report);
+    check(firmware->GetCaptureCount() == 1, "a held press captures IN R");
+
+    // Holding on past the capture window shows the load instead
+    now = hardware.GetTimeNs() * 1e-9;
+    at(now + 0.05, "tap", 1.0f);
+    at(now + 2.6, "tap", 0.0f);
+    options.duration = 3.0;
+    Simulate(*firmware, hardware, options, report);
+    check(firmware->GetCaptureCount() == 1 && firmware->IsShowingLoad(),
+          "a long hold shows the load, not a capture");
+    return failures;
+}
+
+// Oversampler: Bypass against Process with a shaper that passes the
+// signal through, at each factor, and switching between them mid-stream.
+// Returns the number of failures.
+int RunOversampler() {
+    std::printf("\nOversampler\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // 1 kHz at 48 kHz, well inside the filters' passband
+    std::vector<float> input(4800);
+    for (size_t t = 0; t < input.size(); ++t) {
+        input[t] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * t / 48.0f);
+    }
+    auto unity = [](float*, size_t) {};
+
+    bool latencies = true;
+    float worstBypass = 0.0f;
+    float worstSwitch = 0.0f;
+    for (int factor : {2, 4}) {
+        Oversampler bypassed, processed, switched;
+        bypassed.Init(factor);
+        processed.Init(factor);
+        switched.Init(factor);
+        latencies = latencies && processed.Latency() == (factor == 2 ? 15 : 19);
+
+        std::vector<float> a(input), b(input), c(input);
+        for (size_t start = 0; start < input.size(); start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, input.size() - start);
+            bypassed.Bypass(a.data() + start, n);
+            processed.Process(b.data() + start, n, unity);
+            // Off, on, off and on again
+            if ((start / BLOCK_SIZE / 20) % 2 == 0) {
+                switched.Bypass(c.data() + start, n);
+            } else {
+                switched.Process(c.data() + start, n, unity);
+            }
+        }
+        for (size_t t = Oversampler::HISTORY; t < input.size(); ++t) {
+            worstBypass = std::max(worstBypass, std::fabs(a[t] - b[t]));
+            worstSwitch = std::max(worstSwitch, std::fabs(c[t] - b[t]));
+        }
+    }
+    std::printf("  bypass %.2e, switching %.2e from processed\n", worstBypass, worstSwitch);
+    check(latencies, "latency is 15 (2x) and 19 (4x) samples");
+    check(worstBypass < 1e-3f, "bypass lines up with processing");
+    check(worstSwitch < 1e-3f, "switching mid-stream is seamless");
+    return failures;
+}
+
+// LoadMonitor on a simulated 480 MHz clock at 96 kHz: 5000 cycles per
+// sample, 240000 per 48-sample block. Returns the number of failures.
+int RunLoadMonitor() {
+    std::printf("\nLoad monitor bookkeeping (simulated clock)\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    LoadMonitor<SimulatedClock> monitor;
+    monitor.Init(96000.0f, 480000000u);
+    SimulatedClock& clock = monitor.GetClock();
+    auto block = [&](uint32_t cycles, size_t size) {
+        monitor.BeginBlock();
+        clock.Advance(cycles);
+        monitor.EndBlock(size);
+        clock.Advance(1000);
+    };
+
+    check(monitor.GetStats().blocks == 0, "empty before the first block");
+
+    // 10%, 50%, 95%, exactly 100%, then two misses; the last straddles
+    // the counter wrapping
+    block(24000, 48);
+    block(120000, 48);
+    block(228000, 48);
+    block(240000, 48);
+    block(300000, 48);
+    clock.Set(0xFFFFFFFFu - 1000u);
+    block(480000, 48);
+
+    const LoadStats& stats = monitor.GetStats();
+    check(stats.blocks == 6, "block count");
+    check(stats.minCycles == 24000 && stats.maxCycles == 480000, "min and max cycles");
+    check(stats.totalCycles == 1392000 && stats.totalBudget == 6 * 240000ull,
+          "totals across the counter wrap");
+    check(stats.misses == 2, "deadline misses, exactly 100% is not one");
+    check(stats.histogram[1] == 1 && stats.histogram[5] == 1 && stats.histogram[9] == 2 &&
+              stats.histogram[LoadStats::HISTOGRAM_BINS - 1] == 2,
+          "histogram bins");
+    check(std::fabs(stats.AverageLoad() - 1392000.0f / 1440000.0f) < 1.0e-6f,
+          "average load");
+
+    // Varying block sizes keep their own budgets
+    monitor.Reset();
+    block(120000, 48);
+    block(120000, 24);
+    const LoadStats& resized = monitor.GetStats();
+    check(resized.blocks == 2 && resized.misses == 0 && resized.histogram[5] == 1 &&
+              resized.histogram[9] == 1,
+          "reset, and budgets follow the block size");
+
+    // The smoothed load settles on a steady load
+    for (int i = 0; i < 2000; ++i) {
+        block(72000, 48);
+    }
+    check(std::fabs(monitor.GetStats().load - 0.3f) < 1.0e-3f, "smoothed load");
+
+    // The host clock times a real render
+    LoadMonitor<HostClock> host;
+    host.Init(96000.0f, 1000000000u);
+    PulsarEngine engine;
+    float buffer[BLOCK_SIZE];
+    host.BeginBlock();
+    engine.ProcessBlock(buffer, BLOCK_SIZE);
+    host.EndBlock(BLOCK_SIZE);
+    check(host.GetStats().blocks == 1 && host.GetStats().maxCycles > 0, "host clock");
+    return failures;
+}
+
+// PulsarCloud's pool: overlap, capacity and the steal policies.
+// Returns the number of failures.
+int RunCloudPool() {
+    std::printf("\nCloud pool\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // Render block by block, tracking the most pulsarets at once
+    float buffer[BLOCK_SIZE];
+    auto render = [&buffer](PulsarCloud& cloud, size_t blocks) {
+        size_t most = 0;
+        for (size_t b = 0; b < blocks; ++b) {
+            cloud.Process(buffer, BLOCK_SIZE);
+            most = std::max(most, cloud.GetActiveCount());
+        }
+        return most;
+    };
+
+    // 960 Hz emissions of 240 Hz pulsarets: four at once, starting on
+    // exact samples
+    PulsarCloud cloud;
+    cloud.Init(SAMPLE_RATE, PulsarCloud::MAX_PULSARETS);
+    cloud.SetFrequency(960.0f);
+    cloud.SetFormantFrequency(240.0f);
+    check(render(cloud, 40) == 4, "overlap follows rate over pulsaret frequency");
+    check(cloud.GetStolenCount() == 0 && cloud.GetDroppedCount() == 0,
+          "nothing stolen with room to spare");
+
+    // Twelve would overlap in a pool of five
+    cloud.Init(SAMPLE_RATE, 5);
+    cloud.SetFrequency(1200.0f);
+    cloud.SetFormantFrequency(100.0f);
+    cloud.SetStealPolicy(StealPolicy::NONE);
+    size_t most = render(cloud, 40);
+    check(most == 5 && cloud.GetDroppedCount() > 0 && cloud.GetStolenCount() == 0,
+          "NONE drops what does not fit");
+
+    cloud.Init(SAMPLE_RATE, 5);
+    cloud.SetFrequency(1200.0f);
+    cloud.SetFormantFrequency(100.0f);
+    most = render(cloud, 40);
+    check(most == 5 && cloud.GetStolenCount() > 0 && cloud.GetDroppedCount() == 0,
+          "OLDEST steals within the capacity");
+
+    cloud.SetCapacity(2);
+    check(cloud.GetActiveCount() <= 2, "shrinking the pool stops the excess");
+
+    // Silent when everything is masked
+    cloud.Init(SAMPLE_RATE, PulsarCloud::MAX_PULSARETS);
+    cloud.SetMaskingMode(MaskingMode::STOCHASTIC);
+    cloud.SetMaskingProbability(0.0f);
+    render(cloud, 10);
+    check(cloud.GetActiveCount() == 0 && buffer[0] == 0.0f, "masked emissions take no slot");
+    return failures;
+}
+
+// SampledPulsaret's mipmap levels and MappedWav loading. Returns the
+// number of failures.
+int RunSampledPulsaret() {
+    std::printf("\nSampled pulsaret\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // 1000 samples halve to 501, 251, 126, 64, 33, 17, 9, 5, each
+    // reaching the source's last sample
+    const size_t length = 1000;
+    check(SampledPulsaret::MipmapSize(length) == 1006, "mipmap size sums the halved levels");
+
+    std::vector<float> dc(length, 0.5f);
+    std::vector<float> mipmaps(SampledPulsaret::MipmapSize(length));
+    SampledPulsaret sample;
+    check(!sample.Init(dc.data(), length, mipmaps.data(), mipmaps.size() - 1) &&
+              sample.IsEmpty(),
+          "too little mipmap storage is refused");
+    check(sample.Init(dc.data(), length, mipmaps.data(), mipmaps.size()) &&
+              sample.GetLevelCount() == 9 && sample.GetLength(8) == 5 &&
+              sample.GetLevel(0) == dc.data(),
+          "levels halve down to MIN_LEVEL_LENGTH");
+
+    // Away from the ends, DC passes and Nyquist is stopped
+    bool dcKept = true;
+    for (size_t i = 16; i + 16 < sample.GetLength(1); ++i) {
+        dcKept = dcKept && std::fabs(sample.GetLevel(1)[i] - 0.5f) < 1e-3f;
+    }
+    check(dcKept, "decimation keeps DC");
+    std::vector<float> nyquist(length);
+    for (size_t i = 0; i < length; ++i) {
+        nyquist[i] = (i & 1) ? -1.0f : 1.0f;
+    }
+    sample.Init(nyquist.data(), length, mipmaps.data(), mipmaps.size());
+    float peak = 0.0f;
+    for (size_t i = 16; i + 16 < sample.GetLength(1); ++i) {
+        peak = std::max(peak, std::fabs(sample.GetLevel(1)[i]));
+    }
+    check(peak < 1e-3f, "decimation rejects Nyquist");
+
+    // One source sample per output sample reads level 0; each doubling
+    // moves a level up
+    const float unit = 1.0f / static_cast<float>(length - 1);
+    SampledPulsaret::Reader reader = sample.Select(unit);
+    check(reader.levelA == sample.GetLevel(0) && reader.blend == 0.0f,
+          "unit step reads level 0");
+    reader = sample.Select(4.0f * unit);
+    check(reader.levelA == sample.GetLevel(2) && reader.blend < 1e-4f,
+          "four times the step reads level 2");
+    reader = sample.Select(6.0f * unit);
+    check(reader.levelA == sample.GetLevel(2) && reader.levelB == sample.GetLevel(3) &&
+              reader.blend > 0.5f && reader.blend < 0.6f,
+          "steps between octaves crossfade levels");
+    reader = sample.Select(1.0f);
+    check(reader.levelA == sample.GetLevel(8) && reader.blend == 0.0f,
+          "steps past the mipmap stay on the last level");
+
+    // Every level plays the whole source in step: one slow cycle, read
+    // away from the ends where the filters see the silence outside
+    std::vector<float> cycle(length);
+    for (size_t i = 0; i < length; ++i) {
+        cycle[i] = std::sin(6.2831853f * static_cast<float>(i) * unit);
+    }
+    sample.Init(cycle.data(), length, mipmaps.data(), mipmaps.size());
+    float drift = 0.0f;
+    for (int level = 1; level <= 3; ++level) {
+        reader = sample.Select(static_cast<float>(1 << level) * unit);
+        bool inside = reader.lastA + 1 >= static_cast<size_t>(reader.scaleA);
+        for (float phase = 0.1f; phase < 0.9f; phase += 0.01f) {
+            float expected = std::sin(6.2831853f * phase);
+            drift = std::max(drift, inside ? std::fabs(reader(phase) - expected) : 1.0f);
+        }
+    }
+    check(drift < 2e-3f, "levels line up with the source");
+
+    // Float mono is read where it is mapped; PCM is converted
+    const char* tmp = std::getenv("TMPDIR");
+    std::string dir = (tmp != nullptr) ? tmp : "/tmp";
+    std::vector<float> ramp(length);
+    for (size_t i = 0; i < length; ++i) {
+        ramp[i] = static_cast<float>(i) * unit * 2.0f - 1.0f;
+    }
+    std::string error;
+    std::string floatPath = dir + "/pulsar_test_f32.wav";
+    std::string pcmPath = dir + "/pulsar_test_s16.wav";
+    bool written = WriteWav(floatPath, ramp.data(), length, 1, 48000, WavFormat::FLOAT32,
+                            error) &&
+                   WriteWav(pcmPath, ramp.data(), length, 1, 48000, WavFormat::PCM16,
+                            error);
+    MappedWav wav;
+    bool same = written && wav.Open(floatPath, error) && wav.GetLength() == length &&
+                wav.GetSampleRate() == 48000 &&
+                std::memcmp(wav.GetSamples(), ramp.data(), length * sizeof(float)) == 0;
+    check(same && wav.IsInPlace(), "float32 mono is mapped in place");
+    float worst = 1.0f;
+    if (written && wav.Open(pcmPath, error) && wav.GetLength() == length) {
+        worst = 0.0f;
+        for (size_t i = 0; i < length; ++i) {
+            worst = std::max(worst, std::fabs(wav.GetSamples()[i] - ramp[i]));
+        }
+    }
+    check(!wav.IsInPlace() && worst <= 1.0f / 32768.0f, "PCM16 is converted");
+    wav.Close();
+    std::remove(floatPath.c_str());
+    std::remove(pcmPath.c_str());
+    return failures;
+}
+
+// Convolver against direct convolution, delayed by its latency, for
+// several partition sizes, impulse response lengths and call sizes.
+// Returns the number of failures.
+int RunConvolver() {
+    std::printf("\nConvolver\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    uint32_t seed = 1;
+    auto noise = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+    };
+    std::vector<float> input(4000);
+    for (float& x : input) {
+        x = noise();
+    }
+
+    const size_t maxPartitions = 8;
+    float worst = 0.0f;
+    bool latencies = true;
+    for (size_t partition : {16, 64, 256}) {
+        for (size_t length : {1, 37, 1000, 4000}) {
+            for (size_t call : {1, 48, 1000}) {
+                std::vector<float> ir(length);
+                for (float& h : ir) {
+                    h = noise();
+                }
+                std::vector<float> memory(Convolver::MemorySize(partition, maxPartitions));
+                Convolver convolver;
+                convolver.Init(partition, maxPartitions, memory.data(), memory.size());
+                convolver.SetImpulseResponse(ir.data(), length);
+                latencies = latencies && convolver.GetLatency() == partition;
+
+                std::vector<float> output(input.size());
+                for (size_t start = 0; start < input.size(); start += call) {
+                    size_t n = std::min(call, input.size() - start);
+                    convolver.Process(input.data() + start, output.data() + start, n);
+                }
+
+                // Partitions past maxPartitions are dropped
+                const size_t used = std::min(length, partition * maxPartitions);
+                for (size_t t = 0; t < input.size(); ++t) {
+                    double expected = 0.0;
+                    for (size_t k = 0; k < used && k + partition <= t; ++k) {
+                        expected += static_cast<double>(ir[k]) * input[t - partition - k];
+                    }
+                    worst = std::max(worst, static_cast<float>(std::fabs(expected - output[t])));
+                }
+            }
+        }
+    }
+    check(worst < 1e-5f, "matches direct convolution");
+    check(latencies, "latency is one partition");
+
+    std::vector<float> memory(Convolver::MemorySize(64, 4));
+    Convolver convolver;
+    check(!convolver.Init(48, 4, memory.data(), memory.size()) &&
+              !convolver.Init(64, 4, memory.data(), memory.size() - 1),
+          "bad partition size or memory is refused");
+
+    // A new impulse response waits for the next block; another is
+    // refused until then
+    convolver.Init(64, 4, memory.data(), memory.size());
+    const float unit = 1.0f;
+    const float half = 0.5f;
+    float buffer[64] = {1.0f};
+    check(convolver.GetPartitionCount() == 0, "silent without an impulse response");
+    bool first = convolver.SetImpulseResponse(&unit, 1);
+    bool second = convolver.SetImpulseResponse(&half, 1);
+    convolver.Process(buffer, buffer, 64);
+    check(first && !second && convolver.GetPartitionCount() == 1 &&
+              convolver.SetImpulseResponse(&half, 1),
+          "impulse responses swap at block boundaries");
+    return failures;
+}
+
+// Multichannel output: layouts, the centre, and pulsar placement
+// through the fold delay. Returns the number of failures.
+int RunSpatial() {
+    std::printf("\nSpatial output\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    const size_t FRAMES = 9600;
+    auto setup = [](PulsarEngine& engine, SpatialMode mode, float spread) {
+        InitEngine(engine);
+        engine.SetFrequency(700.0f);
+        // Pulsarets end within the fold delay of the next pulsar
+        engine.SetFormantRatio(0.9f);
+        engine.SetFoldOversampling(2);
+        engine.SetFoldMode(FoldMode::ADAA);
+        engine.SetFold(0.2f);
+        engine.SetSpatialMode(mode);
+        engine.SetSpread(spread);
+    };
+
+    // Reference mono train
+    PulsarEngine engine;
+    setup(engine, SpatialMode::ALTERNATE, 0.0f);
+    std::vector<float> mono(FRAMES);
+    RenderBlocks(engine, mono.data(), FRAMES);
+
+    // Interleaved and planar, block by block
+    auto interleaved = [&](size_t channels, SpatialMode mode, float spread) {
+        PulsarEngine e;
+        setup(e, mode, spread);
+        std::vector<float> frames(FRAMES * channels);
+        for (size_t start = 0; start < FRAMES; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, FRAMES - start);
+            e.ProcessBlock(nullptr, nullptr,
+                           PulsarOutput::Interleaved(frames.data() + start * channels, channels),
+                           n);
+        }
+        return frames;
+    };
+    auto planar = [&](size_t channels, SpatialMode mode, float spread) {
+        PulsarEngine e;
+        setup(e, mode, spread);
+        std::vector<std::vector<float>> buffers(channels, std::vector<float>(FRAMES));
+        for (size_t start = 0; start < FRAMES; start += BLOCK_SIZE) {
+            size_t n = std::min(BLOCK_SIZE, FRAMES - start);
+            float* pointers[PulsarOutput::MAX_CHANNELS];
+            for (size_t c = 0; c < channels; ++c) {
+                pointers[c] = buffers[c].data() + start;
+            }
+            e.ProcessBlock(nullptr, nullptr, PulsarOutput::Planar(pointers, channels), n);
+        }
+        return buffers;
+    };
+
+    std::vector<float> centre = interleaved(2, SpatialMode::SCATTER, 0.0f);
+    bool copies = true;
+    for (size_t i = 0; i < FRAMES; ++i) {
+        copies = copies && centre[2 * i] == centre[2 * i + 1] &&
+                 std::fabs(centre[2 * i] - mono[i] * 0.70710678f) < 1e-6f;
+    }
+    check(copies, "stereo at no spread is the train 3 dB down in each");
+
+    bool same = true;
+    for (SpatialMode mode : {SpatialMode::ALTERNATE, SpatialMode::SCATTER}) {
+        std::vector<float> frames = interleaved(3, mode, 0.7f);
+        std::vector<std::vector<float>> buffers = planar(3, mode, 0.7f);
+        for (size_t i = 0; i < FRAMES; ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                same = same && frames[3 * i + c] == buffers[c][i];
+            }
+        }
+    }
+    check(same, "planar and interleaved agree");
+
+    // Hard alternation puts each pulsar, fold tail and all, in one
+    // channel: the channels add up to the train, and hand over to each
+    // other where it is near silent, not where the undelayed pulsar
+    // starts
+    std::vector<std::vector<float>> sides = planar(2, SpatialMode::ALTERNATE, 1.0f);
+    bool sums = true;
+    float handover = 0.0f;
+    for (size_t i = 1; i < FRAMES; ++i) {
+        sums = sums && sides[0][i] + sides[1][i] == mono[i];
+        for (size_t c = 0; c < 2; ++c) {
+            if (sides[c][i] == 0.0f && sides[c][i - 1] != 0.0f) {
+                handover = std::max(handover, std::fabs(mono[i]));
+            }
+        }
+    }
+    check(sums && handover < 0.03f, "alternate pulsars land in one channel each");
+
+    // Scattered pulsars move, but keep their power
+    std::vector<float> scattered = interleaved(2, SpatialMode::SCATTER, 1.0f);
+    bool moved = false;
+    bool constant = true;
+    for (size_t i = 0; i < FRAMES; ++i) {
+        float left = scattered[2 * i];
+        float right = scattered[2 * i + 1];
+        moved = moved || std::fabs(std::fabs(left) - std::fabs(right)) > 1e-3f;
+        constant = constant && std::fabs(left * left + right * right - mono[i] * mono[i]) <=
+                                   1e-5f * std::max(1.0f, mono[i] * mono[i]);
+    }
+    check(moved && constant, "scattered pulsars pan at constant power");
+
+    // Blocks shorter than the fold delay, so that a block can end
+    // before the first pulsar reaches the output, still hand over
+    // between pulsars
+    bool small = true;
+    for (int factor : {2, 4}) {
+        for (size_t block : {1, 2, 7, 16}) {
+            PulsarEngine e, reference;
+            setup(e, SpatialMode::ALTERNATE, 1.0f);
+            setup(reference, SpatialMode::ALTERNATE, 1.0f);
+            e.SetFoldOversampling(factor);
+            reference.SetFoldOversampling(factor);
+            std::vector<float> frames(FRAMES * 2);
+            std::vector<float> train(FRAMES);
+            for (size_t start = 0; start < FRAMES; start += block) {
+                size_t n = std::min(block, FRAMES - start);
+                e.ProcessBlock(nullptr, nullptr,
+                               PulsarOutput::Interleaved(frames.data() + start * 2, 2), n);
+                reference.ProcessBlock(train.data() + start, n);
+            }
+            float worst = 0.0f;
+            for (size_t i = 1; i < FRAMES; ++i) {
+                small = small && frames[2 * i] + frames[2 * i + 1] == train[i] &&
+                        (frames[2 * i] == 0.0f || frames[2 * i + 1] == 0.0f);
+                for (size_t c = 0; c < 2; ++c) {
+                    if (frames[2 * i + c] == 0.0f && frames[2 * (i - 1) + c] != 0.0f) {
+                        worst = std::max(worst, std::fabs(train[i]));
+                    }
+                }
+            }
+            small = small && worst < 0.03f;
+        }
+    }
+    check(small, "placement holds in blocks of 1 to 16");
+    return failures;
+}
+
+// Hard sync from an input: crossings found wherever they fall in the
+// block, sub-sample timing, and the band-limited sync step. Returns the
+// number of failures.
+int RunSync() {
+    std::printf("\nHard sync\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    // A ramp through zero at c restarts the phase there, so a block
+    // later the phase is (BLOCK_SIZE - c) increments, for crossings on
+    // the first sample (found from the previous block), on vector
+    // boundaries and in between
+    const float increment = 220.0f / SAMPLE_RATE;
+    const float crossings[] = {-0.75f, -0.25f, 0.3f, 3.5f, 7.9f, 8.1f, 23.6f, 46.5f};
+    float worst = 0.0f;
+    for (float c : crossings) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        float sync[2 * BLOCK_SIZE];
+        float out[BLOCK_SIZE];
+        for (size_t i = 0; i < 2 * BLOCK_SIZE; ++i) {
+            sync[i] = static_cast<float>(i) - static_cast<float>(BLOCK_SIZE) - c;
+        }
+        engine.ProcessBlock(sync, nullptr, out, nullptr, BLOCK_SIZE);
+        engine.ProcessBlock(sync + BLOCK_SIZE, nullptr, out, nullptr, BLOCK_SIZE);
+        float expected = (static_cast<float>(BLOCK_SIZE) - c) * increment;
+        worst = std::max(worst, std::fabs(engine.GetPhase() - expected));
+    }
+    check(worst < 1e-5f, "phase restarts between samples");
+
+    // The same crossings, found in blocks of any size once a sync has
+    // lined up the phases the first block's frequency ramp left
+    const size_t FRAMES = 4800;
+    std::vector<float> input(FRAMES);
+    for (size_t i = 0; i < FRAMES; ++i) {
+        float t = static_cast<float>(i) / SAMPLE_RATE;
+        input[i] = sinf(2.0f * static_cast<float>(M_PI) * 1234.5f * t) +
+                   0.3f * sinf(2.0f * static_cast<float>(M_PI) * 9876.0f * t);
+    }
+    auto render = [&](size_t blockSize, EdgeMode edges) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFrequency(3000.0f);
+        engine.SetEdgeMode(edges);
+        std::vector<float> out(FRAMES);
+        for (size_t start = 0; start < FRAMES; start += blockSize) {
+            size_t n = std::min(blockSize, FRAMES - start);
+            engine.ProcessBlock(input.data() + start, nullptr, out.data() + start,
+                                nullptr, n);
+        }
+        return out;
+    };
+    bool matches = true;
+    for (EdgeMode edges : {EdgeMode::SMOOTHED, EdgeMode::BAND_LIMITED}) {
+        std::vector<float> reference = render(BLOCK_SIZE, edges);
+        for (size_t blockSize : {size_t(1), size_t(7), size_t(64)}) {
+            std::vector<float> out = render(blockSize, edges);
+            for (size_t i = 256; i < FRAMES; ++i) {
+                // A crossing on a block's first sample has no earlier
+                // sample left to correct
+                bool uncorrected = edges == EdgeMode::BAND_LIMITED &&
+                                   ((i + 1) % blockSize == 0 || (i + 1) % BLOCK_SIZE == 0) &&
+                                   i + 1 < FRAMES && input[i] <= 0.0f && input[i + 1] > 0.0f;
+                matches = matches && (uncorrected || std::fabs(out[i] - reference[i]) < 1e-3f);
+            }
+        }
+    }
+    check(matches, "crossings found in any block size");
+
+    // Sync every 38.4 samples repeats every 192: harmonics of the sync
+    // rate land on every fifth bin of a 192-point DFT and aliases mostly
+    // between them
+    const size_t PERIOD = 192;
+    auto aliasing = [&](EdgeMode edges) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetFormantRatio(1.0f);
+        engine.SetEnvelopeMorph(0.0f);
+        engine.SetEdgeMode(edges);
+        std::vector<float> sync(FRAMES);
+        std::vector<float> out(FRAMES);
+        for (size_t i = 0; i < FRAMES; ++i) {
+            sync[i] = sinf(2.0f * static_cast<float>(M_PI) * static_cast<float>(i) / 38.4f);
+        }
+        for (size_t start = 0; start < FRAMES; start += BLOCK_SIZE) {
+            engine.ProcessBlock(sync.data() + start, nullptr, out.data() + start, nullptr,
+                                BLOCK_SIZE);
+        }
+        const float* x = out.data() + FRAMES - PERIOD;
+        double harmonic = 0.0;
+        double other = 0.0;
+        for (size_t k = 1; k <= PERIOD / 2; ++k) {
+            double re = 0.0;
+            double im = 0.0;
+            for (size_t n = 0; n < PERIOD; ++n) {
+                double w = 2.0 * M_PI * static_cast<double>(k * n) / PERIOD;
+                re += x[n] * std::cos(w);
+                im -= x[n] * std::sin(w);
+            }
+            (k % 5 == 0 ? harmonic : other) += re * re + im * im;
+        }
+        return other / harmonic;
+    };
+    double smoothed = aliasing(EdgeMode::SMOOTHED);
+    double bandLimited = aliasing(EdgeMode::BAND_LIMITED);
+    std::printf("  sync aliasing: naive %.2e, band-limited %.2e\n", smoothed, bandLimited);
+    check(bandLimited < 0.25 * smoothed, "band-limited sync step aliases less");
+    return failures;
+}
+
+// Silent stretches skipped in bulk against the per-sample renderer, at
+// several block sizes once the first block's ramps have settled, and
+// with ramps every block. Returns the number of failures.
+int RunSparse() {
+    std::printf("\nSparse rendering\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    struct Case {
+        const char* name;
+        std::function<void(PulsarEngine&)> setup;
+    };
+    const Case cases[] = {
+        {"default", [](PulsarEngine&) {}},
+        {"LFO rate", [](PulsarEngine& e) {
+             e.SetFrequency(3.0f);
+             e.SetFormantRatio(0.05f);
+         }},
+        {"burst masking", [](PulsarEngine& e) {
+             e.SetFrequency(440.0f);
+             e.SetFormantRatio(0.2f);
+             e.SetEdgeMode(EdgeMode::BAND_LIMITED);
+             e.SetMaskingMode(MaskingMode::BURST);
+             e.SetBurstRatio(1, 7);
+         }},
+        {"masked noise", [](PulsarEngine& e) {
+             e.SetWaveformMorph(6.0f);
+             e.SetMaskingMode(MaskingMode::STOCHASTIC);
+             e.SetMaskingProbability(0.5f);
+         }},
+        {"masked inline fold", [](PulsarEngine& e) {
+             e.SetFrequency(110.0f);
+             e.SetFormantRatio(0.1f);
+             e.SetMaskingMode(MaskingMode::STOCHASTIC);
+             e.SetMaskingProbability(0.25f);
+             e.SetFold(0.5f);
+         }},
+    };
+
+    // Two seconds after a first block, rendered per sample or sparsely,
+    // with the frequency stepped every block if sweep is set
+    const size_t length = 2 * static_cast<size_t>(SAMPLE_RATE);
+    auto render = [length](const Case& c, size_t blockSize, bool dense, bool sweep,
+                           std::vector<float>& out) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        c.setup(engine);
+        float first[BLOCK_SIZE];
+        engine.ProcessBlock(first, BLOCK_SIZE);
+        const PulsarModulation none;
+        out.assign(length, 0.0f);
+        for (size_t start = 0; start < length; start += blockSize) {
+            size_t n = std::min(blockSize, length - start);
+            if (sweep) {
+                engine.SetFrequency(20.0f + 0.002f * static_cast<float>(start));
+            }
+            if (dense) {
+                engine.ProcessBlock(none, out.data() + start, n);
+            } else {
+                engine.ProcessBlock(out.data() + start, n);
+            }
+        }
+    };
+
+    std::vector<float> dense;
+    std::vector<float> sparse;
+    for (const Case& c : cases) {
+        render(c, BLOCK_SIZE, true, false, dense);
+        bool same = true;
+        for (size_t blockSize : {static_cast<size_t>(1), static_cast<size_t>(37), BLOCK_SIZE,
+                                 static_cast<size_t>(512)}) {
+            render(c, blockSize, false, false, sparse);
+            same = same && sparse == dense;
+        }
+        render(c, BLOCK_SIZE, true, true, dense);
+        render(c, BLOCK_SIZE, false, true, sparse);
+        same = same && sparse == dense;
+
+        char label[64];
+        std::snprintf(label, sizeof(label), "bit for bit: %s", c.name);
+        check(same, label);
+    }
+    return failures;
+}
+
+// Random.hpp streams: block fill and skip-ahead against single draws,
+// statistics, and block-size independence of the engine's noise.
+// Returns the number of failures.
+int RunRandom() {
+    std::printf("\nRandom streams\n");
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        std::printf("  %-46s %s\n", what, ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    const size_t COUNT = 1 << 16;
+    RandomStream stream;
+    stream.Seed(rng::DEFAULT_SEED, rng::NOISE);
+    std::vector<float> draws(COUNT);
+    for (float& x : draws) {
+        x = stream.NextBipolar();
+    }
+
+    // Odd sizes leave a scalar tail after the simd lanes
+    RandomStream filled;
+    filled.Seed(rng::DEFAULT_SEED, rng::NOISE);
+    std::vector<float> block(COUNT);
+    size_t done = 0;
+    for (size_t size = 1; done < COUNT; size = size * 3 + 1) {
+        size_t n = std::min(size, COUNT - done);
+        filled.FillBipolar(block.data() + done, n);
+        done += n;
+    }
+    check(block == draws && filled.GetPosition() == stream.GetPosition(),
+          "block fill matches single draws");
+
+    RandomStream skipped;
+    skipped.Seed(rng::DEFAULT_SEED, rng::NOISE);
+    bool skips = true;
+    for (size_t at : {0, 1, 7, 1000, 65535}) {
+        skipped.SetPosition(0);
+        skipped.Skip(static_cast<uint32_t>(at));
+        skips = skips && skipped.PeekBipolar(0) == draws[at] &&
+                skipped.NextBipolar() == draws[at];
+    }
+    check(skips, "skip-ahead lands on the same draw");
+
+    // Uniform on [0, 1): mean 1/2, variance 1/12
+    RandomStream unit;
+    unit.Seed(rng::DEFAULT_SEED, rng::MASKING);
+    double sum = 0.0;
+    double squares = 0.0;
+    bool inRange = true;
+    for (size_t i = 0; i < COUNT; ++i) {
+        double x = unit.Next();
+        inRange = inRange && x >= 0.0 && x < 1.0;
+        sum += x;
+        squares += x * x;
+    }
+    double mean = sum / COUNT;
+    double variance = squares / COUNT - mean * mean;
+    check(inRange && std::fabs(mean - 0.5) < 0.005 &&
+              std::fabs(variance - 1.0 / 12.0) < 0.002,
+          "uniform mean and variance");
+
+    // Streams that differ by one id or one voice, against each other
+    // and against themselves one draw later
+    auto correlation = [&draws, COUNT](uint32_t streamId, size_t lag) {
+        RandomStream other;
+        other.Seed(rng::DEFAULT_SEED, streamId);
+        other.Skip(static_cast<uint32_t>(lag));
+        double product = 0.0;
+        for (size_t i = 0; i < COUNT; ++i) {
+            product += static_cast<double>(draws[i]) * other.NextBipolar();
+        }
+        // Bipolar uniform draws have variance 1/3
+        return std::fabs(product / COUNT * 3.0);
+    };
+    float worst = 0.0f;
+    for (uint32_t id : {rng::MASKING, rng::JITTER, rng::NOISE | (1u << rng::VOICE_SHIFT)}) {
+        worst = std::max(worst, static_cast<float>(correlation(id, 0)));
+    }
+    worst = std::max(worst, static_cast<float>(correlation(rng::NOISE, 1)));
+    char label[64];
+    std::snprintf(label, sizeof(label), "streams uncorrelated (worst %.4f)", worst);
+    check(worst < 0.02f, label);
+
+    // Noise is indexed by output sample, so other block sizes leave two
+    // seconds of masked noise exactly as they were
+    auto renderNoise = [](size_t blockSize, uint32_t seed, std::vector<float>& out) {
+        PulsarEngine engine;
+        InitEngine(engine);
+        engine.SetWaveformMorph(6.0f);
+        engine.SetMaskingMode(MaskingMode::STOCHASTIC);
+        engine.SetMaskingProbability(0.5f);
+        engine.SetRandomSeed(seed);
+        for (size_t start = 0; start < out.size(); start += blockSize) {
+            engine.ProcessBlock(out.data() + start, std::min(blockSize, out.size() - start));
+        }
+    };
+    std::vector<float> blocks(2 * static_cast<size_t>(SAMPLE_RATE));
+    std::vector<float> odd(blocks.size());
+    std::vector<float> reseeded(blocks.size());
+    renderNoise(BLOCK_SIZE, 7, blocks);
+    renderNoise(7, 7, odd);
+    renderNoise(BLOCK_SIZE, 8, reseeded);
+    check(blocks == odd, "engine noise stays put across block sizes");
+    check(blocks != reseeded, "engine seed changes the noise");
+    return failures;
+}
+
+// FastMath.hpp against double precision at every FAST_MATH_STRIDE'th
+// float bit pattern, each function over its whole domain. Returns the
+// number of failures.
+constexpr uint32_t FAST_MATH_STRIDE = 251;
+
+int RunFastMath() {
+    std::printf("\nFast math accuracy (one float in %u)\n", FAST_MATH_STRIDE);
+    int failures = 0;
+    auto check = [&failures](const char* what, double error, float bound) {
+        bool ok = error <= bound;
+        std::printf("  %-20s max error %.3g, bound %.3g  %s\n", what, error, bound,
+                    ok ? "ok" : "FAIL");
+        failures += ok ? 0 : 1;
+    };
+
+    double sinError = 0.0;
+    double exp2Error = 0.0;
+    double expError = 0.0;
+
+    // The simd versions run over the same inputs a vector at a time
+    // and must match the scalar ones bit for bit
+    alignas(32) float lanes[simd::WIDTH];
+    alignas(32) float scalar[3][simd::WIDTH];
+    size_t lane = 0;
+    int mismatches = 0;
+
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFFull; bits += FAST_MATH_STRIDE) {
+        uint32_t pattern = static_cast<uint32_t>(bits);
+        float x;
+        std::memcpy(&x, &pattern, sizeof(x));
+        if (!std::isfinite(x)) {
+            continue;
+        }
+        double xd = x;
+        float sin2Pi = fastmath::FastSin2Pi(x);
+        float exp2 = fastmath::FastExp2(x);
+        float exp = fastmath::FastExp(x);
+
+        // Whole cycles dropped exactly before going to radians
+        double sinRef = std::sin(2.0 * M_PI * (xd - std::floor(xd)));
+        sinError = std::max(sinError, std::fabs(sin2Pi - sinRef));
+
+        if (x >= -126.0f && x <= 127.0f) {
+            double ref = std::exp2(xd);
+            exp2Error = std::max(exp2Error, std::fabs(exp2 - ref) / ref);
+        }
+        if (x >= -87.0f && x <= 88.0f) {
+            double ref = std::exp(xd);
+            expError = std::max(expError, std::fabs(exp - ref) / ref);
+        }
+
+        lanes[lane] = x;
+        scalar[0][lane] = sin2Pi;
+        scalar[1][lane] = exp2;
+        scalar[2][lane] = exp;
+        if (++lane == simd::WIDTH) {
+            alignas(32) float vector[3][simd::WIDTH];
+            simd::Float in = simd::Load(lanes);
+            simd::Store(vector[0], fastmath::FastSin2Pi(in));
+            simd::Store(vector[1], fastmath::FastExp2(in));
+            simd::Store(vector[2], fastmath::FastExp(in));
+            mismatches += std::memcmp(vector, scalar, sizeof(vector)) != 0 ? 1 : 0;
+            lane = 0;
+        }
+    }
+    check("sin(2 pi x)", sinError, fastmath::SIN_MAX_ERROR);
+    check("2^x (relative)", exp2Error, fastmath::EXP2_MAX_ERROR);
+    check("e^x (relative)", expError, fastmath::EXP_MAX_ERROR);
+    std::printf("  %-46s %s\n", "simd versions match the scalar ones",
+                mismatches == 0 ? "ok" : "FAIL");
+    failures += mismatches == 0 ? 0 : 1;
+
+    // Exact where the shapes need it, saturating outside the domain
+    bool exact = fastmath::FastExp(0.0f) == 1.0f && fastmath::FastExp2(0.0f) == 1.0f &&
+                 fastmath::FastSin2Pi(0.0f) == 0.0f && fastmath::FastSin2Pi(0.5f) == 0.0f &&
+                 fastmath::FastSin2Pi(1.0f) == 0.0f;
+    std::printf("  %-46s %s\n", "exact at 0 and half cycles", exact ? "ok" : "FAIL");
+    failures += exact ? 0 : 1;
+    bool saturates = fastmath::FastExp2(1000.0f) == fastmath::FastExp2(127.0f) &&
+                     fastmath::FastExp2(-1000.0f) == fastmath::FastExp2(-126.0f) &&
+                     fastmath::FastExp(-1000.0f) == fastmath::FastExp(-87.0f) &&
+                     std::isfinite(fastmath::FastExp(1000.0f));
+    std::printf("  %-46s %s\n", "saturates outside the domain", saturates ? "ok" : "FAIL");
+    failures += saturates ? 0 : 1;
+    return failures;
+}
+
+void PrintUsage(const char* argv0) {
+    std::printf("usage: %s [--golden FILE] [--perf FILE] [--update-golden]"
+                " [--update-perf] [--no-perf] [--exact] [--threshold PCT]"
+                " [--repeat N] [--filter TEXT]\n"
+                "  --golden FILE    golden outputs (default tests/golden.txt)\n"
+                "  --perf FILE      ns/sample baselines (default tests/perf_baseline.txt)\n"
+                "  --update-golden  rewrite the golden file from this build\n"
+                "  --update-perf    rewrite the baselines from this machine\n"
+                "  --no-perf        skip the timing checks\n"
+                "  --exact          require bit-identical output\n"
+                "  --threshold PCT  allowed slowdown (default 25)\n"
+                "  --repeat N       timing runs per scenario (default 7)\n"
+                "  --filter TEXT    only scenarios whose name contains TEXT\n",
+                argv0);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--golden") && i + 1 < argc) {
+            options.goldenPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--perf") && i + 1 < argc) {
+            options.perfPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--update-golden")) {
+            options.updateGolden = true;
+        } else if (!std::strcmp(argv[i], "--update-perf")) {
+            options.updatePerf = true;
+        } else if (!std::strcmp(argv[i], "--no-perf")) {
+            options.runPerf = false;
+        } else if (!std::strcmp(argv[i], "--exact")) {
+            options.exact = true;
+        } else if (!std::strcmp(argv[i], "--threshold") && i + 1 < argc) {
+            options.threshold = std::atof(argv[++i]) / 100.0;
+        } else if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            options.repeats = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (options.repeats < 1 || options.threshold < 0.0 ||
+        (options.filter != nullptr && (options.updateGolden || options.updatePerf))) {
+        PrintUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Scenario> scenarios = BuildScenarios();
+    if (options.filter != nullptr) {
+        scenarios.erase(std::remove_if(scenarios.begin(), scenarios.end(),
+                                       [&](const Scenario& s) {
+                                           return s.name.find(options.filter) ==
+                                                  std::string::npos;
+                                       }),
+                        scenarios.end());
+    }
+
+    int failures = RunGolden(options, scenarios);
+    failures += RunOversampler();
+    failures += RunLoadMonitor();
+    failures += RunControlTask();
+    failures += RunFirmware();
+    failures += RunCloudPool();
+    failures += RunSampledPulsaret();
+    failures += RunConvolver();
+    failures += RunSpatial();
+    failures += RunSync();
+    failures += RunSparse();
+    failures += RunRandom();
+    failures += RunFastMath();
+    if (options.runPerf) {
+        failures += RunPerf(options, scenarios);
+    }
+
+    std::printf("\n%s: %d failure%s\n", failures == 0 ? "PASS" : "FAIL", failures,
+                failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}